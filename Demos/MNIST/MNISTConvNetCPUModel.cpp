@@ -195,12 +195,9 @@ void MNIST::trainConvolutionalModelWithModelClass()
             emit updateCost(overallCost / (float) (batchSize*deviceCount));
             overallCost = 0.0;
 
+            //the fully connected gradients are overwritten by backward
             model->clearTensor(softmaxGrad );
             model->clearTensor(fullyConnected1OutputGrad );
-            model->clearTensor(fullyConnected2WeightGrad );
-            model->clearTensor(fullyConnected1WeightGrad );
-            model->clearTensor(fullyConnected1BiasGrad );
-            model->clearTensor(fullyConnected2BiasGrad );
             model->clearTensor(poolingOutputGrad );
             model->clearTensor(convOutputGrad );
             model->clearTensor(convBiasGrad );
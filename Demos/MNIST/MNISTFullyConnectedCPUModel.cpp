@@ -6,6 +6,8 @@
 #include "Context/Context.h"
 
 #include <chrono>
+#include <vector>
+#include <algorithm>
 
 void MNIST::trainFullyConnectedModelWithModelClass()
 {
@@ -99,20 +101,44 @@ void MNIST::trainFullyConnectedModelWithModelClass()
         auto startTime = std::chrono::steady_clock::now();
         std::chrono::duration<double, std::nano> forwardTime = std::chrono::duration<double, std::nano>::zero();
         std::chrono::duration<double, std::nano> backwardTime = std::chrono::duration<double, std::nano>::zero();
-        for(unsigned int i = 1; i<=numOfImage/(batchSize*deviceCount); ++i)
+
+        //batch N+1 is read from disk into the staging buffers while batch N is on the workers
+        const unsigned int batchCount = numOfImage/(batchSize*deviceCount);
+        std::vector<float> nextImages(deviceCount * batchSize * 28 * 28);
+        std::vector<unsigned int> nextLabels(deviceCount * batchSize);
+
+        auto loadNextBatch = [&]()
+        {
+            for(int d = 0; d<deviceCount;++d)
+            {
+                loadOneTrainData(&nextImages[d * batchSize * 28 * 28], &nextLabels[d * batchSize], batchSize);
+            }
+        };
+
+        loadNextBatch();
+
+        for(unsigned int i = 1; i<=batchCount; ++i)
         {
             for(int d = 0; d<deviceCount;++d)
             {
                 float *inputData = model->beginMutateData(image, d);
                 unsigned int *labelData = model->beginMutateData<FreeWill::DeviceType::CPU_NAIVE, unsigned int>(label,d);
 
-                loadOneTrainData(inputData, labelData, batchSize);
+                std::copy(nextImages.begin() + d * batchSize * 28 * 28, nextImages.begin() + (d + 1) * batchSize * 28 * 28, inputData);
+                std::copy(nextLabels.begin() + d * batchSize, nextLabels.begin() + (d + 1) * batchSize, labelData);
 
                 model->endMutateData(image,d);
                 model->endMutateData(label,d);
             }
             auto forwardStartTime = std::chrono::steady_clock::now();
-            solver.forward(model);
+            FreeWill::SolverStep forwardStep = solver.forwardAsync(model);
+
+            if (i < batchCount)
+            {
+                loadNextBatch();
+            }
+
+            forwardStep.wait();
             auto forwardEndTime = std::chrono::steady_clock::now();
             forwardTime += std::chrono::duration <double, std::nano>(forwardEndTime - forwardStartTime);
 
@@ -131,12 +157,6 @@ void MNIST::trainFullyConnectedModelWithModelClass()
             //emit updateCost(overallCost / (float) (batchSize*deviceCount));
             overallCost = 0.0;
 
-
-            model->clearTensor(fullyConnected1BiasGrad);
-            model->clearTensor(fullyConnected1WeightGrad);
-            model->clearTensor(fullyConnected2BiasGrad);
-            model->clearTensor(fullyConnected2WeightGrad);
-
             auto backwardStartTime = std::chrono::steady_clock::now();
 
             solver.backward(model);
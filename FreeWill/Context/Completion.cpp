@@ -0,0 +1,149 @@
+#include "Completion.h"
+#include "EventCount.h"
+#include <thread>
+#include <climits>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::atomic<unsigned int> FreeWill::Completion::m_maxSpinCount(std::thread::hardware_concurrency() > 1 ? 2000 : 0);
+std::atomic<bool> FreeWill::Completion::m_isConditionVariableWait(false);
+
+namespace
+{
+    //shared by all flags in condition variable mode, picked by address. the
+    //signaler only hashes the address, so the flag may be gone by then
+    struct WaitStripe
+    {
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+    };
+
+    WaitStripe &waitStripe(const void *address)
+    {
+        static WaitStripe stripes[16];
+        return stripes[std::hash<const void*>()(address) % 16];
+    }
+}
+
+static void futexWait(std::atomic<uint32_t> *address, uint32_t expected)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    (void) address;
+    (void) expected;
+    std::this_thread::yield();
+#endif
+}
+
+static void futexWakeAll(std::atomic<uint32_t> *address)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void) address;
+#endif
+}
+
+FreeWill::Completion::Completion()
+    :m_state(PENDING),
+      m_spinEstimate(-1)
+{}
+
+void FreeWill::Completion::signal()
+{
+    if (m_isConditionVariableWait.load(std::memory_order_relaxed))
+    {
+        WaitStripe &stripe = waitStripe(this);
+
+        m_state.store(DONE, std::memory_order_release);
+
+        //taking the lock orders the notify after a waiter that saw PENDING went to sleep
+        std::lock_guard<std::mutex> lock(stripe.m_mutex);
+        stripe.m_condition.notify_all();
+        return;
+    }
+
+    //a spinning waiter may return and free us before the wake, a wake on a
+    //stale address is harmless because every futex waiter rechecks its state
+    if (m_state.exchange(DONE, std::memory_order_acq_rel) == PENDING_WITH_WAITER)
+    {
+        futexWakeAll(&m_state);
+    }
+}
+
+void FreeWill::Completion::waitOnConditionVariable()
+{
+    WaitStripe &stripe = waitStripe(this);
+
+    std::unique_lock<std::mutex> lock(stripe.m_mutex);
+    stripe.m_condition.wait(lock, [this]{ return m_state.load(std::memory_order_acquire) == DONE; });
+}
+
+void FreeWill::Completion::wait()
+{
+    if (m_isConditionVariableWait.load(std::memory_order_relaxed))
+    {
+        waitOnConditionVariable();
+        return;
+    }
+
+    unsigned int maxSpin = m_maxSpinCount.load(std::memory_order_relaxed);
+
+    //without history spin the whole configured limit, a fresh flag is the common case
+    int estimate = m_spinEstimate < 0 ? (int) maxSpin : std::min(m_spinEstimate, (int) maxSpin);
+    unsigned int spinLimit = std::min(maxSpin, (unsigned int) estimate * 2 + 64);
+
+    for (unsigned int spin = 0; spin < spinLimit; ++spin)
+    {
+        if (m_state.load(std::memory_order_acquire) == DONE)
+        {
+            m_spinEstimate = estimate + ((int) spin - estimate) / 8;
+            return;
+        }
+
+        cpuRelax();
+    }
+
+    //spinning didn't pay off this time, spin less next time
+    m_spinEstimate = estimate - estimate / 8;
+
+    uint32_t state = PENDING;
+
+    if (m_state.compare_exchange_strong(state, PENDING_WITH_WAITER, std::memory_order_acq_rel) || state == PENDING_WITH_WAITER)
+    {
+        while (m_state.load(std::memory_order_acquire) != DONE)
+        {
+            futexWait(&m_state, PENDING_WITH_WAITER);
+        }
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+void FreeWill::Completion::setMaxSpinCount(unsigned int maxSpinCount)
+{
+    m_maxSpinCount.store(maxSpinCount, std::memory_order_relaxed);
+}
+
+unsigned int FreeWill::Completion::maxSpinCount()
+{
+    return m_maxSpinCount.load(std::memory_order_relaxed);
+}
+
+void FreeWill::Completion::setConditionVariableWait(bool isConditionVariableWait)
+{
+    m_isConditionVariableWait.store(isConditionVariableWait, std::memory_order_relaxed);
+}
+
+bool FreeWill::Completion::isConditionVariableWait()
+{
+    return m_isConditionVariableWait.load(std::memory_order_relaxed);
+}
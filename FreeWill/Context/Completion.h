@@ -0,0 +1,67 @@
+#ifndef COMPLETION_H
+#define COMPLETION_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace FreeWill
+{
+    // One-shot done flag with a single waiter. wait() spins for a while, most
+    // operators finish within a few microseconds, and only then parks the thread
+    // on a futex. A fresh flag spins up to the configured limit, after that the
+    // budget adapts to how long this flag usually takes, so a reused flag stops
+    // spinning for work that never finishes in time.
+    class Completion
+    {
+    private:
+        enum : uint32_t
+        {
+            PENDING = 0,
+            PENDING_WITH_WAITER = 1,
+            DONE = 2
+        };
+
+        std::atomic<uint32_t> m_state;
+        //only the waiter touches it, -1 until the first wait
+        int m_spinEstimate;
+
+        static std::atomic<unsigned int> m_maxSpinCount;
+        static std::atomic<bool> m_isConditionVariableWait;
+
+        void waitOnConditionVariable();
+
+    public:
+        Completion();
+
+        Completion(const Completion &) = delete;
+        Completion &operator=(const Completion &) = delete;
+
+        void reset()
+        {
+            m_state.store(PENDING, std::memory_order_relaxed);
+        }
+
+        bool isDone() const
+        {
+            return m_state.load(std::memory_order_acquire) == DONE;
+        }
+
+        //last access of the signaling thread, the waiter may destroy the flag right after
+        void signal();
+
+        void wait();
+
+        //0 parks right away, the default depends on the number of cores
+        static void setMaxSpinCount(unsigned int maxSpinCount);
+
+        static unsigned int maxSpinCount();
+
+        //the mutex and condition variable wait every join used before, no
+        //spinning. a baseline for benchmarks, only switch while nothing waits
+        static void setConditionVariableWait(bool isConditionVariableWait);
+
+        static bool isConditionVariableWait();
+    };
+}
+
+#endif
@@ -12,8 +12,13 @@
 #include "../Tensor/ReferenceCountedBlob.h"
 #include <thread>
 #include "Device.h"
+#include "ParallelForJob.h"
+#include "CpuTopology.h"
 #include <iostream>
+#include <functional>
 #include <vector>
+#include <atomic>
+#include <algorithm>
 
 namespace FreeWill
 {
@@ -26,7 +31,14 @@ namespace FreeWill
             m_sharedOneVectorFloatSize(0),
             m_sharedOneVectorDouble(nullptr),
             m_sharedOneVectorDoubleSize(0),
-            m_deviceCount(0)
+            m_deviceCount(0),
+            m_deviceList(),
+            m_workAvailable(),
+            m_nextSpawnDevice(0),
+            m_messagePool(256),
+            m_threadPinning(false),
+            m_topology(),
+            m_inlineWorkThreshold(4096)
         {}
 
 
@@ -36,6 +48,15 @@ namespace FreeWill
         unsigned int m_sharedOneVectorDoubleSize;
         int m_deviceCount;
         std::vector<Device<DeviceUsed>*> m_deviceList;
+        //CPU workers share one parking spot, any of them may pick up any message
+        EventCount m_workAvailable;
+        std::atomic<unsigned int> m_nextSpawnDevice;
+        //recycled messages for work the Context creates itself, keeps the
+        //steady state dispatch path free of heap allocations
+        LockFreeRingbuffer<WorkerMessage> m_messagePool;
+        bool m_threadPinning;
+        CpuTopology m_topology;
+        unsigned long m_inlineWorkThreshold;
 
 
     public:
@@ -83,8 +104,28 @@ namespace FreeWill
                 {
                     Device<DeviceUsed> *device = new Device<DeviceUsed>(i);
                     m_deviceList.push_back(device);
-                    device->init();
+                }
 
+                std::vector<LogicalCpu> pinningOrder;
+
+                if (m_threadPinning)
+                {
+                    m_topology.discover();
+                    pinningOrder = m_topology.pinningOrder();
+                    pinningOrder.erase(std::remove_if(pinningOrder.begin(), pinningOrder.end(),
+                                                      [](const LogicalCpu &cpu){return !CpuTopology::isCpuAllowed(cpu.m_cpuId);}), pinningOrder.end());
+                }
+
+                //workers steal from each other, so the list must be complete before any thread starts
+                for(int i = 0; i<m_deviceCount; ++i)
+                {
+                    //more devices than cpus wraps around and doubles up
+                    m_deviceList[i]->init(&m_deviceList, &m_workAvailable, pinningOrder.empty() ? nullptr : &pinningOrder[i % pinningOrder.size()]);
+                }
+
+                for(int i = 0; i<m_deviceCount * 2 && i < (int) m_messagePool.capacity(); ++i)
+                {
+                    m_messagePool.tryPush(new WorkerMessage((ParallelForJob*) nullptr));
                 }
 
 
@@ -120,6 +161,8 @@ namespace FreeWill
             }
         }
 
+        //deviceId only selects the queue the message starts in, on the CPU an idle
+        //worker may steal it. The replica's tensors stay tied to deviceId.
         void pushWork(unsigned int deviceId, WorkerMessage *message)
         {
             if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
@@ -128,6 +171,195 @@ namespace FreeWill
             }
         }
 
+        //the message runs on the worker of deviceId and is never stolen. The
+        //queue holds privateWorkCapacity() messages, pushing into a full one
+        //blocks until that worker drains it
+        void pushPrivateWork(unsigned int deviceId, WorkerMessage *message)
+        {
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                m_deviceList[deviceId]->pushPrivateWork(message);
+            }
+        }
+
+        unsigned int privateWorkCapacity() const
+        {
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                return m_deviceList.empty() ? 0 : m_deviceList[0]->privateWorkCapacity();
+            }
+            else
+            {
+                return 0;
+            }
+        }
+
+        //push a sub-task with no device preference, from inside a worker it lands
+        //on that worker's own deque
+        void spawn(WorkerMessage *message)
+        {
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                Device<DeviceUsed> *worker = Device<DeviceUsed>::currentWorker();
+
+                if (worker)
+                {
+                    worker->pushLocalWork(message);
+                }
+                else
+                {
+                    unsigned int deviceId = m_nextSpawnDevice.fetch_add(1, std::memory_order_relaxed) % m_deviceList.size();
+                    m_deviceList[deviceId]->pushWork(message);
+                }
+            }
+        }
+
+        //how long a thread waiting on a message, graph or parallelFor spins before
+        //it parks, 0 parks right away. Applies to every device type.
+        void setJoinSpinCount(unsigned int joinSpinCount)
+        {
+            Completion::setMaxSpinCount(joinSpinCount);
+        }
+
+        unsigned int joinSpinCount() const
+        {
+            return Completion::maxSpinCount();
+        }
+
+        //operators estimated below this much work (multiply-adds or touched
+        //elements) run on the calling thread instead of going through a worker,
+        //0 sends everything to the workers
+        void setInlineWorkThreshold(unsigned long inlineWorkThreshold)
+        {
+            m_inlineWorkThreshold = inlineWorkThreshold;
+        }
+
+        unsigned long inlineWorkThreshold() const
+        {
+            return m_inlineWorkThreshold;
+        }
+
+        //pin every CPU worker to its own core, takes effect on the next open()
+        void setThreadPinning(bool threadPinning)
+        {
+            m_threadPinning = threadPinning;
+        }
+
+        bool threadPinning() const
+        {
+            return m_threadPinning;
+        }
+
+        const CpuTopology &topology() const
+        {
+            return m_topology;
+        }
+
+        //runs function on the thread of deviceId and waits for it. Pages the
+        //function touches first end up on the NUMA node of that thread.
+        void runOnDevice(unsigned int deviceId, const std::function<void()> &function)
+        {
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                if (Device<DeviceUsed>::currentWorker() == m_deviceList[deviceId])
+                {
+                    function();
+                    return;
+                }
+
+                WorkerMessage message(&function);
+                m_deviceList[deviceId]->pushPrivateWork(&message);
+                message.join();
+            }
+            else
+            {
+                function();
+            }
+        }
+
+        WorkerMessage *acquireMessage()
+        {
+            WorkerMessage *message = m_messagePool.tryPop();
+
+            if (message)
+            {
+                message->reset();
+                return message;
+            }
+
+            return new WorkerMessage((ParallelForJob*) nullptr);
+        }
+
+        void releaseMessage(WorkerMessage *message)
+        {
+            if (!m_messagePool.tryPush(message))
+            {
+                delete message;
+            }
+        }
+
+        //runs function(chunkBegin, chunkEnd) over [begin, end) in chunks of at most
+        //grainSize, the caller works on chunks too and returns when all are done.
+        //Falls back to a plain call when there is no CPU pool to share the work with.
+        template<typename Function>
+        void parallelFor(unsigned int begin, unsigned int end, const Function &function, unsigned int grainSize = 1)
+        {
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                if (end <= begin)
+                {
+                    return;
+                }
+
+                unsigned int workerCount = m_deviceList.size();
+
+                if (workerCount < 2 || (end - begin) <= grainSize)
+                {
+                    function(begin, end);
+                    return;
+                }
+
+                //a few chunks per worker so a slow worker doesn't hold up the rest
+                unsigned int chunkSize = std::max(grainSize, (end - begin + workerCount * 4 - 1) / (workerCount * 4));
+
+                ParallelForJob job(begin, end, chunkSize, function);
+
+                unsigned int helperCount = std::min(workerCount, job.chunkCount()) - 1;
+                job.addHelpers(helperCount);
+
+                for (unsigned int i = 0; i < helperCount; ++i)
+                {
+                    //helpers hand their message back to the pool themselves
+                    WorkerMessage *helper = acquireMessage();
+                    helper->setParallelForJob(&job);
+                    spawn(helper);
+                }
+
+                job.run();
+
+                Device<DeviceUsed> *worker = Device<DeviceUsed>::currentWorker();
+
+                if (worker)
+                {
+                    //the helpers may still sit in this worker's deque, nobody else
+                    //would run them if all workers are waiting like this one
+                    while (!job.helpersFinished())
+                    {
+                        if (!worker->runLocalWork())
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                }
+
+                job.waitForHelpers();
+            }
+            else
+            {
+                function(begin, end);
+            }
+        }
+
         void close()
         {
             if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
@@ -140,9 +372,20 @@ namespace FreeWill
                 for(int i = 0; i<m_deviceList.size();++i)
                 {
                     m_deviceList[i]->terminate();
+                }
+
+                //running workers may still look into a sibling's queues, delete only after all joined
+                for(int i = 0; i<m_deviceList.size();++i)
+                {
                     delete m_deviceList[i];
                 }
 
+                WorkerMessage *message = nullptr;
+                while ((message = m_messagePool.tryPop()))
+                {
+                    delete message;
+                }
+
                 m_deviceList.clear();
             }
         }
@@ -0,0 +1,179 @@
+#include "CpuTopology.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <pthread.h>
+#include <sched.h>
+
+FreeWill::CpuTopology::CpuTopology()
+    :m_cpus(),
+      m_numaNodeCount(1)
+{
+}
+
+bool FreeWill::CpuTopology::readUnsignedInt(const std::string &path, unsigned int &value)
+{
+    std::ifstream file(path);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    return (bool) (file >> value);
+}
+
+std::vector<unsigned int> FreeWill::CpuTopology::parseCpuList(const std::string &cpuList)
+{
+    //the kernel's list format, e.g. "0-3,8,10-11"
+    std::vector<unsigned int> cpus;
+    std::stringstream stream(cpuList);
+    std::string range;
+
+    while (std::getline(stream, range, ','))
+    {
+        if (range.empty() || range == "\n")
+        {
+            continue;
+        }
+
+        unsigned int first = 0;
+        unsigned int last = 0;
+        std::size_t dash = range.find('-');
+
+        try
+        {
+            first = std::stoul(range.substr(0, dash));
+            last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+        }
+        catch (...)
+        {
+            continue;
+        }
+
+        for (unsigned int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+bool FreeWill::CpuTopology::discover(const std::string &sysfsRoot)
+{
+    m_cpus.clear();
+    m_numaNodeCount = 1;
+
+    std::string onlineList;
+    std::ifstream onlineFile(sysfsRoot + "/cpu/online");
+    std::vector<unsigned int> online;
+
+    if (onlineFile.is_open() && std::getline(onlineFile, onlineList))
+    {
+        online = parseCpuList(onlineList);
+    }
+
+    if (online.empty())
+    {
+        unsigned int cpuCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+        for (unsigned int i = 0; i < cpuCount; ++i)
+        {
+            m_cpus.push_back({i, i, 0, 0, true});
+        }
+
+        return false;
+    }
+
+    for (unsigned int i = 0; i < online.size(); ++i)
+    {
+        LogicalCpu cpu = {online[i], online[i], 0, 0, true};
+        std::string topologyPath = sysfsRoot + "/cpu/cpu" + std::to_string(online[i]) + "/topology/";
+
+        readUnsignedInt(topologyPath + "core_id", cpu.m_coreId);
+        readUnsignedInt(topologyPath + "physical_package_id", cpu.m_packageId);
+
+        m_cpus.push_back(cpu);
+    }
+
+    //machines without NUMA have no node directory at all, everything stays on node 0
+    for (unsigned int node = 0; node < 1024; ++node)
+    {
+        std::ifstream nodeFile(sysfsRoot + "/node/node" + std::to_string(node) + "/cpulist");
+        std::string nodeList;
+
+        if (!nodeFile.is_open())
+        {
+            if (node > 0)
+            {
+                break;
+            }
+            continue;
+        }
+
+        std::getline(nodeFile, nodeList);
+        std::vector<unsigned int> nodeCpus = parseCpuList(nodeList);
+
+        for (unsigned int i = 0; i < m_cpus.size(); ++i)
+        {
+            if (std::find(nodeCpus.begin(), nodeCpus.end(), m_cpus[i].m_cpuId) != nodeCpus.end())
+            {
+                m_cpus[i].m_numaNode = node;
+            }
+        }
+
+        m_numaNodeCount = std::max(m_numaNodeCount, node + 1);
+    }
+
+    std::set<std::pair<unsigned int, unsigned int>> seenCores;
+
+    for (unsigned int i = 0; i < m_cpus.size(); ++i)
+    {
+        m_cpus[i].m_isFirstOnCore = seenCores.insert(std::make_pair(m_cpus[i].m_packageId, m_cpus[i].m_coreId)).second;
+    }
+
+    return true;
+}
+
+std::vector<FreeWill::LogicalCpu> FreeWill::CpuTopology::pinningOrder() const
+{
+    std::vector<LogicalCpu> order = m_cpus;
+
+    std::stable_sort(order.begin(), order.end(), [](const LogicalCpu &a, const LogicalCpu &b)
+    {
+        if (a.m_isFirstOnCore != b.m_isFirstOnCore)
+        {
+            return a.m_isFirstOnCore;
+        }
+
+        return a.m_numaNode < b.m_numaNode;
+    });
+
+    return order;
+}
+
+bool FreeWill::CpuTopology::isCpuAllowed(unsigned int cpuId)
+{
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) != 0)
+    {
+        return true;
+    }
+
+    return CPU_ISSET(cpuId, &cpuset);
+}
+
+bool FreeWill::CpuTopology::pinCurrentThread(unsigned int cpuId)
+{
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpuId, &cpuset);
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0;
+}
@@ -0,0 +1,57 @@
+#ifndef CPUTOPOLOGY_H
+#define CPUTOPOLOGY_H
+
+#include <vector>
+#include <string>
+
+namespace FreeWill
+{
+    struct LogicalCpu
+    {
+        unsigned int m_cpuId;
+        unsigned int m_coreId;
+        unsigned int m_packageId;
+        unsigned int m_numaNode;
+        //false for the second and later hyperthreads of a physical core
+        bool m_isFirstOnCore;
+    };
+
+    // Logical CPUs of the machine as reported by /sys/devices/system. Falls back
+    // to hardware_concurrency() CPUs on one node when sysfs can't be read.
+    class CpuTopology
+    {
+    private:
+        std::vector<LogicalCpu> m_cpus;
+        unsigned int m_numaNodeCount;
+
+        static bool readUnsignedInt(const std::string &path, unsigned int &value);
+
+        static std::vector<unsigned int> parseCpuList(const std::string &cpuList);
+
+    public:
+        CpuTopology();
+
+        bool discover(const std::string &sysfsRoot = "/sys/devices/system");
+
+        const std::vector<LogicalCpu> &cpus() const
+        {
+            return m_cpus;
+        }
+
+        unsigned int numaNodeCount() const
+        {
+            return m_numaNodeCount;
+        }
+
+        //cpus to pin workers to, in order: one hyperthread per physical core,
+        //node by node, the remaining hyperthreads after that
+        std::vector<LogicalCpu> pinningOrder() const;
+
+        //false for cpus outside the process' affinity mask, e.g. in a restricted cpuset
+        static bool isCpuAllowed(unsigned int cpuId);
+
+        static bool pinCurrentThread(unsigned int cpuId);
+    };
+}
+
+#endif
@@ -7,6 +7,13 @@
 #include <mutex>
 #include <condition_variable>
 #include "Ringbuffer.h"
+#include "LockFreeRingbuffer.h"
+#include "WorkStealingDeque.h"
+#include "EventCount.h"
+#include "CpuTopology.h"
+#include <atomic>
+#include <vector>
+#include <random>
 #include "WorkerMessage.h"
 #include <cuda_runtime.h>
 #include <cuda.h>
@@ -96,9 +103,27 @@ namespace FreeWill
 
     private:
         std::thread *m_workerThread;
-        bool m_finished = false;
-        Ringbuffer<WorkerMessage> m_commandQueue;
+        std::atomic<bool> m_finished;
+        //messages pushed from outside the pool, addressed to this device
+        LockFreeRingbuffer<WorkerMessage> m_commandQueue;
+        //sub-tasks spawned by this worker, other workers steal from the top
+        WorkStealingDeque<WorkerMessage> m_localQueue;
+        //work that has to run on this very thread, never stolen
+        LockFreeRingbuffer<WorkerMessage> m_privateQueue;
         unsigned int m_deviceId;
+        //-1 when the worker floats freely
+        int m_cpuId;
+        unsigned int m_numaNode;
+
+        std::vector<Device<DeviceType::CPU_NAIVE>*> *m_siblings;
+        EventCount *m_workAvailable;
+        std::minstd_rand m_victimSelector;
+
+        static thread_local Device<DeviceType::CPU_NAIVE> *m_currentWorker;
+
+        WorkerMessage *findWork();
+
+        void execute(WorkerMessage *message);
 
         void threadLoop();
 
@@ -106,8 +131,15 @@ namespace FreeWill
         Device(unsigned int deviceId = 0)
             : m_workerThread(nullptr),
               m_finished(false),
-              m_commandQueue(100),
-              m_deviceId(deviceId)
+              m_commandQueue(128),
+              m_localQueue(),
+              m_privateQueue(256),
+              m_deviceId(deviceId),
+              m_cpuId(-1),
+              m_numaNode(0),
+              m_siblings(nullptr),
+              m_workAvailable(nullptr),
+              m_victimSelector(deviceId + 1)
         {
         }
 
@@ -119,9 +151,46 @@ namespace FreeWill
             }
         }
 
+        //the worker running on the calling thread, nullptr outside the pool
+        static Device<DeviceType::CPU_NAIVE> *currentWorker()
+        {
+            return m_currentWorker;
+        }
+
+        unsigned int deviceId() const
+        {
+            return m_deviceId;
+        }
+
+        int cpuId() const
+        {
+            return m_cpuId;
+        }
+
+        unsigned int numaNode() const
+        {
+            return m_numaNode;
+        }
+
         void pushWork(WorkerMessage *message);
 
-        void init();
+        //runs on this worker's thread and nowhere else, e.g. to first-touch memory
+        void pushPrivateWork(WorkerMessage *message);
+
+        unsigned int privateWorkCapacity() const
+        {
+            return m_privateQueue.capacity();
+        }
+
+        //only valid on the worker's own thread
+        void pushLocalWork(WorkerMessage *message);
+
+        //pops one message from the worker's own deque and runs it, lets a worker
+        //that waits on its own sub-tasks make progress instead of blocking
+        bool runLocalWork();
+
+        //cpu is where the worker pins itself, nullptr leaves it to the scheduler
+        void init(std::vector<Device<DeviceType::CPU_NAIVE>*> *siblings, EventCount *workAvailable, const LogicalCpu *cpu = nullptr);
 
         void terminate();
     };
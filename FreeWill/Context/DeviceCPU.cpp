@@ -1,65 +1,212 @@
 #include "Device.h"
 #include "../Model/Model.h"
+#include "ParallelForJob.h"
+#include "Context.h"
+#include "../Model/ExecutionGraph.h"
+#include "../Model/CommandList.h"
+
+thread_local FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE> *FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::m_currentWorker = nullptr;
 
 void FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::pushWork(FreeWill::WorkerMessage *message)
 {
-    m_commandQueue.push(message);
+    message->thread_id = 1;
+
+    if (m_currentWorker == nullptr)
+    {
+        m_commandQueue.push(message);
+    }
+    else if (!m_commandQueue.tryPush(message))
+    {
+        //a worker must never block on a full queue, if every worker did nobody would drain them
+        m_currentWorker->m_localQueue.push(message);
+    }
+
+    m_workAvailable->notifyAll();
+}
+
+void FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::pushPrivateWork(FreeWill::WorkerMessage *message)
+{
+    message->thread_id = 1;
 
+    m_privateQueue.push(message);
+    m_workAvailable->notifyAll();
+}
+
+void FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::pushLocalWork(FreeWill::WorkerMessage *message)
+{
     message->thread_id = 1;
 
+    m_localQueue.push(message);
+    m_workAvailable->notifyAll();
+}
+
+bool FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::runLocalWork()
+{
+    FreeWill::WorkerMessage *message = m_localQueue.pop();
+
+    if (message)
+    {
+        execute(message);
+        return true;
+    }
+
+    return false;
 }
 
 void FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::terminate()
 {
-    FreeWill::WorkerMessage message(FreeWill::WorkerMessage::Type::TERMINATE, (FreeWill::Operator<FreeWill::DeviceType::CPU_NAIVE>*)nullptr);
-    pushWork(&message);
-    message.join();
+    //a TERMINATE message could be stolen by another worker, so use a flag instead
+    m_finished.store(true, std::memory_order_release);
+    m_workAvailable->notifyAll();
     m_workerThread->join();
     delete m_workerThread;
     m_workerThread = nullptr;
 }
 
-static std::mutex outputLock;
-
-void FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::threadLoop()
+FreeWill::WorkerMessage *FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::findWork()
 {
-    std::thread::id this_id = std::this_thread::get_id();
+    FreeWill::WorkerMessage *message = m_privateQueue.tryPop();
+
+    if (message)
+    {
+        return message;
+    }
+
+    if ((message = m_localQueue.pop()))
+    {
+        return message;
+    }
+
+    if ((message = m_commandQueue.tryPop()))
+    {
+        return message;
+    }
+
+    unsigned int siblingCount = m_siblings->size();
 
-    while(!m_finished)
+    if (siblingCount < 2)
     {
-        FreeWill::WorkerMessage *message = m_commandQueue.pop();
+        return nullptr;
+    }
+
+    //start from a random victim so idle workers don't all hammer the same one
+    unsigned int victim = m_victimSelector() % siblingCount;
+
+    for (unsigned int i = 0; i < siblingCount; ++i, victim = (victim + 1) % siblingCount)
+    {
+        if (victim == m_deviceId)
+        {
+            continue;
+        }
+
+        Device<FreeWill::DeviceType::CPU_NAIVE> *sibling = (*m_siblings)[victim];
 
-        if (message->workType() == FreeWill::WorkerMessage::Type::TERMINATE)
+        if ((message = sibling->m_localQueue.steal()))
         {
-            message->done();
-            break;
+            return message;
         }
-        /*{
-            std::unique_lock<std::mutex> ol(outputLock);
-            std::cout << "thread: " << this_id << " device "<< m_deviceId << " output." << message->debug_num << std::endl;
-        }*/
+
+        if ((message = sibling->m_commandQueue.tryPop()))
         {
-            Operator<FreeWill::DeviceType::CPU_NAIVE> *operatorBase = message->template operatorBase<FreeWill::DeviceType::CPU_NAIVE>();
-            operatorBase->evaluate();
+            return message;
         }
+    }
+
+    return nullptr;
+}
+
+static std::mutex outputLock;
+
+void FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::execute(FreeWill::WorkerMessage *message)
+{
+    /*{
+        std::unique_lock<std::mutex> ol(outputLock);
+        std::cout << "thread: " << std::this_thread::get_id() << " device "<< m_deviceId << " output." << message->debug_num << std::endl;
+    }*/
+    if (message->workType() == FreeWill::WorkerMessage::Type::GRAPH_NODE)
+    {
+        //completion is tracked by the graph, which may be gone once the node is released
+        message->executionNode()->execute();
+        return;
+    }
+    else if (message->workType() == FreeWill::WorkerMessage::Type::PARALLEL_FOR)
+    {
+        //nobody joins a helper, it goes straight back to the pool
+        ParallelForJob *job = message->parallelForJob();
+        Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().releaseMessage(message);
+        job->run();
+        job->helperFinished();
+        return;
+    }
+    else if (message->workType() == FreeWill::WorkerMessage::Type::FUNCTION)
+    {
+        (*message->function())();
+    }
+    else if (message->workType() == FreeWill::WorkerMessage::Type::COMMAND_LIST)
+    {
+        message->commandList()->execute();
+    }
+    else if (message->workType() != FreeWill::WorkerMessage::Type::NO_WORK)
+    {
+        Operator<FreeWill::DeviceType::CPU_NAIVE> *operatorBase = message->template operatorBase<FreeWill::DeviceType::CPU_NAIVE>();
+        operatorBase->evaluate();
+    }
 
-        message->done();
+    message->done();
+}
+
+void FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::threadLoop()
+{
+    m_currentWorker = this;
+
+    if (m_cpuId >= 0 && !CpuTopology::pinCurrentThread(m_cpuId))
+    {
+        std::cerr << "can't pin device " << m_deviceId << " to cpu " << m_cpuId << std::endl;
+    }
+
+    while(!m_finished.load(std::memory_order_acquire))
+    {
+        FreeWill::WorkerMessage *message = findWork();
+
+        if (!message)
+        {
+            unsigned int key = m_workAvailable->prepareWait();
+
+            //look again after registering as a waiter, a push in between would be missed otherwise
+            if (m_finished.load(std::memory_order_acquire))
+            {
+                m_workAvailable->cancelWait();
+                break;
+            }
+
+            if (!(message = findWork()))
+            {
+                m_workAvailable->wait(key);
+                continue;
+            }
+
+            m_workAvailable->cancelWait();
+        }
 
+        execute(message);
     }
 
+    m_currentWorker = nullptr;
+
     //std::cout << " terminated"<<std::endl;
 }
 
-void FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::init()
+void FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::init(std::vector<FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>*> *siblings, FreeWill::EventCount *workAvailable, const FreeWill::LogicalCpu *cpu)
 {
+    m_siblings = siblings;
+    m_workAvailable = workAvailable;
+
+    if (cpu)
+    {
+        m_cpuId = cpu->m_cpuId;
+        m_numaNode = cpu->m_numaNode;
+    }
+
+    //the worker pins itself before it takes any work
     m_workerThread = new std::thread([=]{FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::threadLoop();});
-    /*cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);
-    CPU_SET(m_deviceId, &cpuset);
-    int rc = pthread_setaffinity_np(m_workerThread->native_handle(),
-                                    sizeof(cpu_set_t), &cpuset);*/
-     //struct sched_param param = {0};
-     //param.sched_priority = 99;
-
-    //pthread_setschedparam(m_workerThread->native_handle(), SCHED_BATCH, &param);
 }
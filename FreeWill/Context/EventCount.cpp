@@ -0,0 +1,46 @@
+#include "EventCount.h"
+
+FreeWill::EventCount::EventCount()
+    :m_state(0),
+      m_mutex(),
+      m_condition()
+{}
+
+uint32_t FreeWill::EventCount::prepareWait()
+{
+    uint64_t previous = m_state.fetch_add(1, std::memory_order_seq_cst);
+    return (uint32_t) (previous >> m_epochShift);
+}
+
+void FreeWill::EventCount::cancelWait()
+{
+    m_state.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void FreeWill::EventCount::wait(uint32_t key)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [=]{return (uint32_t) (m_state.load(std::memory_order_acquire) >> m_epochShift) != key;});
+    lock.unlock();
+
+    m_state.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void FreeWill::EventCount::notifyAll()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if ((m_state.load(std::memory_order_relaxed) & m_waiterMask) == 0)
+    {
+        return;
+    }
+
+    m_state.fetch_add(1ull << m_epochShift, std::memory_order_seq_cst);
+
+    //the waiter checks the epoch under the mutex, taking it here closes the gap
+    //between that check and the actual sleep
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_condition.notify_all();
+}
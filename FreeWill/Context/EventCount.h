@@ -0,0 +1,50 @@
+#ifndef EVENTCOUNT_H
+#define EVENTCOUNT_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+
+namespace FreeWill
+{
+    inline void cpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    // Parking spot for threads waiting on a lock-free condition. The waiter count
+    // and the epoch share one word, so a notifier that finds nobody waiting
+    // never touches the mutex.
+    //
+    //   key = prepareWait();
+    //   if (condition()) cancelWait(); else wait(key);
+    class EventCount
+    {
+    private:
+        std::atomic<uint64_t> m_state;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+
+        static const uint64_t m_waiterMask = 0xffffffffull;
+        static const unsigned int m_epochShift = 32;
+
+    public:
+        EventCount();
+
+        uint32_t prepareWait();
+
+        void cancelWait();
+
+        void wait(uint32_t key);
+
+        void notifyAll();
+    };
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef LOCKFREERINGBUFFER_H
+#define LOCKFREERINGBUFFER_H
+
+#include "EventCount.h"
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <thread>
+
+namespace FreeWill
+{
+    // Bounded multi-producer multi-consumer queue. Every cell carries a sequence
+    // number that tells producers and consumers whose turn it is, so push and pop
+    // are a single CAS on the fast path. The blocking variants spin for a while
+    // before parking on an EventCount, spinning is skipped on single core machines
+    // where it would only burn the timeslice of the thread we are waiting for.
+    template <typename ElementType>
+    class LockFreeRingbuffer
+    {
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> m_sequence;
+            ElementType *m_element;
+        };
+
+        std::unique_ptr<Cell[]> m_buffer;
+        size_t m_mask;
+        unsigned int m_spinCount;
+
+        alignas(64) std::atomic<size_t> m_head;
+        alignas(64) std::atomic<size_t> m_tail;
+
+        EventCount m_notEmpty;
+        EventCount m_notFull;
+
+        static size_t roundUpToPowerOfTwo(size_t size)
+        {
+            size_t capacity = 2;
+            while (capacity < size)
+            {
+                capacity <<= 1;
+            }
+            return capacity;
+        }
+
+    public:
+        LockFreeRingbuffer(unsigned int defaultSize = 128, unsigned int spinCount = 1024)
+            :m_buffer(nullptr),
+              m_mask(roundUpToPowerOfTwo(defaultSize) - 1),
+              m_spinCount(std::thread::hardware_concurrency() > 1 ? spinCount : 0),
+              m_head(0),
+              m_tail(0),
+              m_notEmpty(),
+              m_notFull()
+        {
+            m_buffer.reset(new Cell[m_mask + 1]);
+
+            for (size_t i = 0; i <= m_mask; ++i)
+            {
+                m_buffer[i].m_sequence.store(i, std::memory_order_relaxed);
+                m_buffer[i].m_element = nullptr;
+            }
+        }
+
+        LockFreeRingbuffer(const LockFreeRingbuffer &) = delete;
+        LockFreeRingbuffer &operator=(const LockFreeRingbuffer &) = delete;
+
+        unsigned int capacity() const
+        {
+            return m_mask + 1;
+        }
+
+        void setSpinCount(unsigned int spinCount)
+        {
+            m_spinCount = std::thread::hardware_concurrency() > 1 ? spinCount : 0;
+        }
+
+        bool tryPush(ElementType *element)
+        {
+            size_t position = m_head.load(std::memory_order_relaxed);
+
+            while (true)
+            {
+                Cell &cell = m_buffer[position & m_mask];
+                size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+                intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+                if (difference == 0)
+                {
+                    if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        cell.m_element = element;
+                        cell.m_sequence.store(position + 1, std::memory_order_release);
+                        m_notEmpty.notifyAll();
+                        return true;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        ElementType *tryPop()
+        {
+            size_t position = m_tail.load(std::memory_order_relaxed);
+
+            while (true)
+            {
+                Cell &cell = m_buffer[position & m_mask];
+                size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+                intptr_t difference = (intptr_t) sequence - (intptr_t) (position + 1);
+
+                if (difference == 0)
+                {
+                    if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        ElementType *element = cell.m_element;
+                        cell.m_sequence.store(position + m_mask + 1, std::memory_order_release);
+                        m_notFull.notifyAll();
+                        return element;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    return nullptr;
+                }
+                else
+                {
+                    position = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void push(ElementType *element)
+        {
+            if (!tryPush(element))
+            {
+                unsigned int spin = 0;
+
+                while (true)
+                {
+                    if (spin < m_spinCount)
+                    {
+                        ++spin;
+                        cpuRelax();
+                        if (tryPush(element))
+                        {
+                            break;
+                        }
+                        continue;
+                    }
+
+                    uint32_t key = m_notFull.prepareWait();
+                    if (tryPush(element))
+                    {
+                        m_notFull.cancelWait();
+                        break;
+                    }
+                    m_notFull.wait(key);
+                }
+            }
+        }
+
+        ElementType *pop()
+        {
+            ElementType *element = tryPop();
+
+            if (!element)
+            {
+                unsigned int spin = 0;
+
+                while (true)
+                {
+                    if (spin < m_spinCount)
+                    {
+                        ++spin;
+                        cpuRelax();
+                        if ((element = tryPop()))
+                        {
+                            break;
+                        }
+                        continue;
+                    }
+
+                    uint32_t key = m_notEmpty.prepareWait();
+                    if ((element = tryPop()))
+                    {
+                        m_notEmpty.cancelWait();
+                        break;
+                    }
+                    m_notEmpty.wait(key);
+                }
+            }
+
+            return element;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef PARALLELFORJOB_H
+#define PARALLELFORJOB_H
+
+#include <atomic>
+#include <algorithm>
+#include "Completion.h"
+
+namespace FreeWill
+{
+    // A range [begin, end) cut into chunks. The caller and any number of helper
+    // workers call run(), each grabs the next unclaimed chunk until none is left.
+    // The loop body is type erased so WorkerMessage can carry the job. The job
+    // lives on the caller's stack, so the caller has to wait for every helper.
+    class ParallelForJob
+    {
+    private:
+        unsigned int m_begin;
+        unsigned int m_end;
+        unsigned int m_chunkSize;
+        unsigned int m_chunkCount;
+        std::atomic<unsigned int> m_nextChunk;
+
+        const void *m_function;
+        void (*m_invoke)(const void *function, unsigned int begin, unsigned int end);
+
+        std::atomic<unsigned int> m_pendingHelpers;
+        Completion m_helpersFinished;
+
+    public:
+        template<typename Function>
+        ParallelForJob(unsigned int begin, unsigned int end, unsigned int chunkSize, const Function &function)
+            :m_begin(begin),
+              m_end(end),
+              m_chunkSize(std::max(chunkSize, 1u)),
+              m_chunkCount(0),
+              m_nextChunk(0),
+              m_function(&function),
+              m_invoke([](const void *function, unsigned int begin, unsigned int end)
+                       {(*static_cast<const Function*>(function))(begin, end);}),
+              m_pendingHelpers(0),
+              m_helpersFinished()
+        {
+            m_chunkCount = end > begin ? (end - begin + m_chunkSize - 1) / m_chunkSize : 0;
+        }
+
+        ParallelForJob(const ParallelForJob &) = delete;
+        ParallelForJob &operator=(const ParallelForJob &) = delete;
+
+        unsigned int chunkCount() const
+        {
+            return m_chunkCount;
+        }
+
+        void run()
+        {
+            unsigned int chunk = 0;
+
+            while ((chunk = m_nextChunk.fetch_add(1, std::memory_order_relaxed)) < m_chunkCount)
+            {
+                unsigned int chunkBegin = m_begin + chunk * m_chunkSize;
+                unsigned int chunkEnd = std::min(chunkBegin + m_chunkSize, m_end);
+                m_invoke(m_function, chunkBegin, chunkEnd);
+            }
+        }
+
+        //call once, before any helper is pushed
+        void addHelpers(unsigned int count)
+        {
+            m_pendingHelpers.store(count, std::memory_order_relaxed);
+
+            if (count == 0)
+            {
+                m_helpersFinished.signal();
+            }
+        }
+
+        //last call a helper makes on the job
+        void helperFinished()
+        {
+            if (m_pendingHelpers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                m_helpersFinished.signal();
+            }
+        }
+
+        bool helpersFinished() const
+        {
+            return m_helpersFinished.isDone();
+        }
+
+        void waitForHelpers()
+        {
+            m_helpersFinished.wait();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef WORKSTEALINGDEQUE_H
+#define WORKSTEALINGDEQUE_H
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+namespace FreeWill
+{
+    // Chase-Lev deque. The owning worker pushes and pops at the bottom without
+    // contention, other workers steal from the top. The buffer grows on demand,
+    // retired buffers are kept alive until the deque is destroyed because a
+    // thief may still be reading from them.
+    template <typename ElementType>
+    class WorkStealingDeque
+    {
+    private:
+        class Array
+        {
+        private:
+            int64_t m_capacity;
+            std::atomic<ElementType*> *m_elements;
+
+        public:
+            Array(int64_t capacity)
+                :m_capacity(capacity),
+                  m_elements(new std::atomic<ElementType*>[capacity])
+            {}
+
+            ~Array()
+            {
+                delete [] m_elements;
+            }
+
+            int64_t capacity() const
+            {
+                return m_capacity;
+            }
+
+            ElementType *get(int64_t index) const
+            {
+                return m_elements[index & (m_capacity - 1)].load(std::memory_order_relaxed);
+            }
+
+            void put(int64_t index, ElementType *element)
+            {
+                m_elements[index & (m_capacity - 1)].store(element, std::memory_order_relaxed);
+            }
+
+            Array *grow(int64_t bottom, int64_t top) const
+            {
+                Array *newArray = new Array(m_capacity * 2);
+                for (int64_t i = top; i < bottom; ++i)
+                {
+                    newArray->put(i, get(i));
+                }
+                return newArray;
+            }
+        };
+
+        alignas(64) std::atomic<int64_t> m_top;
+        alignas(64) std::atomic<int64_t> m_bottom;
+        std::atomic<Array*> m_array;
+        std::vector<Array*> m_retiredArrays;
+
+    public:
+        WorkStealingDeque(int64_t capacity = 64)
+            :m_top(0),
+              m_bottom(0),
+              m_array(new Array(capacity)),
+              m_retiredArrays()
+        {}
+
+        WorkStealingDeque(const WorkStealingDeque &) = delete;
+        WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+        ~WorkStealingDeque()
+        {
+            for (unsigned int i = 0; i < m_retiredArrays.size(); ++i)
+            {
+                delete m_retiredArrays[i];
+            }
+            delete m_array.load();
+        }
+
+        bool empty() const
+        {
+            int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            int64_t top = m_top.load(std::memory_order_relaxed);
+            return bottom <= top;
+        }
+
+        //owner only
+        void push(ElementType *element)
+        {
+            int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            int64_t top = m_top.load(std::memory_order_acquire);
+            Array *array = m_array.load(std::memory_order_relaxed);
+
+            if (bottom - top > array->capacity() - 1)
+            {
+                m_retiredArrays.push_back(array);
+                array = array->grow(bottom, top);
+                m_array.store(array, std::memory_order_release);
+            }
+
+            array->put(bottom, element);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        //owner only
+        ElementType *pop()
+        {
+            int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            Array *array = m_array.load(std::memory_order_relaxed);
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = m_top.load(std::memory_order_relaxed);
+
+            ElementType *element = nullptr;
+
+            if (top <= bottom)
+            {
+                element = array->get(bottom);
+
+                if (top == bottom)
+                {
+                    //last element, race against the thieves
+                    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    {
+                        element = nullptr;
+                    }
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+
+            return element;
+        }
+
+        ElementType *steal()
+        {
+            int64_t top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+            if (top < bottom)
+            {
+                Array *array = m_array.load(std::memory_order_acquire);
+                ElementType *element = array->get(top);
+
+                if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return nullptr;
+                }
+
+                return element;
+            }
+
+            return nullptr;
+        }
+    };
+}
+
+#endif
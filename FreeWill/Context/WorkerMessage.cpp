@@ -4,20 +4,76 @@ FreeWill::WorkerMessage::WorkerMessage(Type workType, Operator<DeviceType::CPU_N
     :m_workType(workType),
       m_model(model),
       m_operatorBase(operatorBase),
-      m_finished(false)
+      m_parallelForJob(nullptr),
+      m_executionNode(nullptr),
+      m_commandList(nullptr),
+      m_function(nullptr),
+      m_completion()
 {}
 
 FreeWill::WorkerMessage::WorkerMessage(Type workType, Operator<DeviceType::GPU_CUDA> *operatorBase, Model *model)
     :m_workType(workType),
       m_model(model),
       m_operatorBase(operatorBase),
-      m_finished(false)
+      m_parallelForJob(nullptr),
+      m_executionNode(nullptr),
+      m_commandList(nullptr),
+      m_function(nullptr),
+      m_completion()
+{}
+
+FreeWill::WorkerMessage::WorkerMessage(ParallelForJob *parallelForJob)
+    :m_workType(Type::PARALLEL_FOR),
+      m_model(nullptr),
+      m_operatorBase((Operator<DeviceType::CPU_NAIVE>*) nullptr),
+      m_parallelForJob(parallelForJob),
+      m_executionNode(nullptr),
+      m_commandList(nullptr),
+      m_function(nullptr),
+      m_completion()
+{}
+
+FreeWill::WorkerMessage::WorkerMessage(ExecutionNode *executionNode)
+    :m_workType(Type::GRAPH_NODE),
+      m_model(nullptr),
+      m_operatorBase((Operator<DeviceType::CPU_NAIVE>*) nullptr),
+      m_parallelForJob(nullptr),
+      m_executionNode(executionNode),
+      m_commandList(nullptr),
+      m_function(nullptr),
+      m_completion()
+{}
+
+FreeWill::WorkerMessage::WorkerMessage(CommandList *commandList)
+    :m_workType(Type::COMMAND_LIST),
+      m_model(nullptr),
+      m_operatorBase((Operator<DeviceType::CPU_NAIVE>*) nullptr),
+      m_parallelForJob(nullptr),
+      m_executionNode(nullptr),
+      m_commandList(commandList),
+      m_function(nullptr),
+      m_completion()
+{}
+
+FreeWill::WorkerMessage::WorkerMessage(const std::function<void()> *function)
+    :m_workType(Type::FUNCTION),
+      m_model(nullptr),
+      m_operatorBase((Operator<DeviceType::CPU_NAIVE>*) nullptr),
+      m_parallelForJob(nullptr),
+      m_executionNode(nullptr),
+      m_commandList(nullptr),
+      m_function(function),
+      m_completion()
 {}
 
 FreeWill::WorkerMessage::WorkerMessage(const WorkerMessage &in)
     :m_workType(in.m_workType),
       m_model(in.m_model),
-      m_finished(false)
+      m_parallelForJob(in.m_parallelForJob),
+      m_executionNode(in.m_executionNode),
+      m_commandList(in.m_commandList),
+      m_function(in.m_function),
+      m_completion()
 {
 
 }
@@ -26,24 +82,42 @@ void FreeWill::WorkerMessage::operator =(const WorkerMessage &in)
 {
     m_workType = in.m_workType;
     m_model = in.m_model;
-    m_finished = in.m_finished;
+    m_parallelForJob = in.m_parallelForJob;
+    m_executionNode = in.m_executionNode;
+    m_commandList = in.m_commandList;
+    m_function = in.m_function;
+
+    if (in.m_completion.isDone())
+    {
+        m_completion.signal();
+    }
+    else
+    {
+        m_completion.reset();
+    }
 }
 
 FreeWill::WorkerMessage::~WorkerMessage(){}
 
 void FreeWill::WorkerMessage::join()
 {
-    std::unique_lock<std::mutex> workLock(m_conditionFinishedMutex);
-    m_conditionFinished.wait(workLock, [=]{return m_finished == true;});
-    workLock.unlock();
+    m_completion.wait();
 }
 
 void FreeWill::WorkerMessage::done()
 {
-    std::unique_lock<std::mutex> workLock(m_conditionFinishedMutex);
-    m_finished = true;
-    //notify must be inside the workLock, otherwise dead lock
-    m_conditionFinished.notify_one();
+    m_completion.signal();
+}
+
+void FreeWill::WorkerMessage::reset()
+{
+    m_completion.reset();
+}
+
+void FreeWill::WorkerMessage::setParallelForJob(ParallelForJob *parallelForJob)
+{
+    m_workType = Type::PARALLEL_FOR;
+    m_parallelForJob = parallelForJob;
 }
 
 FreeWill::WorkerMessage::Type FreeWill::WorkerMessage::workType() const
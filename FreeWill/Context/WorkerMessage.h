@@ -5,11 +5,16 @@
 #include <thread>
 #include <mutex>
 #include <variant>
+#include <functional>
 #include "../Tensor/ReferenceCountedBlob.h"
+#include "Completion.h"
 
 namespace FreeWill
 {
     class Model;
+    class ParallelForJob;
+    class ExecutionNode;
+    class CommandList;
     template <DeviceType DeviceUsed>
     class Operator;
 
@@ -22,22 +27,32 @@ namespace FreeWill
             FORWARD,
             BACKWARD,
             UPDATE,
+            PARALLEL_FOR,
+            GRAPH_NODE,
+            COMMAND_LIST,
+            FUNCTION,
             TERMINATE
         };
 
     private:
         Model *m_model;
         std::variant<Operator<DeviceType::GPU_CUDA>*, Operator<DeviceType::CPU_NAIVE>*> m_operatorBase;
-        std::condition_variable m_conditionFinished;
-        std::mutex m_conditionFinishedMutex;
+        ParallelForJob *m_parallelForJob;
+        ExecutionNode *m_executionNode;
+        CommandList *m_commandList;
+        const std::function<void()> *m_function;
         Type m_workType;
-        bool m_finished;
+        Completion m_completion;
 
     public:
         int debug_num = 0;
         int thread_id = 0;
         WorkerMessage(Type workType = Type::NO_WORK, Operator<DeviceType::CPU_NAIVE> *operatorBase = nullptr,  Model *model = nullptr);
         WorkerMessage(Type workType = Type::NO_WORK, Operator<DeviceType::GPU_CUDA> *operatorBase = nullptr,  Model *model = nullptr);
+        WorkerMessage(ParallelForJob *parallelForJob);
+        WorkerMessage(ExecutionNode *executionNode);
+        WorkerMessage(CommandList *commandList);
+        WorkerMessage(const std::function<void()> *function);
 
         WorkerMessage(const WorkerMessage &in);
 
@@ -49,8 +64,38 @@ namespace FreeWill
 
         void join();
 
+        bool finished() const
+        {
+            return m_completion.isDone();
+        }
+
+        //makes a finished message ready to be pushed again
+        void reset();
+
+        void setParallelForJob(ParallelForJob *parallelForJob);
+
         Type workType() const;
 
+        ParallelForJob *parallelForJob() const
+        {
+            return m_parallelForJob;
+        }
+
+        ExecutionNode *executionNode() const
+        {
+            return m_executionNode;
+        }
+
+        CommandList *commandList() const
+        {
+            return m_commandList;
+        }
+
+        const std::function<void()> *function() const
+        {
+            return m_function;
+        }
+
         template<DeviceType DeviceUsed = DeviceType::CPU_NAIVE>
         Operator<DeviceUsed> *operatorBase()
         {
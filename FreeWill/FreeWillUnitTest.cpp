@@ -13,7 +13,9 @@
 #include "Operator/SoftmaxLogLossDerivative.h"
 #include "Operator/MaxPooling.h"
 #include "Operator/MaxPoolingDerivative.h"
+#include "Operator/Gemm.h"
 #include "Model/Model.h"
+#include <chrono>
 
 void FreeWillUnitTest::operatorSigmoidCrossEntropyTestCPUAndGPU()
 {
@@ -386,6 +388,161 @@ void FreeWillUnitTest::operatorDotProductWithBiasTestGPU()
     }
 }
 
+template<typename DataType>
+static bool compareGemm(unsigned int m, unsigned int n, unsigned int k, bool transposeA, bool transposeB, bool accumulate, bool hasBias)
+{
+    std::vector<DataType> a(m * k);
+    std::vector<DataType> b(k * n);
+    std::vector<DataType> bias(n);
+    std::vector<DataType> c(m * n);
+
+    for (auto &value : a) value = (DataType) (rand() % 200 - 100) / 100;
+    for (auto &value : b) value = (DataType) (rand() % 200 - 100) / 100;
+    for (auto &value : bias) value = (DataType) (rand() % 200 - 100) / 100;
+    for (auto &value : c) value = (DataType) (rand() % 200 - 100) / 100;
+
+    std::vector<DataType> reference(c);
+
+    //a transposed operand is stored the other way around and gets swapped strides
+    size_t aRowStride = transposeA ? 1 : k;
+    size_t aColumnStride = transposeA ? m : 1;
+    size_t bRowStride = transposeB ? 1 : n;
+    size_t bColumnStride = transposeB ? k : 1;
+
+    for (unsigned int i = 0; i < m; ++i)
+    {
+        for (unsigned int j = 0; j < n; ++j)
+        {
+            double sum = (accumulate ? reference[i * n + j] : 0.0) + (hasBias ? bias[j] : 0.0);
+
+            for (unsigned int p = 0; p < k; ++p)
+            {
+                sum += (double) a[i * aRowStride + p * aColumnStride] * b[p * bRowStride + j * bColumnStride];
+            }
+
+            reference[i * n + j] = sum;
+        }
+    }
+
+    FreeWill::gemm<DataType>(m, n, k, a.data(), aRowStride, aColumnStride, b.data(), bRowStride, bColumnStride,
+                             c.data(), n, accumulate, hasBias ? bias.data() : nullptr);
+
+    for (unsigned int i = 0; i < m * n; ++i)
+    {
+        if (std::abs(c[i] - reference[i]) > 1e-3 * (k + 1))
+        {
+            qDebug() << "gemm" << m << n << k << "element" << i << c[i] << "reference" << reference[i];
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FreeWillUnitTest::gemmTest()
+{
+    const FreeWill::GemmKernel kernels[] = {FreeWill::GemmKernel::PORTABLE, FreeWill::GemmKernel::AVX2, FreeWill::GemmKernel::AVX512};
+    const FreeWill::GemmKernel defaultKernel = FreeWill::gemmKernel();
+
+    //register block edges, more than one KC block, small batches that read B in place and large ones that pack it
+    const unsigned int sizes[][3] = {{1, 1, 1}, {2, 100, 2880}, {2, 37, 5}, {7, 19, 300}, {13, 70, 1}, {50, 33, 17}, {100, 130, 600}, {3, 5, 0}};
+
+    for (FreeWill::GemmKernel kernel : kernels)
+    {
+        if (!FreeWill::setGemmKernel(kernel))
+        {
+            qDebug() << "gemm kernel" << (int) kernel << "not supported by this CPU, skipped";
+            continue;
+        }
+
+        for (const auto &size : sizes)
+        {
+            for (unsigned int variant = 0; variant < 8; ++variant)
+            {
+                bool transposeA = variant & 1;
+                bool transposeB = variant & 2;
+                bool accumulate = variant & 4;
+
+                QVERIFY(compareGemm<float>(size[0], size[1], size[2], transposeA, transposeB, accumulate, !accumulate));
+                QVERIFY(compareGemm<double>(size[0], size[1], size[2], transposeA, transposeB, accumulate, accumulate));
+            }
+        }
+    }
+
+    FreeWill::setGemmKernel(defaultKernel);
+}
+
+void FreeWillUnitTest::gemmBenchmark()
+{
+    //the fully connected layer of the MNIST conv net
+    const unsigned int batchSize = 2;
+    const unsigned int inputSize = 2880;
+    const unsigned int outputSize = 100;
+    const unsigned int repeatCount = 200;
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> input({inputSize, batchSize});
+    input.init();
+    input.randomize();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> weight({outputSize, inputSize});
+    weight.init();
+    weight.randomize();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> bias({outputSize});
+    bias.init();
+    bias.randomize();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> output({outputSize, batchSize});
+    output.init();
+
+    FreeWill::DotProductWithBias<FreeWill::DeviceType::CPU_NAIVE, float> dotProductWithBias(true);
+    dotProductWithBias.setInputParameter("Input", &input);
+    dotProductWithBias.setInputParameter("Weight", &weight);
+    dotProductWithBias.setInputParameter("Bias", &bias);
+    dotProductWithBias.setOutputParameter("Output", &output);
+    QVERIFY(dotProductWithBias.init());
+
+    std::vector<float> reference(outputSize * batchSize);
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (unsigned int r = 0; r < repeatCount; ++r)
+    {
+        //the loop DotProductWithBias used before
+        for (unsigned int b = 0; b < batchSize; ++b)
+        {
+            for (unsigned int o = 0; o < outputSize; ++o)
+            {
+                float sum = 0;
+
+                for (unsigned int i = 0; i < inputSize; ++i)
+                {
+                    sum += weight[i * outputSize + o] * input[b * inputSize + i];
+                }
+
+                reference[b * outputSize + o] = sum + bias[o];
+            }
+        }
+    }
+
+    auto loopTime = std::chrono::steady_clock::now();
+
+    for (unsigned int r = 0; r < repeatCount; ++r)
+    {
+        dotProductWithBias.evaluate();
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+
+    for (unsigned int i = 0; i < outputSize * batchSize; ++i)
+    {
+        QVERIFY(std::abs(output[i] - reference[i]) < 1e-3);
+    }
+
+    qDebug() << "{100, 2880} layer, loop:" << std::chrono::duration<double, std::micro>(loopTime - startTime).count() / repeatCount
+             << "us, gemm:" << std::chrono::duration<double, std::micro>(endTime - loopTime).count() / repeatCount << "us";
+}
+
 void FreeWillUnitTest::operatorDotProductWithBiasDerivativeTest()
 {
     FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, double> input({10, 1});
@@ -508,7 +665,82 @@ void FreeWillUnitTest::operatorDotProductWithBiasDerivativeTest()
         //qDebug() << "realGradient" << realGradient[i] << "fakeWeightGrad" << fakeWeightGrad[i] << i;
         QVERIFY(relativeError(realGradient[i], fakeWeightGrad[i]) < 2.0 * epsilon);
     }
-    
+
+    //a batch against the per sample sums, evaluated twice: overwritten, then accumulated
+    const unsigned int batchSize = 3;
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, double> batchInput({10, batchSize});
+    batchInput.init();
+    batchInput.randomize();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, double> batchDelta({5, batchSize});
+    batchDelta.init();
+    batchDelta.randomize();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, double> batchInputGradient({10, batchSize});
+    batchInputGradient.init();
+
+    for (unsigned int a = 0; a < 2; ++a)
+    {
+        bool isAccumulating = a == 1;
+
+        realGradient.clear();
+        realBiasGradient.clear();
+
+        FreeWill::DotProductWithBiasDerivative<FreeWill::DeviceType::CPU_NAIVE, double> batchDerivative(true, 0, isAccumulating);
+        batchDerivative.setInputParameter("InputActivation", &batchInput);
+        batchDerivative.setInputParameter("OutputDelta", &batchDelta);
+        batchDerivative.setInputParameter("Weight", &weight);
+        batchDerivative.setOutputParameter("WeightGrad", &realGradient);
+        batchDerivative.setOutputParameter("BiasGrad", &realBiasGradient);
+        batchDerivative.setOutputParameter("InputDelta", &batchInputGradient);
+
+        QVERIFY(batchDerivative.init());
+
+        batchDerivative.evaluate();
+        batchDerivative.evaluate();
+
+        double scale = isAccumulating ? 2.0 : 1.0;
+
+        for (unsigned int o = 0; o < 5; ++o)
+        {
+            double biasSum = 0;
+
+            for (unsigned int b = 0; b < batchSize; ++b)
+            {
+                biasSum += batchDelta[b * 5 + o];
+            }
+
+            QVERIFY(std::abs(realBiasGradient[o] - scale * biasSum) < epsilon);
+
+            for (unsigned int i = 0; i < 10; ++i)
+            {
+                double weightSum = 0;
+
+                for (unsigned int b = 0; b < batchSize; ++b)
+                {
+                    weightSum += batchInput[b * 10 + i] * batchDelta[b * 5 + o];
+                }
+
+                QVERIFY(std::abs(realGradient[i * 5 + o] - scale * weightSum) < epsilon);
+            }
+        }
+
+        for (unsigned int b = 0; b < batchSize; ++b)
+        {
+            for (unsigned int i = 0; i < 10; ++i)
+            {
+                double inputSum = 0;
+
+                for (unsigned int o = 0; o < 5; ++o)
+                {
+                    inputSum += weight[i * 5 + o] * batchDelta[b * 5 + o];
+                }
+
+                QVERIFY(std::abs(batchInputGradient[b * 10 + i] - inputSum) < epsilon);
+            }
+        }
+    }
 }
 
 void FreeWillUnitTest::operatorDotProductWithBiasDerivativeTestGPU()
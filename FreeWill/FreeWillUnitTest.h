@@ -8,7 +8,12 @@ private slots:
     void cleanupTestCase();
     void blobTest();
     void blobTestGPU();
+    void allocatorTest();
+    void mappedFileTest();
+    void shapeTest();
     void tensorTest();
+    void tensorViewTest();
+    void halfPrecisionTest();
     void tensorTestGPU();
     void operatorTest();
     void operatorTestGPU();
@@ -22,6 +27,8 @@ private slots:
     void operatorSigmoidCrossEntropyDerivativeTestGPU();
     void operatorDotProductWithBiasTest();
     void operatorDotProductWithBiasTestGPU();
+    void gemmTest();
+    void gemmBenchmark();
     void operatorDotProductWithBiasDerivativeTest();
     void operatorDotProductWithBiasDerivativeTestGPU();
     void SoftmaxTest();
@@ -30,11 +37,26 @@ private slots:
     void SoftmaxDerivativeTestGPU();
     void convolutionTest();
     void convolutionTestGPU();
+    void convolutionAlgorithmTest();
+    void convolutionAlgorithmBenchmark();
     void convolutionDerivativeTest();
     void convolutionDerivativeTestGPU();
     void maxPoolingTestCPUAndGPU();
     void xorTest();
     void xorTestGPU();
     void modelXORTest();
+    void executionGraphTest();
+    void pipelineAffinityTest();
+    void memoryPlanTest();
+    void memoryPlanTrainingTest();
+    void quantizationTest();
+    void dispatchBenchmark();
     void threadTestCPU();
+    void lockFreeRingbufferTest();
+    void ringbufferBenchmark();
+    void workStealingDequeTest();
+    void workStealingSchedulerTest();
+    void workerMessageReuseTest();
+    void parallelForTest();
+    void cpuTopologyTest();
 };
@@ -0,0 +1,658 @@
+#include "FreeWillUnitTest.h"
+#include "Context/Ringbuffer.h"
+#include "Context/LockFreeRingbuffer.h"
+#include "Context/WorkStealingDeque.h"
+#include "Context/Context.h"
+#include "Context/CpuTopology.h"
+#include "Operator/Operator.h"
+#include "Operator/Convolution.h"
+#include "Operator/ConvolutionDerivative.h"
+#include "Operator/DotProductWithBias.h"
+#include "Operator/MaxPooling.h"
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <mutex>
+#include <fstream>
+#include <cstdlib>
+#include <sched.h>
+#include <sys/stat.h>
+
+void FreeWillUnitTest::lockFreeRingbufferTest()
+{
+    const unsigned int producerCount = 4;
+    const unsigned int consumerCount = 4;
+    const unsigned int itemsPerProducer = 20000;
+
+    //small capacity on purpose, so producers hit the full queue and park
+    FreeWill::LockFreeRingbuffer<unsigned int> queue(16, 64);
+    QVERIFY(queue.capacity() == 16);
+
+    std::vector<unsigned int> items(producerCount * itemsPerProducer);
+    for (unsigned int i = 0; i < items.size(); ++i)
+    {
+        items[i] = i;
+    }
+
+    std::vector<std::atomic<unsigned int>> seen(items.size());
+    for (unsigned int i = 0; i < seen.size(); ++i)
+    {
+        seen[i] = 0;
+    }
+
+    std::vector<std::thread> producers;
+    for (unsigned int p = 0; p < producerCount; ++p)
+    {
+        producers.emplace_back([&, p]{
+            for (unsigned int i = 0; i < itemsPerProducer; ++i)
+            {
+                queue.push(&items[p * itemsPerProducer + i]);
+            }
+        });
+    }
+
+    std::vector<std::thread> consumers;
+    for (unsigned int c = 0; c < consumerCount; ++c)
+    {
+        consumers.emplace_back([&]{
+            for (unsigned int i = 0; i < (producerCount * itemsPerProducer) / consumerCount; ++i)
+            {
+                unsigned int *item = queue.pop();
+                seen[*item]++;
+            }
+        });
+    }
+
+    for (unsigned int p = 0; p < producerCount; ++p)
+    {
+        producers[p].join();
+    }
+
+    for (unsigned int c = 0; c < consumerCount; ++c)
+    {
+        consumers[c].join();
+    }
+
+    for (unsigned int i = 0; i < seen.size(); ++i)
+    {
+        QVERIFY(seen[i] == 1);
+    }
+
+    QVERIFY(queue.tryPop() == nullptr);
+
+    for (unsigned int i = 0; i < queue.capacity(); ++i)
+    {
+        QVERIFY(queue.tryPush(&items[i]));
+    }
+    QVERIFY(!queue.tryPush(&items[0]));
+
+    for (unsigned int i = 0; i < queue.capacity(); ++i)
+    {
+        QVERIFY(queue.tryPop() == &items[i]);
+    }
+}
+
+template<typename QueueType>
+static double pingPongLatency(QueueType &request, QueueType &reply, unsigned int roundTrips)
+{
+    unsigned int token = 0;
+
+    std::thread worker([&]{
+        for (unsigned int i = 0; i < roundTrips; ++i)
+        {
+            reply.push(request.pop());
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < roundTrips; ++i)
+    {
+        request.push(&token);
+        reply.pop();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    worker.join();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / roundTrips;
+}
+
+void FreeWillUnitTest::ringbufferBenchmark()
+{
+    const unsigned int roundTrips = 20000;
+
+    FreeWill::Ringbuffer<unsigned int> request(100);
+    FreeWill::Ringbuffer<unsigned int> reply(100);
+    double semaphoreLatency = pingPongLatency(request, reply, roundTrips);
+
+    FreeWill::LockFreeRingbuffer<unsigned int> lockFreeRequest(128);
+    FreeWill::LockFreeRingbuffer<unsigned int> lockFreeReply(128);
+    double lockFreeLatency = pingPongLatency(lockFreeRequest, lockFreeReply, roundTrips);
+
+    qDebug() << "round trip latency, semaphore ringbuffer:" << semaphoreLatency << "ns, lock free ringbuffer:" << lockFreeLatency << "ns";
+
+    QVERIFY(semaphoreLatency > 0 && lockFreeLatency > 0);
+}
+
+void FreeWillUnitTest::workStealingDequeTest()
+{
+    const unsigned int itemCount = 50000;
+    const unsigned int thiefCount = 3;
+
+    //small initial capacity so the owner has to grow the buffer while thieves read it
+    FreeWill::WorkStealingDeque<unsigned int> deque(4);
+
+    std::vector<unsigned int> items(itemCount);
+    std::vector<std::atomic<unsigned int>> seen(itemCount);
+    for (unsigned int i = 0; i < itemCount; ++i)
+    {
+        items[i] = i;
+        seen[i] = 0;
+    }
+
+    std::atomic<unsigned int> taken(0);
+    std::atomic<bool> ownerFinished(false);
+
+    std::vector<std::thread> thieves;
+    for (unsigned int t = 0; t < thiefCount; ++t)
+    {
+        thieves.emplace_back([&]{
+            while (!ownerFinished || !deque.empty())
+            {
+                unsigned int *item = deque.steal();
+                if (item)
+                {
+                    seen[*item]++;
+                    taken++;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (unsigned int i = 0; i < itemCount; ++i)
+    {
+        deque.push(&items[i]);
+
+        if (i % 3 == 0)
+        {
+            unsigned int *item = deque.pop();
+            if (item)
+            {
+                seen[*item]++;
+                taken++;
+            }
+        }
+    }
+
+    unsigned int *item = nullptr;
+    while ((item = deque.pop()))
+    {
+        seen[*item]++;
+        taken++;
+    }
+
+    ownerFinished = true;
+
+    for (unsigned int t = 0; t < thiefCount; ++t)
+    {
+        thieves[t].join();
+    }
+
+    QVERIFY(taken == itemCount);
+
+    for (unsigned int i = 0; i < itemCount; ++i)
+    {
+        QVERIFY(seen[i] == 1);
+    }
+}
+
+namespace
+{
+    class RecordThreadOperator : public FreeWill::Operator<FreeWill::DeviceType::CPU_NAIVE>
+    {
+    public:
+        std::mutex *m_threadIdsLock;
+        std::set<std::thread::id> *m_threadIds;
+        std::atomic<unsigned int> *m_evaluateCount;
+
+        RecordThreadOperator()
+            :FreeWill::Operator<FreeWill::DeviceType::CPU_NAIVE>({}, {}),
+              m_threadIdsLock(nullptr),
+              m_threadIds(nullptr),
+              m_evaluateCount(nullptr)
+        {}
+
+        virtual bool init() override
+        {
+            return true;
+        }
+
+        virtual void evaluate() override
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+            {
+                std::lock_guard<std::mutex> lock(*m_threadIdsLock);
+                m_threadIds->insert(std::this_thread::get_id());
+            }
+
+            (*m_evaluateCount)++;
+        }
+    };
+}
+
+void FreeWillUnitTest::workStealingSchedulerTest()
+{
+    const unsigned int workerCount = 4;
+    const unsigned int messageCount = 200;
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().open(workerCount);
+
+    std::mutex threadIdsLock;
+    std::set<std::thread::id> threadIds;
+    std::atomic<unsigned int> evaluateCount(0);
+
+    RecordThreadOperator recordThread;
+    recordThread.m_threadIdsLock = &threadIdsLock;
+    recordThread.m_threadIds = &threadIds;
+    recordThread.m_evaluateCount = &evaluateCount;
+
+    std::vector<FreeWill::WorkerMessage*> messages;
+
+    //everything goes to device 0, the other workers only get work by stealing
+    for (unsigned int i = 0; i < messageCount; ++i)
+    {
+        FreeWill::WorkerMessage *message = new FreeWill::WorkerMessage(FreeWill::WorkerMessage::Type::FORWARD, &recordThread);
+        messages.push_back(message);
+        FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().pushWork(0, message);
+    }
+
+    for (unsigned int i = 0; i < messageCount; ++i)
+    {
+        FreeWill::WorkerMessage *message = new FreeWill::WorkerMessage(FreeWill::WorkerMessage::Type::FORWARD, &recordThread);
+        messages.push_back(message);
+        FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().spawn(message);
+    }
+
+    for (unsigned int i = 0; i < messages.size(); ++i)
+    {
+        messages[i]->join();
+        delete messages[i];
+    }
+
+    QVERIFY(evaluateCount == messageCount * 2);
+    QVERIFY(threadIds.size() > 1);
+    QVERIFY(threadIds.find(std::this_thread::get_id()) == threadIds.end());
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().close();
+}
+
+void FreeWillUnitTest::workerMessageReuseTest()
+{
+    const unsigned int workerCount = 4;
+    const unsigned int roundCount = 500;
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().open(workerCount);
+
+    std::mutex threadIdsLock;
+    std::set<std::thread::id> threadIds;
+    std::atomic<unsigned int> evaluateCount(0);
+
+    RecordThreadOperator recordThread;
+    recordThread.m_threadIdsLock = &threadIdsLock;
+    recordThread.m_threadIds = &threadIds;
+    recordThread.m_evaluateCount = &evaluateCount;
+
+    std::vector<FreeWill::WorkerMessage*> messages;
+
+    for (unsigned int e = 0; e < workerCount; ++e)
+    {
+        messages.push_back(new FreeWill::WorkerMessage(FreeWill::WorkerMessage::Type::FORWARD, &recordThread));
+    }
+
+    //the same messages go round and round, join must not return early on a reset message
+    for (unsigned int round = 0; round < roundCount; ++round)
+    {
+        for (unsigned int e = 0; e < workerCount; ++e)
+        {
+            messages[e]->reset();
+            FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().pushWork(e, messages[e]);
+        }
+
+        for (unsigned int e = 0; e < workerCount; ++e)
+        {
+            messages[e]->join();
+        }
+
+        QVERIFY(evaluateCount == (round + 1) * workerCount);
+    }
+
+    for (unsigned int e = 0; e < workerCount; ++e)
+    {
+        delete messages[e];
+    }
+
+    //parallelFor helpers come from the context's pool, hammer it and check nothing gets lost
+    std::vector<unsigned int> hits(1024, 0);
+
+    for (unsigned int round = 0; round < roundCount; ++round)
+    {
+        FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().parallelFor(0, hits.size(), [&](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                hits[i]++;
+            }
+        }, 16);
+    }
+
+    for (unsigned int i = 0; i < hits.size(); ++i)
+    {
+        QVERIFY(hits[i] == roundCount);
+    }
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().close();
+}
+
+namespace
+{
+    struct ParallelForOperators
+    {
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_input;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_featureMap;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_bias;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_convolutionOutput;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_inputGrad;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_featureMapGrad;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_biasGrad;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_poolingOutput;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, unsigned int> m_switchX;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, unsigned int> m_switchY;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_dotProductInput;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_weight;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_dotProductBias;
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> m_dotProductOutput;
+
+        FreeWill::Convolution<FreeWill::DeviceType::CPU_NAIVE, float> m_convolution;
+        FreeWill::ConvolutionDerivative<FreeWill::DeviceType::CPU_NAIVE, float> m_convolutionDerivative;
+        FreeWill::MaxPooling<FreeWill::DeviceType::CPU_NAIVE, float> m_maxPooling;
+        FreeWill::DotProductWithBias<FreeWill::DeviceType::CPU_NAIVE, float> m_dotProductWithBias;
+
+        ParallelForOperators()
+            :m_input({3,8,8,5}),
+              m_featureMap({3,3,3,4}),
+              m_bias({4}),
+              m_convolutionOutput({4,8,8,5}),
+              m_inputGrad({3,8,8,5}),
+              m_featureMapGrad({3,3,3,4}),
+              m_biasGrad({4}),
+              m_poolingOutput({4,4,4,5}),
+              m_switchX({4,4,4,5}),
+              m_switchY({4,4,4,5}),
+              m_dotProductInput({256,5}),
+              m_weight({10,256}),
+              m_dotProductBias({10}),
+              m_dotProductOutput({10,5}),
+              m_convolution(1,1,1,1),
+              m_convolutionDerivative(1,1,1,1),
+              m_maxPooling(),
+              m_dotProductWithBias(true)
+        {
+            m_input.init();
+            m_featureMap.init();
+            m_bias.init();
+            m_convolutionOutput.init();
+            m_inputGrad.init();
+            m_featureMapGrad.init();
+            m_biasGrad.init();
+            m_poolingOutput.init();
+            m_switchX.init();
+            m_switchY.init();
+            m_dotProductInput.init();
+            m_weight.init();
+            m_dotProductBias.init();
+            m_dotProductOutput.init();
+
+            m_convolution.setInputParameter("Input", &m_input);
+            m_convolution.setInputParameter("FeatureMap", &m_featureMap);
+            m_convolution.setInputParameter("Bias", &m_bias);
+            m_convolution.setOutputParameter("Output", &m_convolutionOutput);
+
+            m_convolutionDerivative.setInputParameter("PrevActivation", &m_input);
+            m_convolutionDerivative.setInputParameter("FeatureMap", &m_featureMap);
+            m_convolutionDerivative.setInputParameter("OutputGrad", &m_convolutionOutput);
+            m_convolutionDerivative.setOutputParameter("InputGrad", &m_inputGrad);
+            m_convolutionDerivative.setOutputParameter("FeatureMapGrad", &m_featureMapGrad);
+            m_convolutionDerivative.setOutputParameter("BiasGrad", &m_biasGrad);
+
+            m_maxPooling.setInputParameter("Input", &m_convolutionOutput);
+            m_maxPooling.setOutputParameter("Output", &m_poolingOutput);
+            m_maxPooling.setOutputParameter("SwitchX", &m_switchX);
+            m_maxPooling.setOutputParameter("SwitchY", &m_switchY);
+
+            m_dotProductWithBias.setInputParameter("Input", &m_dotProductInput);
+            m_dotProductWithBias.setInputParameter("Weight", &m_weight);
+            m_dotProductWithBias.setInputParameter("Bias", &m_dotProductBias);
+            m_dotProductWithBias.setOutputParameter("Output", &m_dotProductOutput);
+        }
+
+        bool init()
+        {
+            return m_convolution.init() && m_convolutionDerivative.init() && m_maxPooling.init() && m_dotProductWithBias.init();
+        }
+
+        void copyParameters(ParallelForOperators &from)
+        {
+            for (unsigned int i = 0; i < m_input.shape().size(); ++i)
+            {
+                m_input[i] = from.m_input[i];
+            }
+
+            for (unsigned int i = 0; i < m_featureMap.shape().size(); ++i)
+            {
+                m_featureMap[i] = from.m_featureMap[i];
+            }
+
+            for (unsigned int i = 0; i < m_bias.shape().size(); ++i)
+            {
+                m_bias[i] = from.m_bias[i];
+            }
+
+            for (unsigned int i = 0; i < m_dotProductInput.shape().size(); ++i)
+            {
+                m_dotProductInput[i] = from.m_dotProductInput[i];
+            }
+
+            for (unsigned int i = 0; i < m_weight.shape().size(); ++i)
+            {
+                m_weight[i] = from.m_weight[i];
+            }
+
+            for (unsigned int i = 0; i < m_dotProductBias.shape().size(); ++i)
+            {
+                m_dotProductBias[i] = from.m_dotProductBias[i];
+            }
+        }
+
+        void evaluate()
+        {
+            m_convolution.evaluate();
+            m_maxPooling.evaluate();
+            m_dotProductWithBias.evaluate();
+            m_convolutionDerivative.evaluate();
+        }
+    };
+}
+
+void FreeWillUnitTest::parallelForTest()
+{
+    const unsigned int workerCount = 4;
+
+    //reference values with no pool open, parallelFor runs the loop inline
+    ParallelForOperators reference;
+    QVERIFY(reference.init());
+    reference.m_input.randomize();
+    reference.m_featureMap.randomize();
+    reference.m_bias.randomize();
+    reference.m_dotProductInput.randomize();
+    reference.m_weight.randomize();
+    reference.m_dotProductBias.randomize();
+    reference.evaluate();
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().open(workerCount);
+
+    std::vector<std::atomic<unsigned int>> visits(10000);
+    for (unsigned int i = 0; i < visits.size(); ++i)
+    {
+        visits[i] = 0;
+    }
+
+    //the outer chunks run on workers, so the inner calls exercise the nested path
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().parallelFor(0, 100, [&](unsigned int outerBegin, unsigned int outerEnd)
+    {
+        for (unsigned int outer = outerBegin; outer < outerEnd; ++outer)
+        {
+            FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().parallelFor(0, 100, [&](unsigned int innerBegin, unsigned int innerEnd)
+            {
+                for (unsigned int inner = innerBegin; inner < innerEnd; ++inner)
+                {
+                    visits[outer * 100 + inner]++;
+                }
+            });
+        }
+    });
+
+    for (unsigned int i = 0; i < visits.size(); ++i)
+    {
+        QVERIFY(visits[i] == 1);
+    }
+
+    ParallelForOperators parallel;
+    QVERIFY(parallel.init());
+    parallel.copyParameters(reference);
+    parallel.evaluate();
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().close();
+
+    for (unsigned int i = 0; i < reference.m_convolutionOutput.shape().size(); ++i)
+    {
+        QVERIFY(std::abs(reference.m_convolutionOutput[i] - parallel.m_convolutionOutput[i]) < epsilon);
+    }
+
+    for (unsigned int i = 0; i < reference.m_poolingOutput.shape().size(); ++i)
+    {
+        QVERIFY(std::abs(reference.m_poolingOutput[i] - parallel.m_poolingOutput[i]) < epsilon);
+        QVERIFY(reference.m_switchX[i] == parallel.m_switchX[i]);
+        QVERIFY(reference.m_switchY[i] == parallel.m_switchY[i]);
+    }
+
+    for (unsigned int i = 0; i < reference.m_dotProductOutput.shape().size(); ++i)
+    {
+        QVERIFY(std::abs(reference.m_dotProductOutput[i] - parallel.m_dotProductOutput[i]) < epsilon);
+    }
+
+    for (unsigned int i = 0; i < reference.m_inputGrad.shape().size(); ++i)
+    {
+        QVERIFY(std::abs(reference.m_inputGrad[i] - parallel.m_inputGrad[i]) < epsilon);
+    }
+
+    for (unsigned int i = 0; i < reference.m_featureMapGrad.shape().size(); ++i)
+    {
+        QVERIFY(std::abs(reference.m_featureMapGrad[i] - parallel.m_featureMapGrad[i]) < epsilon);
+    }
+
+    for (unsigned int i = 0; i < reference.m_biasGrad.shape().size(); ++i)
+    {
+        QVERIFY(std::abs(reference.m_biasGrad[i] - parallel.m_biasGrad[i]) < epsilon);
+    }
+}
+
+static void writeSysfsFile(const std::string &root, const std::string &path, const std::string &content)
+{
+    std::string directory = root;
+    std::size_t start = 0;
+    std::size_t slash = 0;
+
+    while ((slash = path.find('/', start)) != std::string::npos)
+    {
+        directory += "/" + path.substr(start, slash - start);
+        mkdir(directory.c_str(), 0755);
+        start = slash + 1;
+    }
+
+    std::ofstream file(root + "/" + path);
+    file << content << std::endl;
+}
+
+void FreeWillUnitTest::cpuTopologyTest()
+{
+    //two sockets, two cores each with two hyperthreads, cpu n and n+4 share a core
+    char rootTemplate[] = "/tmp/freewill_sysfs_XXXXXX";
+    QVERIFY(mkdtemp(rootTemplate) != nullptr);
+    std::string root = rootTemplate;
+
+    writeSysfsFile(root, "cpu/online", "0-7");
+    for (unsigned int cpu = 0; cpu < 8; ++cpu)
+    {
+        std::string topology = "cpu/cpu" + std::to_string(cpu) + "/topology/";
+        writeSysfsFile(root, topology + "core_id", std::to_string(cpu % 2));
+        writeSysfsFile(root, topology + "physical_package_id", std::to_string((cpu % 4) / 2));
+    }
+    writeSysfsFile(root, "node/node0/cpulist", "0-1,4-5");
+    writeSysfsFile(root, "node/node1/cpulist", "2-3,6-7");
+
+    FreeWill::CpuTopology topology;
+    QVERIFY(topology.discover(root));
+    QVERIFY(topology.cpus().size() == 8);
+    QVERIFY(topology.numaNodeCount() == 2);
+
+    std::vector<FreeWill::LogicalCpu> order = topology.pinningOrder();
+    const unsigned int expectedOrder[] = {0, 1, 2, 3, 4, 5, 6, 7};
+    const unsigned int expectedNodes[] = {0, 0, 1, 1, 0, 0, 1, 1};
+
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        QVERIFY(order[i].m_cpuId == expectedOrder[i]);
+        QVERIFY(order[i].m_numaNode == expectedNodes[i]);
+        QVERIFY(order[i].m_isFirstOnCore == (i < 4));
+    }
+
+    std::system(("rm -rf " + root).c_str());
+
+    //missing sysfs falls back to one node
+    QVERIFY(!topology.discover(root));
+    QVERIFY(topology.cpus().size() >= 1);
+    QVERIFY(topology.numaNodeCount() == 1);
+
+    //pinned workers, runOnDevice has to land on the owning worker's thread
+    const unsigned int workerCount = 4;
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().setThreadPinning(true);
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().open(workerCount);
+
+    for (unsigned int e = 0; e < workerCount; ++e)
+    {
+        FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE> *worker = nullptr;
+        int cpu = -1;
+
+        FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().runOnDevice(e, [&]()
+        {
+            worker = FreeWill::Device<FreeWill::DeviceType::CPU_NAIVE>::currentWorker();
+            cpu = sched_getcpu();
+        });
+
+        QVERIFY(worker != nullptr);
+        QVERIFY(worker->deviceId() == e);
+        QVERIFY(worker->cpuId() >= 0);
+        QVERIFY(cpu == worker->cpuId());
+    }
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().close();
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().setThreadPinning(false);
+}
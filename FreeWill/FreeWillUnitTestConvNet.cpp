@@ -5,6 +5,8 @@
 #include "Operator/CrossEntropyLoss.h"
 #include "Operator/SigmoidCrossEntropyLossDerivative.h"
 #include "Operator/ActivationDerivative.h"
+#include "Operator/Fft.h"
+#include <chrono>
 
 
 void FreeWillUnitTest::convolutionTest()
@@ -325,6 +327,391 @@ void FreeWillUnitTest::convolutionTestGPU()
 
 }
 
+template<typename DataType>
+static bool compareConvolutionAlgorithms(unsigned int channelCount, unsigned int width, unsigned int height, unsigned int batchSize,
+                                         unsigned int filterSize, unsigned int filterCount,
+                                         unsigned int stride, unsigned int zeroPadding, FreeWill::ConvolutionAlgorithm algorithm)
+{
+    unsigned int newWidth = (width - filterSize + 2 * zeroPadding) / stride + 1;
+    unsigned int newHeight = (height - filterSize + 2 * zeroPadding) / stride + 1;
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> input({channelCount, width, height, batchSize});
+    input.init();
+    input.randomize();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> featureMap({channelCount, filterSize, filterSize, filterCount});
+    featureMap.init();
+    featureMap.randomize();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> bias({filterCount});
+    bias.init();
+    bias.randomize();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> reference({filterCount, newWidth, newHeight, batchSize});
+    reference.init();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> output({filterCount, newWidth, newHeight, batchSize});
+    output.init();
+
+    //both add to what is in the output
+    for (unsigned int i = 0; i < output.shape().size(); ++i)
+    {
+        reference[i] = output[i] = (DataType) i / output.shape().size();
+    }
+
+    FreeWill::Convolution<FreeWill::DeviceType::CPU_NAIVE, DataType> direct(stride, stride, zeroPadding, zeroPadding);
+    direct.setAlgorithm(FreeWill::ConvolutionAlgorithm::DIRECT);
+    direct.setInputParameter("Input", &input);
+    direct.setInputParameter("FeatureMap", &featureMap);
+    direct.setInputParameter("Bias", &bias);
+    direct.setOutputParameter("Output", &reference);
+
+    FreeWill::Convolution<FreeWill::DeviceType::CPU_NAIVE, DataType> convolution(stride, stride, zeroPadding, zeroPadding);
+    convolution.setAlgorithm(algorithm);
+    convolution.setInputParameter("Input", &input);
+    convolution.setInputParameter("FeatureMap", &featureMap);
+    convolution.setInputParameter("Bias", &bias);
+    convolution.setOutputParameter("Output", &output);
+
+    if (!direct.init() || !convolution.init())
+    {
+        return false;
+    }
+
+    direct.evaluate();
+    convolution.evaluate();
+
+    for (unsigned int i = 0; i < output.shape().size(); ++i)
+    {
+        if (std::abs(output[i] - reference[i]) > 1e-4 * (channelCount * filterSize * filterSize))
+        {
+            qDebug() << "convolution" << channelCount << width << height << filterSize << filterCount << stride << zeroPadding
+                     << "element" << i << output[i] << "reference" << reference[i];
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename DataType>
+static bool compareInputGradAlgorithms(unsigned int channelCount, unsigned int width, unsigned int height, unsigned int batchSize,
+                                       unsigned int filterCount, unsigned int zeroPadding, FreeWill::ConvolutionAlgorithm algorithm)
+{
+    unsigned int newWidth = width - 3 + 2 * zeroPadding + 1;
+    unsigned int newHeight = height - 3 + 2 * zeroPadding + 1;
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> prevActivation({channelCount, width, height, batchSize});
+    prevActivation.init();
+    prevActivation.randomize();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> featureMap({channelCount, 3, 3, filterCount});
+    featureMap.init();
+    featureMap.randomize();
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> outputGrad({filterCount, newWidth, newHeight, batchSize});
+    outputGrad.init();
+    outputGrad.randomize();
+
+    std::vector<DataType> inputGrads[2];
+    std::vector<DataType> featureMapGrads[2];
+
+    const FreeWill::ConvolutionAlgorithm algorithms[2] = {FreeWill::ConvolutionAlgorithm::DIRECT, algorithm};
+
+    for (unsigned int a = 0; a < 2; ++a)
+    {
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> featureMapGrad({channelCount, 3, 3, filterCount});
+        featureMapGrad.init();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> biasGrad({filterCount});
+        biasGrad.init();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, DataType> inputGrad({channelCount, width, height, batchSize});
+        inputGrad.init();
+
+        FreeWill::ConvolutionDerivative<FreeWill::DeviceType::CPU_NAIVE, DataType> convolutionDerivative(1, 1, zeroPadding, zeroPadding);
+        convolutionDerivative.setAlgorithm(algorithms[a]);
+        convolutionDerivative.setInputParameter("PrevActivation", &prevActivation);
+        convolutionDerivative.setInputParameter("FeatureMap", &featureMap);
+        convolutionDerivative.setInputParameter("OutputGrad", &outputGrad);
+        convolutionDerivative.setOutputParameter("FeatureMapGrad", &featureMapGrad);
+        convolutionDerivative.setOutputParameter("BiasGrad", &biasGrad);
+        convolutionDerivative.setOutputParameter("InputGrad", &inputGrad);
+
+        if (!convolutionDerivative.init())
+        {
+            return false;
+        }
+
+        convolutionDerivative.evaluate();
+
+        inputGrads[a].assign(inputGrad.cpuDataHandle(), inputGrad.cpuDataHandle() + inputGrad.shape().size());
+        featureMapGrads[a].assign(featureMapGrad.cpuDataHandle(), featureMapGrad.cpuDataHandle() + featureMapGrad.shape().size());
+    }
+
+    for (unsigned int i = 0; i < inputGrads[0].size(); ++i)
+    {
+        if (std::abs(inputGrads[1][i] - inputGrads[0][i]) > 1e-4 * (filterCount * 9))
+        {
+            qDebug() << "input grad" << channelCount << width << height << filterCount << zeroPadding
+                     << "element" << i << inputGrads[1][i] << "reference" << inputGrads[0][i];
+            return false;
+        }
+    }
+
+    //the FeatureMapGrad loop is the same for every algorithm
+    if (featureMapGrads[1] != featureMapGrads[0])
+    {
+        return false;
+    }
+
+    return true;
+}
+
+void FreeWillUnitTest::convolutionAlgorithmTest()
+{
+    //channels, width, height, batch, filter size, filter count, stride, zero padding
+    const unsigned int shapes[][8] = {{3, 5, 5, 1, 3, 2, 2, 1},
+                                      {1, 28, 28, 2, 5, 20, 1, 0},
+                                      {4, 9, 7, 3, 3, 5, 1, 1},
+                                      {8, 6, 6, 2, 1, 16, 1, 0},
+                                      {2, 12, 12, 1, 4, 7, 3, 2},
+                                      {5, 7, 7, 2, 3, 33, 2, 4},
+                                      {16, 12, 12, 1, 3, 24, 1, 1}};
+
+    //the Winograd and FFT ones fall back to DIRECT on the shapes they can't run
+    const FreeWill::ConvolutionAlgorithm algorithms[] = {FreeWill::ConvolutionAlgorithm::GEMM, FreeWill::ConvolutionAlgorithm::WINOGRAD_2X2,
+                                                         FreeWill::ConvolutionAlgorithm::WINOGRAD_4X4, FreeWill::ConvolutionAlgorithm::FFT,
+                                                         FreeWill::ConvolutionAlgorithm::AUTO};
+
+    for (const auto &shape : shapes)
+    {
+        for (FreeWill::ConvolutionAlgorithm algorithm : algorithms)
+        {
+            QVERIFY(compareConvolutionAlgorithms<float>(shape[0], shape[1], shape[2], shape[3], shape[4], shape[5], shape[6], shape[7], algorithm));
+            QVERIFY(compareConvolutionAlgorithms<double>(shape[0], shape[1], shape[2], shape[3], shape[4], shape[5], shape[6], shape[7], algorithm));
+        }
+    }
+
+    //3x3 at stride 1, tiles cut by the edge, padding 0 to 2
+    const unsigned int winogradShapes[][8] = {{8, 10, 10, 2, 3, 8, 1, 1},
+                                              {3, 7, 9, 1, 3, 5, 1, 0},
+                                              {16, 13, 11, 2, 3, 12, 1, 2},
+                                              {9, 5, 5, 3, 3, 17, 1, 1}};
+
+    for (const auto &shape : winogradShapes)
+    {
+        for (FreeWill::ConvolutionAlgorithm algorithm : algorithms)
+        {
+            QVERIFY(compareConvolutionAlgorithms<float>(shape[0], shape[1], shape[2], shape[3], shape[4], shape[5], shape[6], shape[7], algorithm));
+            QVERIFY(compareConvolutionAlgorithms<double>(shape[0], shape[1], shape[2], shape[3], shape[4], shape[5], shape[6], shape[7], algorithm));
+            QVERIFY(compareInputGradAlgorithms<float>(shape[0], shape[1], shape[2], shape[3], shape[5], shape[7], algorithm));
+            QVERIFY(compareInputGradAlgorithms<double>(shape[0], shape[1], shape[2], shape[3], shape[5], shape[7], algorithm));
+        }
+    }
+
+    //the FFT against the plain DFT, on sizes of every radix and of the generic butterfly, three transforms at once
+    for (unsigned int size : {1u, 6u, 16u, 30u, 50u, 14u, 11u})
+    {
+        const unsigned int batchSize = 3;
+        std::vector<double> real(size * batchSize);
+        std::vector<double> imaginary(size * batchSize);
+
+        for (unsigned int i = 0; i < size * batchSize; ++i)
+        {
+            real[i] = std::sin(i * 0.7);
+            imaginary[i] = std::cos(i * 1.3);
+        }
+
+        std::vector<double> spectrumReal = real;
+        std::vector<double> spectrumImaginary = imaginary;
+        std::vector<double> scratchReal(size * batchSize);
+        std::vector<double> scratchImaginary(size * batchSize);
+
+        FreeWill::Fft<double> fft(size);
+        fft.transform(spectrumReal.data(), spectrumImaginary.data(), scratchReal.data(), scratchImaginary.data(), batchSize, false);
+
+        for (unsigned int r = 0; r < batchSize; ++r)
+        {
+            for (unsigned int k = 0; k < size; ++k)
+            {
+                double sumReal = 0;
+                double sumImaginary = 0;
+
+                for (unsigned int n = 0; n < size; ++n)
+                {
+                    double angle = -2.0 * M_PI * n * k / size;
+                    sumReal += real[r + batchSize * n] * std::cos(angle) - imaginary[r + batchSize * n] * std::sin(angle);
+                    sumImaginary += real[r + batchSize * n] * std::sin(angle) + imaginary[r + batchSize * n] * std::cos(angle);
+                }
+
+                QVERIFY(std::abs(spectrumReal[r + batchSize * k] - sumReal) < epsilon);
+                QVERIFY(std::abs(spectrumImaginary[r + batchSize * k] - sumImaginary) < epsilon);
+            }
+        }
+
+        fft.transform(spectrumReal.data(), spectrumImaginary.data(), scratchReal.data(), scratchImaginary.data(), batchSize, true);
+
+        for (unsigned int i = 0; i < size * batchSize; ++i)
+        {
+            QVERIFY(std::abs(spectrumReal[i] / size - real[i]) < epsilon);
+            QVERIFY(std::abs(spectrumImaginary[i] / size - imaginary[i]) < epsilon);
+        }
+    }
+
+    //large filters at stride 1, one tile and several, padding up to the filter
+    const unsigned int fftShapes[][8] = {{4, 20, 17, 2, 5, 6, 1, 0},
+                                         {3, 70, 66, 2, 7, 5, 1, 3},
+                                         {2, 9, 9, 1, 9, 3, 1, 8},
+                                         {1, 130, 40, 1, 11, 2, 1, 5},
+                                         {4, 40, 36, 1, 5, 3, 1, 2}};
+
+    for (const auto &shape : fftShapes)
+    {
+        QVERIFY(compareConvolutionAlgorithms<float>(shape[0], shape[1], shape[2], shape[3], shape[4], shape[5], shape[6], shape[7],
+                                                    FreeWill::ConvolutionAlgorithm::FFT));
+        QVERIFY(compareConvolutionAlgorithms<double>(shape[0], shape[1], shape[2], shape[3], shape[4], shape[5], shape[6], shape[7],
+                                                     FreeWill::ConvolutionAlgorithm::FFT));
+        QVERIFY(compareConvolutionAlgorithms<float>(shape[0], shape[1], shape[2], shape[3], shape[4], shape[5], shape[6], shape[7],
+                                                    FreeWill::ConvolutionAlgorithm::AUTO));
+    }
+
+    //the cached filter transforms follow the filter
+    for (FreeWill::ConvolutionAlgorithm algorithm : {FreeWill::ConvolutionAlgorithm::WINOGRAD_4X4, FreeWill::ConvolutionAlgorithm::FFT})
+    {
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, double> input({8, 6, 6, 1});
+        input.init();
+        input.randomize();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, double> featureMap({8, 3, 3, 8});
+        featureMap.init();
+        featureMap.randomize();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, double> bias({8});
+        bias.init();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, double> output({8, 6, 6, 1});
+        output.init();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, double> reference({8, 6, 6, 1});
+        reference.init();
+
+        FreeWill::Convolution<FreeWill::DeviceType::CPU_NAIVE, double> cached(1, 1, 1, 1);
+        cached.setAlgorithm(algorithm);
+        cached.setInputParameter("Input", &input);
+        cached.setInputParameter("FeatureMap", &featureMap);
+        cached.setInputParameter("Bias", &bias);
+        cached.setOutputParameter("Output", &output);
+        QVERIFY(cached.init());
+
+        FreeWill::Convolution<FreeWill::DeviceType::CPU_NAIVE, double> direct(1, 1, 1, 1);
+        direct.setAlgorithm(FreeWill::ConvolutionAlgorithm::DIRECT);
+        direct.setInputParameter("Input", &input);
+        direct.setInputParameter("FeatureMap", &featureMap);
+        direct.setInputParameter("Bias", &bias);
+        direct.setOutputParameter("Output", &reference);
+        QVERIFY(direct.init());
+
+        for (unsigned int step = 0; step < 3; ++step)
+        {
+            featureMap[step * 7] += 0.5;
+
+            output.clear();
+            reference.clear();
+            cached.evaluate();
+            direct.evaluate();
+
+            for (unsigned int i = 0; i < output.shape().size(); ++i)
+            {
+                QVERIFY(std::abs(output[i] - reference[i]) < epsilon);
+            }
+        }
+    }
+
+}
+
+void FreeWillUnitTest::convolutionAlgorithmBenchmark()
+{
+    //the convolution of the MNIST conv net, 3x3 layers and larger filters on larger images
+    const unsigned int benchmarkShapes[][6] = {{1, 28, 5, 20, 0, 50}, {32, 28, 3, 32, 1, 5}, {128, 14, 3, 128, 1, 3},
+                                               {16, 64, 7, 16, 3, 5}, {32, 56, 7, 32, 3, 3}, {3, 128, 11, 16, 5, 3}};
+    const FreeWill::ConvolutionAlgorithm benchmarkAlgorithms[] = {FreeWill::ConvolutionAlgorithm::DIRECT, FreeWill::ConvolutionAlgorithm::GEMM,
+                                                                  FreeWill::ConvolutionAlgorithm::WINOGRAD_2X2, FreeWill::ConvolutionAlgorithm::WINOGRAD_4X4,
+                                                                  FreeWill::ConvolutionAlgorithm::FFT};
+    const char *algorithmNames[] = {"direct", "gemm", "winograd 2x2", "winograd 4x4", "fft"};
+    const unsigned int batchSize = 2;
+
+    for (const auto &shape : benchmarkShapes)
+    {
+        unsigned int channelCount = shape[0];
+        unsigned int imageSize = shape[1];
+        unsigned int filterSize = shape[2];
+        unsigned int filterCount = shape[3];
+        unsigned int zeroPadding = shape[4];
+        unsigned int repeatCount = shape[5];
+        unsigned int newSize = imageSize - filterSize + 2 * zeroPadding + 1;
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> image({channelCount, imageSize, imageSize, batchSize});
+        image.init();
+        image.randomize();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> featureMap({channelCount, filterSize, filterSize, filterCount});
+        featureMap.init();
+        featureMap.randomize();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> bias({filterCount});
+        bias.init();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> output({filterCount, newSize, newSize, batchSize});
+        output.init();
+
+        //what DIRECT computed, the others have to agree with it
+        std::vector<float> reference(output.shape().size());
+
+        for (unsigned int a = 0; a < 5; ++a)
+        {
+            if (filterSize != 3 && (a == 2 || a == 3))
+            {
+                continue;
+            }
+
+            FreeWill::Convolution<FreeWill::DeviceType::CPU_NAIVE, float> convolution(1, 1, zeroPadding, zeroPadding);
+            convolution.setAlgorithm(benchmarkAlgorithms[a]);
+            convolution.setInputParameter("Input", &image);
+            convolution.setInputParameter("FeatureMap", &featureMap);
+            convolution.setInputParameter("Bias", &bias);
+            convolution.setOutputParameter("Output", &output);
+            QVERIFY(convolution.init());
+
+            auto startTime = std::chrono::steady_clock::now();
+
+            for (unsigned int r = 0; r < repeatCount; ++r)
+            {
+                output.clear();
+                convolution.evaluate();
+            }
+
+            auto endTime = std::chrono::steady_clock::now();
+
+            qDebug() << channelCount << "x" << imageSize << "x" << imageSize << "," << filterCount << filterSize << "x" << filterSize
+                     << "filters," << algorithmNames[a] << ":"
+                     << std::chrono::duration<double, std::micro>(endTime - startTime).count() / repeatCount << "us";
+
+            for (unsigned int i = 0; i < output.shape().size(); ++i)
+            {
+                if (a == 0)
+                {
+                    reference[i] = output[i];
+                }
+                else
+                {
+                    QVERIFY(std::abs(output[i] - reference[i]) <= 1e-4 * (channelCount * filterSize * filterSize));
+                }
+            }
+        }
+    }
+}
+
 void FreeWillUnitTest::convolutionDerivativeTest()
 {
     FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, double> prevActivaion({3,5,5,1});
@@ -13,8 +13,16 @@
 #include "Operator/SoftmaxLogLossDerivative.h"
 #include "Operator/MaxPooling.h"
 #include "Operator/MaxPoolingDerivative.h"
+#include "Operator/Convolution.h"
+#include "Operator/QuantizedConvolution.h"
 #include "Model/Model.h"
 #include "Model/Solver.h"
+#include "Context/Completion.h"
+#include <chrono>
+#include <set>
+#include <cmath>
+#include <thread>
+#include <algorithm>
 
 void FreeWillUnitTest::modelXORTest()
 {
@@ -107,12 +115,6 @@ void FreeWillUnitTest::modelXORTest()
     {
         solver.forward(model);
 
-
-        model->clearTensor(firstLayerWeightDerivative);
-        model->clearTensor(secondLayerWeightDerivative);
-        model->clearTensor(firstLayerBiasDerivative);
-        model->clearTensor(secondLayerBiasDerivative);
-
         solver.backward(model);
 
         if (i%500000 == 0 && i!=0)
@@ -136,3 +138,1030 @@ void FreeWillUnitTest::modelXORTest()
         std::cout << "test " << i << ": a " << inputDataRO[i*2] << " b " << inputDataRO[i*2+1] << " c " << labelDataRO[i] << " nn result: " << resultDataRO[i] << std::endl;
     }
 }
+
+void FreeWillUnitTest::executionGraphTest()
+{
+    const unsigned int deviceCount = 3;
+    const unsigned int batchSize = 2;
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().open(deviceCount);
+
+    const FreeWill::ExecutionMode executionModes[] = {FreeWill::ExecutionMode::GRAPH, FreeWill::ExecutionMode::COMMAND_LIST, FreeWill::ExecutionMode::PIPELINE};
+    unsigned long defaultInlineWorkThreshold = FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().inlineWorkThreshold();
+    //these operators are tiny, the default threshold runs them all on this thread
+    const unsigned long inlineWorkThresholds[] = {0, defaultInlineWorkThreshold};
+
+    //one run loads weightB from a file
+    const char *weightPath = "FreeWillExecutionGraphTest.bin";
+    const float weightValues[12] = {0.5f, -0.25f, 0.125f, 0.3f, -0.6f, 0.2f, 0.1f, -0.1f, 0.7f, -0.4f, 0.05f, 0.9f};
+    FILE *weightFile = fopen(weightPath, "wb");
+    QVERIFY(weightFile);
+    QVERIFY(fwrite(weightValues, sizeof(float), 12, weightFile) == 12);
+    fclose(weightFile);
+
+    //every way of dispatching has to produce the same result, with and without inlining
+    for (unsigned int m = 0; m < 6; ++m)
+    {
+        FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().setInlineWorkThreshold(inlineWorkThresholds[m / 3]);
+
+        FreeWill::Model *model = FreeWill::Model::create();
+
+        //every other run the devices' inputs are slices of one host batch
+        bool isSliced = (m % 2) == 1;
+        FreeWill::TensorDescriptorHandle input = model->addTensor("input", {4}).enableBatch();
+
+        if (isSliced)
+        {
+            input.enableBatchSlicing();
+        }
+
+        FreeWill::TensorDescriptorHandle branchA = model->addTensor("branchA", {3}).enableBatch();
+        FreeWill::TensorDescriptorHandle branchB = model->addTensor("branchB", {3}).enableBatch();
+        FreeWill::TensorDescriptorHandle sum = model->addTensor("sum", {3}).enableBatch();
+        FreeWill::TensorDescriptorHandle weightA = model->addTensor("weightA", {3,4}).randomize();
+        FreeWill::TensorDescriptorHandle biasA = model->addTensor("biasA", {3}).randomize();
+        FreeWill::TensorDescriptorHandle weightB = model->addTensor("weightB", {3,4}).randomize();
+
+        if (m == 2)
+        {
+            weightB.mapFile(weightPath);
+        }
+        FreeWill::TensorDescriptorHandle biasB = model->addTensor("biasB", {3}).randomize();
+        FreeWill::TensorDescriptorHandle weightAGrad = model->addTensor("weightAGrad", {3,4});
+
+        //two independent branches joined by an add, listed interleaved on purpose
+        FreeWill::OperatorDescriptorHandle fullyConnectedA = model->addOperator("fullyConnectedA", FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS,
+                            {{"Input", input}, {"Weight", weightA}, {"Bias", biasA}},
+                            {{"Output", branchA}});
+        FreeWill::OperatorDescriptorHandle fullyConnectedB = model->addOperator("fullyConnectedB", FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS,
+                            {{"Input", input}, {"Weight", weightB}, {"Bias", biasB}},
+                            {{"Output", branchB}});
+        FreeWill::OperatorDescriptorHandle sigmoidA = model->addOperator("sigmoidA", FreeWill::OperatorName::ACTIVATION,
+                            {{"Input", branchA}},
+                            {{"Output", branchA}},
+                            {{"Mode", FreeWill::ActivationMode::SIGMOID}});
+        FreeWill::OperatorDescriptorHandle add = model->addOperator("add", FreeWill::OperatorName::ELEMENTWISE_ADD,
+                            {{"OperandA", branchA}, {"OperandB", branchB}},
+                            {{"Result", sum}});
+
+        model->defineForwardPath({fullyConnectedA, fullyConnectedB, sigmoidA, add});
+        model->defineBackwardPath({});
+        model->defineWeightUpdatePairs({{weightA, weightAGrad}});
+
+        FreeWill::Solver solver;
+        solver.m_deviceUsed = FreeWill::DeviceType::CPU_NAIVE;
+        solver.m_batchSize = batchSize;
+        solver.m_executionMode = executionModes[m % 3];
+        solver.m_sharedParameters = (m == 3);
+        model->setArenaAllocation(m >= 3);
+        QVERIFY(solver.init(model));
+
+        if (m >= 3)
+        {
+            QVERIFY(model->arena() != nullptr);
+            QVERIFY(model->arena()->used() <= model->arena()->capacity());
+
+            for (unsigned int d = 0; d < deviceCount; ++d)
+            {
+                QVERIFY(model->arena()->owns(model->readonlyAccess(input, d)));
+                QVERIFY(model->arena()->owns(model->readonlyAccess(weightA, d)));
+            }
+        }
+
+        if (m == 2)
+        {
+            for (unsigned int d = 0; d < deviceCount; ++d)
+            {
+                QVERIFY(std::equal(weightValues, weightValues + 12, model->readonlyAccess(weightB, d)));
+            }
+        }
+
+        //the pipeline keeps a single copy of the parameters that get updated,
+        //shared parameters one of every tensor no operator writes
+        for (unsigned int d = 1; d < deviceCount; ++d)
+        {
+            bool isShared = solver.m_executionMode == FreeWill::ExecutionMode::PIPELINE || solver.m_sharedParameters;
+            QVERIFY((model->readonlyAccess(weightA, d) == model->readonlyAccess(weightA, 0)) == isShared);
+            QVERIFY((model->readonlyAccess(biasA, d) == model->readonlyAccess(biasA, 0)) == solver.m_sharedParameters);
+            QVERIFY(model->readonlyAccess(weightAGrad, d) != model->readonlyAccess(weightAGrad, 0));
+            QVERIFY(model->readonlyAccess(sum, d) != model->readonlyAccess(sum, 0));
+        }
+
+        QVERIFY((model->beginMutateBatch(input) != nullptr) == isSliced);
+
+        for (unsigned int d = 0; d < deviceCount; ++d)
+        {
+            float *inputData = model->beginMutateData(input, d);
+
+            if (isSliced)
+            {
+                QVERIFY(inputData == model->beginMutateBatch(input) + d * 4 * batchSize);
+            }
+
+            for (unsigned int i = 0; i < 4 * batchSize; ++i)
+            {
+                inputData[i] = (float) (d + 1) * 0.1f * i - 0.3f;
+            }
+        }
+
+        //a sliced batch has no device 0 copy to broadcast
+        model->endMutateData(input);
+
+        //graph and command lists are set up once and replayed after that,
+        //the second round goes through the async api
+        for (unsigned int iteration = 0; iteration < 2; ++iteration)
+        {
+            if (iteration == 0)
+            {
+                solver.forward(model);
+            }
+            else
+            {
+                FreeWill::SolverStep step = solver.forwardAsync(model);
+                step.wait();
+                QVERIFY(step.isReady());
+            }
+
+            for (unsigned int d = 0; d < deviceCount; ++d)
+            {
+                const float *inputData = model->readonlyAccess(input, d);
+                const float *weightAData = model->readonlyAccess(weightA, d);
+                const float *biasAData = model->readonlyAccess(biasA, d);
+                const float *weightBData = model->readonlyAccess(weightB, d);
+                const float *biasBData = model->readonlyAccess(biasB, d);
+                const float *sumData = model->readonlyAccess(sum, d);
+
+                for (unsigned int b = 0; b < batchSize; ++b)
+                {
+                    for (unsigned int o = 0; o < 3; ++o)
+                    {
+                        float a = biasAData[o];
+                        float c = biasBData[o];
+
+                        for (unsigned int i = 0; i < 4; ++i)
+                        {
+                            a += weightAData[i * 3 + o] * inputData[b * 4 + i];
+                            c += weightBData[i * 3 + o] * inputData[b * 4 + i];
+                        }
+
+                        a = 1.0 / (1.0 + std::exp(-a));
+
+                        QVERIFY(std::abs(sumData[b * 3 + o] - (a + c)) < epsilon);
+                    }
+                }
+            }
+        }
+
+        //the update merges every device's gradient and lands on every device,
+        //in place for a shared copy or by broadcast to the replicas
+        std::vector<float> expectedWeightA(model->readonlyAccess(weightA, 0), model->readonlyAccess(weightA, 0) + 12);
+
+        for (unsigned int d = 0; d < deviceCount; ++d)
+        {
+            float *weightAGradData = model->beginMutateData(weightAGrad, d);
+
+            for (unsigned int i = 0; i < 12; ++i)
+            {
+                weightAGradData[i] = (float) (d + 1) * 0.01f * i;
+                expectedWeightA[i] += -0.5f * weightAGradData[i];
+            }
+        }
+
+        solver.update(-0.5);
+
+        for (unsigned int d = 0; d < deviceCount; ++d)
+        {
+            for (unsigned int i = 0; i < 12; ++i)
+            {
+                QVERIFY(std::abs(model->readonlyAccess(weightA, d)[i] - expectedWeightA[i]) < epsilon);
+            }
+        }
+
+        delete model;
+    }
+
+    std::remove(weightPath);
+
+    //one operator can't see a tensor in two shapes
+    FreeWill::Model *conflictingModel = FreeWill::Model::create();
+
+    FreeWill::TensorDescriptorHandle square = conflictingModel->addTensor("square", {4, 4}).enableBatch();
+    FreeWill::OperatorDescriptorHandle squareSigmoid = conflictingModel->addOperator("squareSigmoid", FreeWill::OperatorName::ACTIVATION,
+    {{"Input", square.reshape({16})}}, {{"Output", square.reshape({2, 8})}}, {{"Mode", FreeWill::ActivationMode::SIGMOID}});
+
+    conflictingModel->defineForwardPath({squareSigmoid});
+    conflictingModel->defineBackwardPath({});
+    conflictingModel->defineWeightUpdatePairs({});
+
+    FreeWill::Solver conflictingSolver;
+    conflictingSolver.m_deviceUsed = FreeWill::DeviceType::CPU_NAIVE;
+    conflictingSolver.m_batchSize = 2;
+    QVERIFY(!conflictingSolver.init(conflictingModel));
+
+    delete conflictingModel;
+
+    //a shared mapping of a per device tensor, the replicas mustn't write over each other
+    const char *statePath = "FreeWillSharedMappingTest.bin";
+    std::remove(statePath);
+
+    {
+        FreeWill::Model *mappedModel = FreeWill::Model::create();
+
+        FreeWill::TensorDescriptorHandle state = mappedModel->addTensor("state", {4}).enableBatch();
+        state.mapFile(statePath, 0, FreeWill::MappedFileAllocator::Mapping::SHARED);
+        FreeWill::TensorDescriptorHandle stateOutput = mappedModel->addTensor("stateOutput", {4}).enableBatch();
+        FreeWill::OperatorDescriptorHandle stateSigmoid = mappedModel->addOperator("stateSigmoid", FreeWill::OperatorName::ACTIVATION,
+        {{"Input", state}}, {{"Output", stateOutput}}, {{"Mode", FreeWill::ActivationMode::SIGMOID}});
+
+        mappedModel->defineForwardPath({stateSigmoid});
+        mappedModel->defineBackwardPath({});
+        mappedModel->defineWeightUpdatePairs({});
+
+        FreeWill::Solver mappedSolver;
+        mappedSolver.m_deviceUsed = FreeWill::DeviceType::CPU_NAIVE;
+        mappedSolver.m_batchSize = batchSize;
+        QVERIFY(mappedSolver.init(mappedModel));
+
+        for (unsigned int d = 0; d < deviceCount; ++d)
+        {
+            float *stateData = mappedModel->beginMutateData(state, d);
+
+            for (unsigned int i = 0; i < 4 * batchSize; ++i)
+            {
+                stateData[i] = (float) (d + 1);
+            }
+
+            mappedModel->endMutateData(state, d);
+        }
+
+        //the file ends with the last replica, unpadded
+        size_t replicaSize = FreeWill::Allocator::alignedSize(4 * batchSize * sizeof(float));
+        size_t fileSize = (deviceCount - 1) * replicaSize + 4 * batchSize * sizeof(float);
+        std::vector<float> fileData(deviceCount * replicaSize / sizeof(float));
+        FILE *stateFile = fopen(statePath, "rb");
+        QVERIFY(stateFile);
+        QVERIFY(fread(fileData.data(), 1, deviceCount * replicaSize, stateFile) == fileSize);
+        fclose(stateFile);
+
+        for (unsigned int d = 0; d < deviceCount; ++d)
+        {
+            for (unsigned int i = 0; i < 4 * batchSize; ++i)
+            {
+                QVERIFY(fileData[d * replicaSize / sizeof(float) + i] == (float) (d + 1));
+            }
+        }
+
+        delete mappedModel;
+    }
+
+    std::remove(statePath);
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().setInlineWorkThreshold(defaultInlineWorkThreshold);
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().close();
+}
+
+void FreeWillUnitTest::pipelineAffinityTest()
+{
+    const unsigned int deviceCount = 3;
+    const unsigned int batchSize = 2;
+    const unsigned int layerCount = 6;
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().open(deviceCount);
+
+    //the layers are tiny, so outside a pipeline they would run inline on
+    //whichever thread released them
+    QVERIFY(FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().inlineWorkThreshold() > 16 * 16 * batchSize);
+
+    FreeWill::Model *model = FreeWill::Model::create();
+
+    std::vector<FreeWill::TensorDescriptorHandle> activations;
+    std::vector<FreeWill::OperatorDescriptorHandle> forwardPath;
+
+    for (unsigned int l = 0; l <= layerCount; ++l)
+    {
+        activations.push_back(model->addTensor("activation" + std::to_string(l), {16}).enableBatch());
+    }
+
+    for (unsigned int l = 0; l < layerCount; ++l)
+    {
+        FreeWill::TensorDescriptorHandle weight = model->addTensor("weight" + std::to_string(l), {16, 16}).randomize();
+        FreeWill::TensorDescriptorHandle bias = model->addTensor("bias" + std::to_string(l), {16}).randomize();
+        forwardPath.push_back(model->addOperator("fullyConnected" + std::to_string(l), FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS,
+                            {{"Input", activations[l]}, {"Weight", weight}, {"Bias", bias}},
+                            {{"Output", activations[l + 1]}}));
+    }
+
+    model->defineForwardPath(forwardPath);
+    model->defineBackwardPath({});
+    model->defineWeightUpdatePairs({});
+
+    FreeWill::Solver solver;
+    solver.m_deviceUsed = FreeWill::DeviceType::CPU_NAIVE;
+    solver.m_batchSize = batchSize;
+    solver.m_executionMode = FreeWill::ExecutionMode::PIPELINE;
+    QVERIFY(solver.init(model));
+
+    const FreeWill::ExecutionGraph *forwardGraph = model->executionGraph(false);
+    QVERIFY(forwardGraph != nullptr);
+    QVERIFY(forwardGraph->nodeCount() == layerCount * deviceCount);
+
+    //every replica of a stage runs on the stage's worker, whoever released it
+    //and whichever worker happened to be idle
+    for (unsigned int iteration = 0; iteration < 4; ++iteration)
+    {
+        if (iteration % 2 == 0)
+        {
+            solver.forward(model);
+        }
+        else
+        {
+            FreeWill::SolverStep step = solver.forwardAsync(model);
+            step.wait();
+        }
+
+        std::set<unsigned int> workers;
+
+        for (unsigned int i = 0; i < forwardGraph->nodeCount(); ++i)
+        {
+            const FreeWill::ExecutionNode *node = forwardGraph->node(i);
+            QVERIFY(node->executedWorkerId() == (int) node->workerId());
+            workers.insert(node->workerId());
+        }
+
+        QVERIFY(workers.size() == deviceCount);
+    }
+
+    delete model;
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().close();
+}
+
+void FreeWillUnitTest::memoryPlanTest()
+{
+    const unsigned int deviceCount = 2;
+    const unsigned int batchSize = 2;
+    const unsigned int layerCount = 4;
+    const unsigned int sizes[layerCount + 1] = {8, 16, 16, 16, 4};
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().open(deviceCount);
+
+    unsigned long defaultInlineWorkThreshold = FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().inlineWorkThreshold();
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().setInlineWorkThreshold(0);
+
+    const FreeWill::ExecutionMode executionModes[] = {FreeWill::ExecutionMode::GRAPH, FreeWill::ExecutionMode::COMMAND_LIST, FreeWill::ExecutionMode::PIPELINE};
+
+    for (unsigned int m = 0; m < 3; ++m)
+    {
+        FreeWill::Model *model = FreeWill::Model::create();
+
+        //a plain chain, layer i's input is dead once layer i + 1 has run
+        std::vector<FreeWill::TensorDescriptorHandle> activations;
+        std::vector<FreeWill::TensorDescriptorHandle> weights;
+        std::vector<FreeWill::TensorDescriptorHandle> biases;
+        std::vector<FreeWill::OperatorDescriptorHandle> forwardPath;
+
+        for (unsigned int l = 0; l <= layerCount; ++l)
+        {
+            activations.push_back(model->addTensor("activation" + std::to_string(l), {sizes[l]}).enableBatch());
+        }
+
+        for (unsigned int l = 0; l < layerCount; ++l)
+        {
+            weights.push_back(model->addTensor("weight" + std::to_string(l), {sizes[l + 1], sizes[l]}).randomize());
+            biases.push_back(model->addTensor("bias" + std::to_string(l), {sizes[l + 1]}).randomize());
+            forwardPath.push_back(model->addOperator("fullyConnected" + std::to_string(l), FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS,
+                                {{"Input", activations[l]}, {"Weight", weights[l]}, {"Bias", biases[l]}},
+                                {{"Output", activations[l + 1]}}));
+        }
+
+        model->defineForwardPath(forwardPath);
+        model->defineBackwardPath({});
+        model->defineWeightUpdatePairs({});
+        model->setMemoryPlanning(true);
+
+        FreeWill::Solver solver;
+        solver.m_deviceUsed = FreeWill::DeviceType::CPU_NAIVE;
+        solver.m_batchSize = batchSize;
+        solver.m_executionMode = executionModes[m];
+        QVERIFY(solver.init(model));
+
+        const FreeWill::MemoryPlan &memoryPlan = model->memoryPlan();
+
+        //the input is read first and the result is never read, both keep their own memory
+        QVERIFY(!memoryPlan.isPlanned("activation0"));
+        QVERIFY(!memoryPlan.isPlanned("activation4"));
+        QVERIFY(memoryPlan.isPlanned("activation1"));
+        QVERIFY(memoryPlan.isPlanned("activation3"));
+        QVERIFY(memoryPlan.aliases("activation1") == std::vector<std::string>({"activation3"}));
+        QVERIFY(memoryPlan.peakBytes() == 2 * FreeWill::Allocator::alignedSize(16 * batchSize * sizeof(float)));
+        QVERIFY(memoryPlan.plannedBytes() < memoryPlan.naiveBytes());
+
+        for (unsigned int d = 0; d < deviceCount; ++d)
+        {
+            QVERIFY(model->readonlyAccess(activations[1], d) == model->readonlyAccess(activations[3], d));
+
+            float *inputData = model->beginMutateData(activations[0], d);
+
+            for (unsigned int i = 0; i < sizes[0] * batchSize; ++i)
+            {
+                inputData[i] = (float) (d + 1) * 0.1f * i - 0.3f;
+            }
+        }
+
+        solver.forward(model);
+
+        for (unsigned int d = 0; d < deviceCount; ++d)
+        {
+            std::vector<float> reference(model->readonlyAccess(activations[0], d), model->readonlyAccess(activations[0], d) + sizes[0] * batchSize);
+
+            for (unsigned int l = 0; l < layerCount; ++l)
+            {
+                const float *weightData = model->readonlyAccess(weights[l], d);
+                const float *biasData = model->readonlyAccess(biases[l], d);
+                std::vector<float> next(sizes[l + 1] * batchSize);
+
+                for (unsigned int b = 0; b < batchSize; ++b)
+                {
+                    for (unsigned int o = 0; o < sizes[l + 1]; ++o)
+                    {
+                        float sum = biasData[o];
+
+                        for (unsigned int i = 0; i < sizes[l]; ++i)
+                        {
+                            sum += weightData[i * sizes[l + 1] + o] * reference[b * sizes[l] + i];
+                        }
+
+                        next[b * sizes[l + 1] + o] = sum;
+                    }
+                }
+
+                reference = next;
+            }
+
+            const float *outputData = model->readonlyAccess(activations[layerCount], d);
+
+            for (unsigned int i = 0; i < sizes[layerCount] * batchSize; ++i)
+            {
+                QVERIFY(std::abs(outputData[i] - reference[i]) < epsilon * 10);
+            }
+        }
+
+        delete model;
+    }
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().setInlineWorkThreshold(defaultInlineWorkThreshold);
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().close();
+}
+
+void FreeWillUnitTest::memoryPlanTrainingTest()
+{
+    const unsigned int deviceCount = 2;
+    const unsigned int batchSize = 2;
+    const unsigned int featureMapSize = 4;
+    const unsigned int classCount = 4;
+    const unsigned int stepCount = 3;
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().open(deviceCount);
+
+    unsigned long defaultInlineWorkThreshold = FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().inlineWorkThreshold();
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().setInlineWorkThreshold(0);
+
+    const FreeWill::ExecutionMode executionModes[] = {FreeWill::ExecutionMode::GRAPH, FreeWill::ExecutionMode::COMMAND_LIST, FreeWill::ExecutionMode::PIPELINE};
+
+    //the convolution adds into its output and its gradients, max pooling
+    //scatters into its input gradient, a planned run has to train exactly
+    //like one where every tensor has its own memory
+    for (unsigned int m = 0; m < 3; ++m)
+    {
+        std::vector<float> costs[2];
+        std::vector<float> parameters[2];
+
+        for (unsigned int p = 0; p < 2; ++p)
+        {
+            bool isPlanned = p == 1;
+
+            FreeWill::Model *model = FreeWill::Model::create();
+
+            FreeWill::TensorDescriptorHandle image = model->addTensor("image", {1,8,8}).enableBatch();
+            FreeWill::TensorDescriptorHandle label = model->addTensor("label", {1}, FreeWill::DataType::UNSIGNED_INT).enableBatch();
+            FreeWill::TensorDescriptorHandle featureMap = model->addTensor("featureMap", {1,3,3,featureMapSize});
+            FreeWill::TensorDescriptorHandle bias = model->addTensor("bias", {featureMapSize});
+            FreeWill::TensorDescriptorHandle convOutput = model->addTensor("convOutput", {featureMapSize,6,6}).enableBatch();
+            FreeWill::TensorDescriptorHandle poolingOutput = model->addTensor("poolingOutput", {featureMapSize,3,3}).enableBatch();
+            FreeWill::TensorDescriptorHandle poolingSwitchX = model->addTensor("poolingSwitchX", {featureMapSize,3,3}, FreeWill::DataType::UNSIGNED_INT).enableBatch();
+            FreeWill::TensorDescriptorHandle poolingSwitchY = model->addTensor("poolingSwitchY", {featureMapSize,3,3}, FreeWill::DataType::UNSIGNED_INT).enableBatch();
+            FreeWill::TensorDescriptorHandle fullyConnectedWeight = model->addTensor("fullyConnectedWeight", {classCount, featureMapSize*3*3});
+            FreeWill::TensorDescriptorHandle fullyConnectedBias = model->addTensor("fullyConnectedBias", {classCount});
+            FreeWill::TensorDescriptorHandle fullyConnectedOutput = model->addTensor("fullyConnectedOutput", {classCount}).enableBatch();
+            FreeWill::TensorDescriptorHandle softmaxOutput = model->addTensor("softmaxOutput", {classCount}).enableBatch();
+            FreeWill::TensorDescriptorHandle cost = model->addTensor("cost", {1}).enableBatch();
+            FreeWill::TensorDescriptorHandle softmaxGrad = model->addTensor("softmaxGrad", {classCount}).enableBatch();
+            FreeWill::TensorDescriptorHandle fullyConnectedWeightGrad = model->addTensor("fullyConnectedWeightGrad", {classCount, featureMapSize*3*3});
+            FreeWill::TensorDescriptorHandle fullyConnectedBiasGrad = model->addTensor("fullyConnectedBiasGrad", {classCount});
+            FreeWill::TensorDescriptorHandle poolingOutputGrad = model->addTensor("poolingOutputGrad", {featureMapSize*3*3}).enableBatch();
+            FreeWill::TensorDescriptorHandle convOutputGrad = model->addTensor("convOutputGrad", {featureMapSize,6,6}).enableBatch();
+            FreeWill::TensorDescriptorHandle convFeatureMapGrad = model->addTensor("convFeatureMapGrad", {1,3,3,featureMapSize});
+            FreeWill::TensorDescriptorHandle convBiasGrad = model->addTensor("convBiasGrad", {featureMapSize});
+            FreeWill::TensorDescriptorHandle inputGrad = model->addTensor("inputGrad", {1,8,8}).enableBatch();
+
+            FreeWill::OperatorDescriptorHandle convolution = model->addOperator("convolution", FreeWill::OperatorName::CONVOLUTION,
+                                {{"Input", image}, {"FeatureMap", featureMap}, {"Bias", bias}}, {{"Output", convOutput}});
+            FreeWill::OperatorDescriptorHandle convSigmoid = model->addOperator("convSigmoid", FreeWill::OperatorName::ACTIVATION,
+                                {{"Input", convOutput}}, {{"Output", convOutput}}, {{"Mode", FreeWill::ActivationMode::SIGMOID}});
+            FreeWill::OperatorDescriptorHandle maxPooling = model->addOperator("maxPooling", FreeWill::OperatorName::MAX_POOLING,
+                                {{"Input", convOutput}}, {{"Output", poolingOutput.reshape({featureMapSize,3,3})}, {"SwitchX", poolingSwitchX}, {"SwitchY", poolingSwitchY}});
+            FreeWill::OperatorDescriptorHandle fullyConnected = model->addOperator("fullyConnected", FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS,
+                                {{"Input", poolingOutput.reshape({featureMapSize*3*3})}, {"Weight", fullyConnectedWeight}, {"Bias", fullyConnectedBias}},
+                                {{"Output", fullyConnectedOutput}});
+            FreeWill::OperatorDescriptorHandle softmaxLogLoss = model->addOperator("softmaxLogLoss", FreeWill::OperatorName::SOFTMAX_LOG_LOSS,
+                                {{"Input", fullyConnectedOutput}, {"Label", label}}, {{"Output", softmaxOutput}, {"Cost", cost}});
+            FreeWill::OperatorDescriptorHandle softmaxLogLossDerivative = model->addOperator("softmaxLogLossDerivative", FreeWill::OperatorName::SOFTMAX_LOG_LOSS_DERIVATIVE,
+                                {{"Output", softmaxOutput}, {"Label", label}}, {{"InputGrad", softmaxGrad}});
+            FreeWill::OperatorDescriptorHandle fullyConnectedDerivative = model->addOperator("fullyConnectedDerivative", FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS_DERIVATIVE,
+                                {{"InputActivation", poolingOutput.reshape({featureMapSize*3*3})}, {"OutputDelta", softmaxGrad}, {"Weight", fullyConnectedWeight}},
+                                {{"InputDelta", poolingOutputGrad.reshape({featureMapSize*3*3})}, {"BiasGrad", fullyConnectedBiasGrad}, {"WeightGrad", fullyConnectedWeightGrad}});
+            FreeWill::OperatorDescriptorHandle maxPoolingDerivative = model->addOperator("maxPoolingDerivative", FreeWill::OperatorName::MAX_POOLING_DERIVATIVE,
+                                {{"OutputGrad", poolingOutputGrad.reshape({featureMapSize,3,3})}, {"SwitchX", poolingSwitchX}, {"SwitchY", poolingSwitchY}},
+                                {{"InputGrad", convOutputGrad}});
+            FreeWill::OperatorDescriptorHandle convSigmoidDerivative = model->addOperator("convSigmoidDerivative", FreeWill::OperatorName::ACTIVATION_DERIVATIVE,
+                                {{"Output", convOutput}, {"OutputDelta", convOutputGrad}}, {{"InputDelta", convOutputGrad}},
+                                {{"Mode", FreeWill::ActivationMode::SIGMOID}});
+            FreeWill::OperatorDescriptorHandle convDerivative = model->addOperator("convDerivative", FreeWill::OperatorName::CONVOLUTION_DERIVATIVE,
+                                {{"PrevActivation", image}, {"FeatureMap", featureMap}, {"OutputGrad", convOutputGrad}},
+                                {{"FeatureMapGrad", convFeatureMapGrad}, {"BiasGrad", convBiasGrad}, {"InputGrad", inputGrad}});
+
+            model->defineForwardPath({convolution, convSigmoid, maxPooling, fullyConnected, softmaxLogLoss});
+            model->defineBackwardPath({softmaxLogLossDerivative, fullyConnectedDerivative, maxPoolingDerivative, convSigmoidDerivative, convDerivative});
+            model->defineWeightUpdatePairs({{fullyConnectedWeight, fullyConnectedWeightGrad},
+                                            {fullyConnectedBias, fullyConnectedBiasGrad},
+                                            {featureMap, convFeatureMapGrad},
+                                            {bias, convBiasGrad}});
+            model->setMemoryPlanning(isPlanned);
+
+            FreeWill::Solver solver;
+            solver.m_deviceUsed = FreeWill::DeviceType::CPU_NAIVE;
+            solver.m_batchSize = batchSize;
+            solver.m_executionMode = executionModes[m];
+            QVERIFY(solver.init(model));
+
+            const FreeWill::MemoryPlan &memoryPlan = model->memoryPlan();
+
+            if (isPlanned)
+            {
+                //outputs that are added into keep their own memory
+                QVERIFY(!memoryPlan.isPlanned("convOutput"));
+                QVERIFY(!memoryPlan.isPlanned("convOutputGrad"));
+                QVERIFY(memoryPlan.isPlanned("poolingOutputGrad"));
+                QVERIFY(memoryPlan.isPlanned("softmaxGrad"));
+            }
+
+            //the same starting point for both runs
+            const FreeWill::TensorDescriptorHandle parameterTensors[] = {featureMap, bias, fullyConnectedWeight, fullyConnectedBias};
+            const unsigned int parameterSizes[] = {3*3*featureMapSize, featureMapSize, classCount*featureMapSize*3*3, classCount};
+
+            for (unsigned int t = 0; t < 4; ++t)
+            {
+                float *data = model->beginMutateData(parameterTensors[t]);
+
+                for (unsigned int i = 0; i < parameterSizes[t]; ++i)
+                {
+                    data[i] = 0.05f * (float) ((i * 7 + t * 3) % 11) - 0.25f;
+                }
+
+                model->endMutateData(parameterTensors[t]);
+            }
+
+            for (unsigned int step = 0; step < stepCount; ++step)
+            {
+                for (unsigned int d = 0; d < deviceCount; ++d)
+                {
+                    float *imageData = model->beginMutateData(image, d);
+                    unsigned int *labelData = model->beginMutateData<FreeWill::DeviceType::CPU_NAIVE, unsigned int>(label, d);
+
+                    for (unsigned int i = 0; i < 8 * 8 * batchSize; ++i)
+                    {
+                        imageData[i] = 0.01f * (float) ((i * 13 + d * 5 + step * 3) % 29);
+                    }
+
+                    for (unsigned int b = 0; b < batchSize; ++b)
+                    {
+                        labelData[b] = (b + d + step) % classCount;
+                    }
+                }
+
+                //the tensors the kernels add into start from zero, as in the demos
+                model->clearTensor(convOutput);
+
+                solver.forward(model);
+
+                for (unsigned int d = 0; d < deviceCount; ++d)
+                {
+                    costs[p].insert(costs[p].end(), model->readonlyAccess(cost, d), model->readonlyAccess(cost, d) + batchSize);
+                }
+
+                model->clearTensor(convOutputGrad);
+                model->clearTensor(convFeatureMapGrad);
+                model->clearTensor(convBiasGrad);
+                model->clearTensor(inputGrad);
+
+                solver.backward(model);
+                solver.update(-0.1);
+            }
+
+            for (unsigned int t = 0; t < 4; ++t)
+            {
+                parameters[p].insert(parameters[p].end(), model->readonlyAccess(parameterTensors[t]), model->readonlyAccess(parameterTensors[t]) + parameterSizes[t]);
+            }
+
+            delete model;
+        }
+
+        QVERIFY(costs[0].size() == costs[1].size() && parameters[0].size() == parameters[1].size());
+
+        for (unsigned int i = 0; i < costs[0].size(); ++i)
+        {
+            QVERIFY(std::abs(costs[0][i] - costs[1][i]) < epsilon);
+        }
+
+        for (unsigned int i = 0; i < parameters[0].size(); ++i)
+        {
+            QVERIFY(std::abs(parameters[0][i] - parameters[1][i]) < epsilon);
+        }
+    }
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().setInlineWorkThreshold(defaultInlineWorkThreshold);
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().close();
+}
+
+void FreeWillUnitTest::quantizationTest()
+{
+    //every product is off by at most half a step of either factor, so a sum
+    //of n products stays within n * maxW * maxX * (1/254 + 1/254 + 1/64516)
+    auto bound = [](unsigned int n, float maximumWeight, float maximumInput)
+    {
+        return n * maximumWeight * maximumInput / 120.0f + 1e-5f;
+    };
+
+    //the convolution against the float kernel, with padding cutting into the filters
+    {
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> input({3, 5, 5, 2});
+        input.init();
+        input.randomize();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> featureMap({3, 3, 3, 4});
+        featureMap.init();
+        featureMap.randomize();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> bias({4});
+        bias.init();
+        bias.randomize();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> output({4, 5, 5, 2});
+        output.init();
+
+        FreeWill::Convolution<FreeWill::DeviceType::CPU_NAIVE, float> convolution(1, 1, 1, 1);
+        convolution.setInputParameter("Input", &input);
+        convolution.setInputParameter("FeatureMap", &featureMap);
+        convolution.setInputParameter("Bias", &bias);
+        convolution.setOutputParameter("Output", &output);
+        QVERIFY(convolution.init());
+        convolution.evaluate();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, int8_t> quantizedFeatureMap({3, 3, 3, 4});
+        quantizedFeatureMap.init();
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> featureMapScale({4});
+        featureMapScale.init();
+
+        FreeWill::quantizePerChannel(featureMap.cpuDataHandle(), 3 * 3 * 3, 4, quantizedFeatureMap.cpuDataHandle(), featureMapScale.cpuDataHandle());
+
+        float maximumInput = 0.0f;
+        for (unsigned int i = 0; i < input.shape().size(); ++i)
+        {
+            maximumInput = std::max(maximumInput, std::abs(input[i]));
+        }
+
+        float maximumWeight = 0.0f;
+        for (unsigned int i = 0; i < featureMap.shape().size(); ++i)
+        {
+            maximumWeight = std::max(maximumWeight, std::abs(featureMap[i]));
+        }
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> inputScale({1});
+        inputScale.init({FreeWill::quantizationScale(maximumInput)});
+
+        FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> quantizedOutput({4, 5, 5, 2});
+        quantizedOutput.init();
+
+        FreeWill::QuantizedConvolution<FreeWill::DeviceType::CPU_NAIVE> quantizedConvolution(1, 1, 1, 1);
+        quantizedConvolution.setInputParameter("Input", &input);
+        quantizedConvolution.setInputParameter("InputScale", &inputScale);
+        quantizedConvolution.setInputParameter("FeatureMap", &quantizedFeatureMap);
+        quantizedConvolution.setInputParameter("FeatureMapScale", &featureMapScale);
+        quantizedConvolution.setInputParameter("Bias", &bias);
+        quantizedConvolution.setOutputParameter("Output", &quantizedOutput);
+        QVERIFY(quantizedConvolution.init());
+        quantizedConvolution.evaluate();
+
+        for (unsigned int i = 0; i < output.shape().size(); ++i)
+        {
+            QVERIFY(std::abs(quantizedOutput[i] - output[i]) <= bound(3 * 3 * 3, maximumWeight, maximumInput));
+        }
+    }
+
+    //calibrate on the float model, then serve the same weights from an int8 one
+    const unsigned int deviceCount = 2;
+    const unsigned int batchSize = 4;
+    const unsigned int inputSize = 40;
+    const unsigned int outputSize = 8;
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().open(deviceCount);
+
+    FreeWill::Model *model = FreeWill::Model::create();
+    FreeWill::TensorDescriptorHandle input = model->addTensor("input", {inputSize}).enableBatch();
+    FreeWill::TensorDescriptorHandle weight = model->addTensor("weight", {outputSize, inputSize}).randomize();
+    FreeWill::TensorDescriptorHandle bias = model->addTensor("bias", {outputSize}).randomize();
+    FreeWill::TensorDescriptorHandle output = model->addTensor("output", {outputSize}).enableBatch();
+    FreeWill::OperatorDescriptorHandle fullyConnected = model->addOperator("fullyConnected", FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS,
+                                                                           {{"Input", input}, {"Weight", weight}, {"Bias", bias}},
+                                                                           {{"Output", output}});
+    model->defineForwardPath({fullyConnected});
+    model->defineBackwardPath({});
+    model->defineWeightUpdatePairs({});
+
+    FreeWill::Solver solver;
+    solver.m_deviceUsed = FreeWill::DeviceType::CPU_NAIVE;
+    solver.m_batchSize = batchSize;
+    QVERIFY(solver.init(model));
+
+    FreeWill::Model *quantizedModel = FreeWill::Model::create();
+    FreeWill::TensorDescriptorHandle quantizedInput = quantizedModel->addTensor("input", {inputSize}).enableBatch();
+    FreeWill::TensorDescriptorHandle inputScale = quantizedModel->addTensor("inputScale", {1});
+    FreeWill::TensorDescriptorHandle quantizedWeight = quantizedModel->addTensor("weight", {inputSize, outputSize}, FreeWill::DataType::INT8);
+    FreeWill::TensorDescriptorHandle weightScale = quantizedModel->addTensor("weightScale", {outputSize});
+    FreeWill::TensorDescriptorHandle quantizedBias = quantizedModel->addTensor("bias", {outputSize});
+    FreeWill::TensorDescriptorHandle quantizedOutput = quantizedModel->addTensor("output", {outputSize}).enableBatch();
+    FreeWill::OperatorDescriptorHandle quantizedFullyConnected = quantizedModel->addOperator("fullyConnected", FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS,
+                                                                           {{"Input", quantizedInput}, {"InputScale", inputScale},
+                                                                            {"Weight", quantizedWeight}, {"WeightScale", weightScale}, {"Bias", quantizedBias}},
+                                                                           {{"Output", quantizedOutput}}, {}, FreeWill::DataType::INT8);
+    quantizedModel->defineForwardPath({quantizedFullyConnected});
+    quantizedModel->defineBackwardPath({});
+    quantizedModel->defineWeightUpdatePairs({});
+
+    FreeWill::Solver quantizedSolver;
+    quantizedSolver.m_deviceUsed = FreeWill::DeviceType::CPU_NAIVE;
+    quantizedSolver.m_batchSize = batchSize;
+    QVERIFY(quantizedSolver.init(quantizedModel));
+
+    FreeWill::Calibration calibration;
+    QVERIFY(!calibration.observe(model, FreeWill::TensorDescriptorHandle(model, "missing", {1})));
+
+    auto feed = [&](FreeWill::Model *target, FreeWill::TensorDescriptorHandle &handle, unsigned int step)
+    {
+        for (unsigned int d = 0; d < deviceCount; ++d)
+        {
+            float *inputData = target->beginMutateData(handle, d);
+
+            for (unsigned int i = 0; i < inputSize * batchSize; ++i)
+            {
+                inputData[i] = std::sin(0.37f * i + d + step) * (1.0f + 0.5f * step);
+            }
+        }
+    };
+
+    for (unsigned int step = 0; step < 3; ++step)
+    {
+        feed(model, input, step);
+        solver.forward(model);
+        QVERIFY(calibration.observe(model, input));
+    }
+
+    //the largest input of the calibration batches lands on 127
+    QVERIFY(std::abs(calibration.scale(input) * 127.0f - 2.0f) < 0.01f);
+
+    FreeWill::quantizeDotProductWeight(model->readonlyAccess(weight), inputSize, outputSize,
+                                       quantizedModel->beginMutateData<FreeWill::DeviceType::CPU_NAIVE, int8_t>(quantizedWeight),
+                                       quantizedModel->beginMutateData(weightScale));
+    quantizedModel->endMutateData(quantizedWeight);
+    quantizedModel->endMutateData(weightScale);
+
+    quantizedModel->beginMutateData(inputScale)[0] = calibration.scale(input);
+    quantizedModel->endMutateData(inputScale);
+
+    std::copy(model->readonlyAccess(bias), model->readonlyAccess(bias) + outputSize, quantizedModel->beginMutateData(quantizedBias));
+    quantizedModel->endMutateData(quantizedBias);
+
+    float maximumWeight = 0.0f;
+    for (unsigned int i = 0; i < inputSize * outputSize; ++i)
+    {
+        maximumWeight = std::max(maximumWeight, std::abs(model->readonlyAccess(weight)[i]));
+    }
+
+    feed(model, input, 1);
+    feed(quantizedModel, quantizedInput, 1);
+    solver.forward(model);
+    quantizedSolver.forward(quantizedModel);
+
+    for (unsigned int d = 0; d < deviceCount; ++d)
+    {
+        for (unsigned int i = 0; i < outputSize * batchSize; ++i)
+        {
+            QVERIFY(std::abs(quantizedModel->readonlyAccess(quantizedOutput, d)[i] - model->readonlyAccess(output, d)[i])
+                    <= bound(inputSize, maximumWeight, 2.0f));
+        }
+    }
+
+    delete quantizedModel;
+    delete model;
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().close();
+}
+
+static double joinLatency(unsigned int roundTrips)
+{
+    FreeWill::Completion request;
+    FreeWill::Completion reply;
+    unsigned int value = 0;
+    unsigned int answer = 0;
+
+    std::thread helper([&]{
+        for (unsigned int i = 0; i < roundTrips; ++i)
+        {
+            request.wait();
+            request.reset();
+            answer = value + 1;
+            reply.signal();
+        }
+    });
+
+    bool isCorrect = true;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < roundTrips; ++i)
+    {
+        reply.reset();
+        value = i;
+        request.signal();
+        reply.wait();
+        isCorrect = isCorrect && answer == i + 1;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    helper.join();
+
+    return isCorrect ? std::chrono::duration<double, std::nano>(end - start).count() / roundTrips : -1.0;
+}
+
+void FreeWillUnitTest::dispatchBenchmark()
+{
+    //the join itself, the old condition variable wait against spinning then
+    //parking on a futex at the default spin limit, best of a few runs
+    const unsigned int roundTrips = 20000;
+    const char *waitNames[] = {"condition variable", "completion"};
+    double latencies[2] = {0.0, 0.0};
+
+    for (unsigned int run = 0; run < 3; ++run)
+    {
+        for (unsigned int w = 0; w < 2; ++w)
+        {
+            FreeWill::Completion::setConditionVariableWait(w == 0);
+
+            double latency = joinLatency(roundTrips);
+            QVERIFY(latency > 0.0);
+            latencies[w] = run == 0 ? latency : std::min(latencies[w], latency);
+        }
+    }
+
+    qDebug() << "join round trip," << waitNames[0] << ":" << latencies[0] << "ns," << waitNames[1] << ":" << latencies[1] << "ns";
+
+    //the fully connected network of the MNIST demo, fed with random images
+    const unsigned int deviceCount = 2;
+    const unsigned int batchSize = 2;
+    const unsigned int stepCount = 200;
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().open(deviceCount);
+
+    const unsigned int operatorCount = 8;
+
+    const FreeWill::ExecutionMode executionModes[] = {FreeWill::ExecutionMode::COMMAND_LIST, FreeWill::ExecutionMode::GRAPH};
+    const char *executionModeNames[] = {"command list", "graph"};
+
+    //solver.init can't run twice on one model, every mode gets a fresh one
+    for (unsigned int m = 0; m < 2; ++m)
+    {
+        FreeWill::Model *model = FreeWill::Model::create();
+
+        FreeWill::TensorDescriptorHandle image = model->addTensor("image", {28*28}).enableBatch();
+        FreeWill::TensorDescriptorHandle label = model->addTensor("label", {1}, FreeWill::DataType::UNSIGNED_INT).enableBatch();
+        FreeWill::TensorDescriptorHandle fullyConnected1Weight = model->addTensor("fullyConnected1Weight", {100, 28*28}).randomize();
+        FreeWill::TensorDescriptorHandle fullyConnected1Bias = model->addTensor("fullyConnected1Bias", {100});
+        FreeWill::TensorDescriptorHandle fullyConnected1Output = model->addTensor("fullyConnected1Output", {100}).enableBatch();
+        FreeWill::TensorDescriptorHandle fullyConnected2Weight = model->addTensor("fullyConnected2Weight", {10,100}).randomize();
+        FreeWill::TensorDescriptorHandle fullyConnected2Bias = model->addTensor("fullyConnected2Bias", {10});
+        FreeWill::TensorDescriptorHandle fullyConnected2Output = model->addTensor("fullyConnected2Output", {10}).enableBatch();
+        FreeWill::TensorDescriptorHandle softmaxOutput = model->addTensor("softmaxOutput", {10}).enableBatch();
+        FreeWill::TensorDescriptorHandle cost = model->addTensor("cost", {1}).enableBatch();
+        FreeWill::TensorDescriptorHandle softmaxGrad = model->addTensor("softmaxGrad", {10}).enableBatch();
+        FreeWill::TensorDescriptorHandle fullyConnected2WeightGrad = model->addTensor("fullyConnected2WeightGrad", {10,100});
+        FreeWill::TensorDescriptorHandle fullyConnected2BiasGrad = model->addTensor("fullyConnected2BiasGrad", {10});
+        FreeWill::TensorDescriptorHandle fullyConnected1OutputGrad = model->addTensor("fullyConnected1OutputGrad", {100}).enableBatch();
+        FreeWill::TensorDescriptorHandle fullyConnected1WeightGrad = model->addTensor("fullyConnected1WeightGrad", {100,28*28});
+        FreeWill::TensorDescriptorHandle fullyConnected1BiasGrad = model->addTensor("fullyConnected1BiasGrad", {100});
+        FreeWill::TensorDescriptorHandle imageGrad = model->addTensor("imageGrad", {28*28}).enableBatch();
+
+        FreeWill::OperatorDescriptorHandle fullyConnected1 = model->addOperator("fullyConnected1", FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS,
+        {{"Input", image},{"Weight", fullyConnected1Weight},{"Bias", fullyConnected1Bias}},{{"Output", fullyConnected1Output}});
+        FreeWill::OperatorDescriptorHandle sigmoid1 = model->addOperator("sigmoid1", FreeWill::OperatorName::ACTIVATION,
+        {{"Input", fullyConnected1Output}}, {{"Output", fullyConnected1Output}},{{"Mode", FreeWill::ActivationMode::SIGMOID}});
+        FreeWill::OperatorDescriptorHandle fullyConnected2 = model->addOperator("fullyConnected2", FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS,
+        {{"Input", fullyConnected1Output}, {"Weight", fullyConnected2Weight}, {"Bias", fullyConnected2Bias}},{{"Output", fullyConnected2Output}});
+        FreeWill::OperatorDescriptorHandle softmaxLogLoss = model->addOperator("softmaxLogLoss",FreeWill::OperatorName::SOFTMAX_LOG_LOSS,
+        {{"Input", fullyConnected2Output},{"Label", label}},{{"Output", softmaxOutput},{"Cost", cost}});
+        FreeWill::OperatorDescriptorHandle softmaxLogLossDerivative = model->addOperator("softmaxLogLossDerivative", FreeWill::OperatorName::SOFTMAX_LOG_LOSS_DERIVATIVE,
+        {{"Output", softmaxOutput}, {"Label", label}},{{"InputGrad", softmaxGrad}});
+        FreeWill::OperatorDescriptorHandle dotProductWithBias2Derivative = model->addOperator("dotProductWithBias2Derivative", FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS_DERIVATIVE,
+        {{"InputActivation", fullyConnected1Output}, {"OutputDelta", softmaxGrad},{"Weight", fullyConnected2Weight}},
+        {{"InputDelta", fullyConnected1OutputGrad}, {"BiasGrad", fullyConnected2BiasGrad}, {"WeightGrad", fullyConnected2WeightGrad}});
+        FreeWill::OperatorDescriptorHandle sigmoidDerivative = model->addOperator("sigmoidDerivative", FreeWill::OperatorName::ACTIVATION_DERIVATIVE,
+        {{"Output", fullyConnected1Output}, {"OutputDelta", fullyConnected1OutputGrad}},{{"InputDelta", fullyConnected1OutputGrad}},{{"Mode", FreeWill::ActivationMode::SIGMOID}});
+        FreeWill::OperatorDescriptorHandle dotProductWithBias1Derivative = model->addOperator("dotProductWithBias1Derivative", FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS_DERIVATIVE,
+        {{"InputActivation", image}, {"OutputDelta", fullyConnected1OutputGrad}, {"Weight", fullyConnected1Weight}},
+        {{"InputDelta", imageGrad},{"BiasGrad", fullyConnected1BiasGrad},{"WeightGrad", fullyConnected1WeightGrad}});
+
+        model->defineForwardPath({fullyConnected1, sigmoid1, fullyConnected2, softmaxLogLoss});
+        model->defineBackwardPath({softmaxLogLossDerivative, dotProductWithBias2Derivative, sigmoidDerivative, dotProductWithBias1Derivative});
+        model->defineWeightUpdatePairs({{fullyConnected1Weight, fullyConnected1WeightGrad},
+                                        {fullyConnected1Bias, fullyConnected1BiasGrad},
+                                        {fullyConnected2Weight, fullyConnected2WeightGrad},
+                                        {fullyConnected2Bias, fullyConnected2BiasGrad}});
+
+        FreeWill::Solver solver;
+        solver.m_deviceUsed = FreeWill::DeviceType::CPU_NAIVE;
+        solver.m_batchSize = batchSize;
+        solver.m_executionMode = executionModes[m];
+        QVERIFY(solver.init(model));
+
+        for (unsigned int d = 0; d < deviceCount; ++d)
+        {
+            float *imageData = model->beginMutateData(image, d);
+            unsigned int *labelData = model->beginMutateData<FreeWill::DeviceType::CPU_NAIVE, unsigned int>(label, d);
+
+            for (unsigned int i = 0; i < 28 * 28 * batchSize; ++i)
+            {
+                imageData[i] = (float) (rand() % 256) / 255.0f;
+            }
+
+            for (unsigned int b = 0; b < batchSize; ++b)
+            {
+                labelData[b] = rand() % 10;
+            }
+
+            model->endMutateData(image, d);
+            model->endMutateData(label, d);
+        }
+
+        //the same model before and after, only the join wait differs
+        for (unsigned int w = 0; w < 2; ++w)
+        {
+            FreeWill::Completion::setConditionVariableWait(w == 0);
+
+            //warm up, the adaptive spin needs a few rounds to settle
+            for (unsigned int step = 0; step < 20; ++step)
+            {
+                solver.forward(model);
+                solver.backward(model);
+            }
+
+            auto startTime = std::chrono::steady_clock::now();
+
+            for (unsigned int step = 0; step < stepCount; ++step)
+            {
+                solver.forward(model);
+                solver.backward(model);
+            }
+
+            auto endTime = std::chrono::steady_clock::now();
+            double perOperator = std::chrono::duration<double, std::nano>(endTime - startTime).count() / (stepCount * operatorCount);
+
+            qDebug() << executionModeNames[m] << "," << waitNames[w] << ":" << perOperator << "ns per operator";
+        }
+
+        for (unsigned int d = 0; d < deviceCount; ++d)
+        {
+            const float *costData = model->readonlyAccess(cost, d);
+
+            for (unsigned int b = 0; b < batchSize; ++b)
+            {
+                QVERIFY(std::isfinite(costData[b]));
+            }
+        }
+
+        delete model;
+    }
+
+    FreeWill::Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().close();
+}
@@ -3,9 +3,17 @@
 #include "Tensor/ReferenceCountedBlob.h"
 #include "Operator/Operator.h"
 #include "Operator/ElementwiseAdd.h"
+#include "Operator/DotProductWithBias.h"
+#include "Operator/Convolution.h"
+#include "Operator/ConvolutionDerivative.h"
 #include <time.h>
 #include <cuda_runtime.h>
 #include "Context/Context.h"
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+#include <limits>
 
 void FreeWillUnitTest::initTestCase()
 {
@@ -51,6 +59,46 @@ void FreeWillUnitTest::blobTest()
         QVERIFY(blob1[i] == blob2[i]);
     }
 
+    QVERIFY(blob1.referenceCount() == 2);
+
+    //moving hands the reference over without touching the count
+    FreeWill::ReferenceCountedBlob<FreeWill::DeviceType::CPU_NAIVE> blob4(std::move(blob2));
+    QVERIFY(blob4 == blob1);
+    QVERIFY(blob2.dataHandle() == nullptr);
+    QVERIFY(blob1.referenceCount() == 2);
+
+    FreeWill::ReferenceCountedBlob<FreeWill::DeviceType::CPU_NAIVE> blob5;
+    blob5 = std::move(blob4);
+    QVERIFY(blob5 == blob1);
+    QVERIFY(blob4.sizeInByte() == 0);
+    QVERIFY(blob1.referenceCount() == 2);
+
+    //a moved from blob can be allocated again
+    QVERIFY(blob2.alloc(10));
+    QVERIFY(!(blob2 == blob1));
+
+    //copies made and dropped on several threads at once
+    std::vector<std::thread> threads;
+
+    for(unsigned int t = 0; t < 4; ++t)
+    {
+        threads.push_back(std::thread([&blob1]()
+        {
+            for(unsigned int i = 0; i < 10000; ++i)
+            {
+                FreeWill::ReferenceCountedBlob<FreeWill::DeviceType::CPU_NAIVE> copy(blob1);
+                FreeWill::ReferenceCountedBlob<FreeWill::DeviceType::CPU_NAIVE> moved(std::move(copy));
+            }
+        }));
+    }
+
+    for(unsigned int t = 0; t < threads.size(); ++t)
+    {
+        threads[t].join();
+    }
+
+    QVERIFY(blob1.referenceCount() == 2);
+
     //QString str = "Hello";
     //QVERIFY(str.toUpper() == "HELLO");
 }
@@ -95,6 +143,203 @@ void FreeWillUnitTest::blobTestGPU()
 
 }
 
+void FreeWillUnitTest::allocatorTest()
+{
+    FreeWill::PoolAllocator &pool = FreeWill::PoolAllocator::getSingleton();
+
+    QVERIFY(FreeWill::PoolAllocator::sizeClass(10) == 64);
+    QVERIFY(FreeWill::PoolAllocator::sizeClass(300) == 320);
+    QVERIFY(FreeWill::PoolAllocator::sizeClass(313600) >= 313600);
+    QVERIFY(FreeWill::PoolAllocator::sizeClass(313600) <= 313600 + 313600 / 4);
+
+    unsigned char *blockData = nullptr;
+
+    {
+        FreeWill::ReferenceCountedBlob<FreeWill::DeviceType::CPU_NAIVE> blob;
+        QVERIFY(blob.alloc(1000));
+        blockData = blob.dataHandle();
+        QVERIFY(((uintptr_t) blockData) % FreeWill::Allocator::ALIGNMENT == 0);
+        blockData[999] = 1;
+    }
+
+    //the freed block comes back, cleared, for the next blob of its size class
+    {
+        FreeWill::ReferenceCountedBlob<FreeWill::DeviceType::CPU_NAIVE> blob;
+        QVERIFY(blob.alloc(1010));
+        QVERIFY(blob.dataHandle() == blockData);
+        QVERIFY(blob[999] == 0);
+    }
+
+    QVERIFY(pool.cachedBytes() >= FreeWill::PoolAllocator::sizeClass(1000));
+
+    FreeWill::ArenaAllocator arena(1000);
+    QVERIFY(arena.capacity() == 1024);
+
+    {
+        FreeWill::ReferenceCountedBlob<FreeWill::DeviceType::CPU_NAIVE> blobA;
+        FreeWill::ReferenceCountedBlob<FreeWill::DeviceType::CPU_NAIVE> blobB;
+        FreeWill::ReferenceCountedBlob<FreeWill::DeviceType::CPU_NAIVE> blobC;
+
+        QVERIFY(blobA.alloc(10, &arena));
+        QVERIFY(blobB.alloc(100, &arena));
+        QVERIFY(arena.owns(blobA.dataHandle()));
+        QVERIFY(blobB.dataHandle() == blobA.dataHandle() + 64);
+        QVERIFY(arena.used() == 64 + 128);
+
+        //doesn't fit anymore, falls back to the pool
+        QVERIFY(blobC.alloc(1000, &arena));
+        QVERIFY(!arena.owns(blobC.dataHandle()));
+        QVERIFY(((uintptr_t) blobC.dataHandle()) % FreeWill::Allocator::ALIGNMENT == 0);
+    }
+
+    arena.release();
+    QVERIFY(arena.capacity() == 0);
+
+    pool.trim();
+    QVERIFY(pool.cachedBytes() == 0);
+
+    //past the limit freed blocks aren't cached, a lower limit trims the cache
+    size_t maxCachedBytes = pool.maxCachedBytes();
+    pool.setMaxCachedBytes(FreeWill::PoolAllocator::sizeClass(1000));
+
+    void *blocks[3];
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        blocks[i] = pool.allocate(1000);
+    }
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        pool.deallocate(blocks[i], 1000);
+    }
+    QVERIFY(pool.cachedBytes() == FreeWill::PoolAllocator::sizeClass(1000));
+
+    pool.setMaxCachedBytes(0);
+    QVERIFY(pool.cachedBytes() == 0);
+
+    pool.setMaxCachedBytes(maxCachedBytes);
+}
+
+void FreeWillUnitTest::mappedFileTest()
+{
+    const char *path = "FreeWillMappedFileTest.bin";
+    const unsigned int count = 1024;
+
+    {
+        std::vector<float> values(count + 16);
+
+        for (unsigned int i = 0; i < values.size(); ++i)
+        {
+            values[i] = (float) i;
+        }
+
+        FILE *file = fopen(path, "wb");
+        QVERIFY(file);
+        QVERIFY(fwrite(values.data(), sizeof(float), values.size(), file) == values.size());
+        fclose(file);
+    }
+
+    //the contents come from the file and copy on write keeps it as it is
+    {
+        FreeWill::MappedFileAllocator storage(path, 16 * sizeof(float));
+        FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> tensorA({count});
+        FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> tensorB({count});
+        QVERIFY(tensorA.init(&storage));
+        QVERIFY(tensorB.init(&storage));
+        QVERIFY(((uintptr_t) tensorA.cpuDataHandle()) % FreeWill::Allocator::ALIGNMENT == 0);
+
+        QVERIFY(tensorA[0] == 16.0f);
+        QVERIFY(tensorA[count - 1] == (float) (count + 15));
+
+        tensorA[0] = -1.0f;
+        QVERIFY(tensorB[0] == 16.0f);
+    }
+
+    //a shared mapping writes through and grows the file
+    {
+        FreeWill::MappedFileAllocator storage(path, count * sizeof(float), FreeWill::MappedFileAllocator::Mapping::SHARED);
+        FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> tensor({count});
+        QVERIFY(tensor.init(&storage));
+
+        QVERIFY(tensor[0] == (float) count);
+        QVERIFY(tensor[16] == 0.0f);
+
+        tensor[0] = -2.0f;
+        tensor[count - 1] = -3.0f;
+    }
+
+    {
+        FreeWill::MappedFileAllocator storage(path);
+        FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> tensor({2 * count});
+        QVERIFY(tensor.init(&storage));
+
+        QVERIFY(tensor[16] == 16.0f);
+        QVERIFY(tensor[count] == -2.0f);
+        QVERIFY(tensor[2 * count - 1] == -3.0f);
+
+        //past the end of a file that is only read
+        FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> tooLarge({2 * count + 1});
+        QVERIFY(!tooLarge.init(&storage));
+    }
+
+    FreeWill::MappedFileAllocator unaligned(path, 4);
+    QVERIFY(unaligned.allocate(64) == nullptr);
+
+    FreeWill::MappedFileAllocator missing("FreeWillMappedFileTest.missing");
+    QVERIFY(missing.allocate(64) == nullptr);
+
+    std::remove(path);
+}
+
+void FreeWillUnitTest::shapeTest()
+{
+    constexpr FreeWill::Shape constantShape({2, 3, 4});
+    static_assert(constantShape.dimension() == 3, "shapes can be built at compile time");
+    static_assert(constantShape[2] == 4, "shapes can be built at compile time");
+
+    FreeWill::Shape shape = constantShape;
+    QVERIFY(shape.size() == 24);
+    QVERIFY(shape == constantShape);
+
+    FreeWill::Shape batchShape = shape + 5;
+    QVERIFY(batchShape.dimension() == 4);
+    QVERIFY(batchShape[3] == 5);
+    QVERIFY(batchShape.size() == 120);
+
+    //writing a dimension refreshes the cached size
+    batchShape[0] = 1;
+    QVERIFY(batchShape.size() == 60);
+    QVERIFY(shape.size() == 24);
+
+    FreeWill::Shape emptyShape(2);
+    QVERIFY(emptyShape.size() == 0);
+    emptyShape[0] = 7;
+    emptyShape[1] = 2;
+    QVERIFY(emptyShape.size() == 14);
+
+    shape = {6, 7};
+    QVERIFY(shape.dimension() == 2);
+    QVERIFY(shape.size() == 42);
+    QVERIFY(shape != constantShape);
+
+    //too many dimensions give an invalid shape that can't be allocated
+    FreeWill::Shape fullShape({1, 2, 1, 2, 1, 2, 1, 2});
+    QVERIFY(fullShape.isValid());
+    QVERIFY(fullShape.size() == 16);
+
+    FreeWill::Shape overflowShape = fullShape + 3;
+    QVERIFY(!overflowShape.isValid());
+    QVERIFY(overflowShape.size() == 0);
+    QVERIFY(overflowShape != fullShape);
+    QVERIFY(!(overflowShape + 2).isValid());
+
+    FreeWill::Shape tooLargeShape({1, 2, 1, 2, 1, 2, 1, 2, 3});
+    QVERIFY(!tooLargeShape.isValid());
+    QVERIFY(tooLargeShape.dimension() == 0);
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, float> tooLarge(tooLargeShape);
+    QVERIFY(!tooLarge.init());
+}
+
 void FreeWillUnitTest::tensorTest()
 {
     FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> tensor({64, 32, 32});
@@ -120,9 +365,262 @@ void FreeWillUnitTest::tensorTest()
 
     delete tensor2;
 
+    float *tensorData = tensor.cpuDataHandle();
+    FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> tensor3(std::move(tensor));
+    QVERIFY(tensor3.cpuDataHandle() == tensorData);
+    QVERIFY(tensor3.shape().size() == tensorSize);
+    QVERIFY(tensor.cpuDataHandle() == nullptr);
+
+    FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> tensor4({10});
+    tensor4.init();
+    tensor4 = std::move(tensor3);
+    QVERIFY(tensor4.cpuDataHandle() == tensorData);
+    QVERIFY(tensor4.shape().size() == tensorSize);
+
+    FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> uninitialized({4});
+    tensor4 = std::move(uninitialized);
+    QVERIFY(tensor4.cpuDataHandle() == nullptr);
+    QVERIFY(tensor4.shape().size() == 4);
+    QVERIFY(tensor4.init());
+
     //QVERIFY(1 == 1);
 }
 
+void FreeWillUnitTest::tensorViewTest()
+{
+    FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> *batch = new FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float>({3, 4}, "batch");
+    batch->init();
+
+    for(unsigned int i = 0;i<12;++i)
+    {
+        (*batch)[i] = (float) i;
+    }
+
+    FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> middle = batch->sliceBatch(1, 3);
+    QVERIFY(middle.isView());
+    QVERIFY(!batch->isView());
+    QVERIFY(middle.shape() == FreeWill::Shape({3, 2}));
+    QVERIFY(middle.sizeInByte() == 6 * sizeof(float));
+    QVERIFY(middle.cpuDataHandle() == batch->cpuDataHandle() + 3);
+    QVERIFY(middle.name() == "batch");
+
+    //writes go through to the tensor the view was taken from
+    middle[0] = 100.0f;
+    QVERIFY((*batch)[3] == 100.0f);
+
+    middle.clear();
+    QVERIFY((*batch)[2] == 2.0f);
+    QVERIFY((*batch)[3] == 0.0f);
+    QVERIFY((*batch)[8] == 0.0f);
+    QVERIFY((*batch)[9] == 9.0f);
+
+    //a view of a view still points into the first allocation
+    FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> last = middle.view(3, {3}, "last");
+    QVERIFY(last.cpuDataHandle() == batch->cpuDataHandle() + 6);
+    QVERIFY(last.shape() == FreeWill::Shape({3}));
+
+    FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> whole = batch->sliceBatch(0, 4);
+    QVERIFY(!whole.isView());
+    QVERIFY(whole.cpuDataHandle() == batch->cpuDataHandle());
+
+    QVERIFY(batch->sliceBatch(3, 5).cpuDataHandle() == nullptr);
+    QVERIFY(batch->sliceBatch(2, 1).cpuDataHandle() == nullptr);
+    QVERIFY(middle.view(4, {3}).cpuDataHandle() == nullptr);
+
+    //the views keep the data alive
+    delete batch;
+
+    QVERIFY(last[0] == 0.0f);
+    last[1] = 7.0f;
+    QVERIFY(middle[4] == 7.0f);
+
+    FreeWill::Tensor< FreeWill::DeviceType::CPU_NAIVE, float> empty({3});
+    QVERIFY(empty.sliceBatch(0, 1).cpuDataHandle() == nullptr);
+}
+
+void FreeWillUnitTest::halfPrecisionTest()
+{
+    //exactly representable values survive the round trip
+    float exact[] = {0.0f, 1.0f, -2.0f, 0.5f, 256.0f, -0.15625f};
+    for(float value : exact)
+    {
+        QVERIFY((float) FreeWill::BFloat16(value) == value);
+        QVERIFY((float) FreeWill::Float16(value) == value);
+    }
+
+    //ties round to the even mantissa
+    QVERIFY(FreeWill::BFloat16(1.0f + 1.0f / 256.0f).bits() == 0x3f80);
+    QVERIFY(FreeWill::BFloat16(1.0f + 3.0f / 256.0f).bits() == 0x3f82);
+    QVERIFY(FreeWill::Float16(1.0f + 1.0f / 2048.0f).bits() == 0x3c00);
+    QVERIFY(FreeWill::Float16(1.0f + 3.0f / 2048.0f).bits() == 0x3c02);
+
+    //fp16 range ends at 65504, below 2^-14 it goes subnormal
+    QVERIFY((float) FreeWill::Float16(65504.0f) == 65504.0f);
+    QVERIFY(std::isinf((float) FreeWill::Float16(65520.0f)));
+    QVERIFY(std::isinf((float) FreeWill::Float16(-1e10f)) && (float) FreeWill::Float16(-1e10f) < 0.0f);
+    QVERIFY(FreeWill::Float16(std::ldexp(1.0f, -24)).bits() == 0x0001);
+    QVERIFY((float) FreeWill::Float16(std::ldexp(3.0f, -20)) == std::ldexp(3.0f, -20));
+    QVERIFY(FreeWill::Float16(std::ldexp(1.0f, -26)).bits() == 0x0000);
+    QVERIFY(std::isnan((float) FreeWill::Float16(std::nanf(""))));
+
+    QVERIFY((float) FreeWill::BFloat16(1e30f) > 9e29f);
+    QVERIFY(std::isnan((float) FreeWill::BFloat16(std::nanf(""))));
+    QVERIFY(std::isinf((float) FreeWill::BFloat16(std::numeric_limits<float>::infinity())));
+
+    FreeWill::BFloat16 accumulated = 1.0f;
+    accumulated += 2.0f;
+    accumulated *= 0.5f;
+    QVERIFY((float) accumulated == 1.5f);
+
+    float source[] = {0.1f, -3.7f, 1000.25f};
+    FreeWill::Float16 converted[3];
+    FreeWill::convertData(source, converted, 3);
+    float back[3] = {0};
+    FreeWill::convertData(converted, back, 3);
+    for(unsigned int i = 0;i<3;++i)
+    {
+        QVERIFY(std::abs(back[i] - source[i]) <= std::abs(source[i]) / 1024.0f);
+    }
+
+    //16 bit tensors through an operator, the sums are kept in float
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> input({4, 2});
+    input.init({1.0f, 2.0f, 3.0f, 4.0f,
+                0.5f, 0.25f, 0.125f, 1.5f});
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> weight({3, 4});
+    weight.init({1.0f, 0.5f, -1.0f,
+                 2.0f, 0.25f, 1.0f,
+                 -0.5f, 4.0f, 0.0f,
+                 1.0f, 1.0f, 2.0f});
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> bias({3});
+    bias.init({0.5f, 0.0f, -0.25f});
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> output({3, 2});
+    output.init();
+
+    FreeWill::DotProductWithBias<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> dotProductWithBias(true);
+    dotProductWithBias.setInputParameter("Input", &input);
+    dotProductWithBias.setInputParameter("Weight", &weight);
+    dotProductWithBias.setInputParameter("Bias", &bias);
+    dotProductWithBias.setOutputParameter("Output", &output);
+
+    QVERIFY(dotProductWithBias.init());
+    dotProductWithBias.evaluate();
+
+    for(unsigned int b = 0;b<2;++b)
+    {
+        for(unsigned int o = 0;o<3;++o)
+        {
+            float reference = bias[o];
+            for(unsigned int i = 0;i<4;++i)
+            {
+                reference += (float) weight[i * 3 + o] * (float) input[b * 4 + i];
+            }
+
+            QVERIFY(std::abs((float) output[b * 3 + o] - reference) <= std::abs(reference) / 128.0f);
+        }
+    }
+
+    //144 products of 0.01 per sum, rounding the running sum to bfloat16 after
+    //every product ends up 3.5% off, rounding it once stays within 1/256
+    const float product = (float) FreeWill::BFloat16(0.01f);
+    const float sumReference = 144.0f * product;
+
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> convolutionInput({16, 3, 3, 1});
+    convolutionInput.init();
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> featureMap({16, 3, 3, 2});
+    featureMap.init();
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> convolutionBias({2});
+    convolutionBias.init();
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> convolutionOutput({2, 1, 1, 1});
+    convolutionOutput.init();
+
+    for (unsigned int i = 0; i < convolutionInput.shape().size(); ++i)
+    {
+        convolutionInput[i] = 1.0f;
+    }
+
+    for (unsigned int i = 0; i < featureMap.shape().size(); ++i)
+    {
+        featureMap[i] = product;
+    }
+
+    FreeWill::Convolution<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> convolution;
+    convolution.setInputParameter("Input", &convolutionInput);
+    convolution.setInputParameter("FeatureMap", &featureMap);
+    convolution.setInputParameter("Bias", &convolutionBias);
+    convolution.setOutputParameter("Output", &convolutionOutput);
+
+    QVERIFY(convolution.init());
+    convolution.evaluate();
+
+    for (unsigned int k = 0; k < 2; ++k)
+    {
+        QVERIFY(std::abs((float) convolutionOutput[k] - sumReference) <= sumReference / 256.0f);
+    }
+
+    //12x12 output positions, every filter tap and the bias sum 144 products
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> prevActivation({1, 14, 14, 1});
+    prevActivation.init();
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> derivativeFeatureMap({1, 3, 3, 1});
+    derivativeFeatureMap.init();
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> outputGrad({1, 12, 12, 1});
+    outputGrad.init();
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> featureMapGrad({1, 3, 3, 1});
+    featureMapGrad.init();
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> biasGrad({1});
+    biasGrad.init();
+    FreeWill::Tensor<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> inputGrad({1, 14, 14, 1});
+    inputGrad.init();
+
+    for (unsigned int i = 0; i < prevActivation.shape().size(); ++i)
+    {
+        prevActivation[i] = 1.0f;
+    }
+
+    for (unsigned int i = 0; i < derivativeFeatureMap.shape().size(); ++i)
+    {
+        derivativeFeatureMap[i] = 1.0f;
+    }
+
+    for (unsigned int i = 0; i < outputGrad.shape().size(); ++i)
+    {
+        outputGrad[i] = product;
+    }
+
+    FreeWill::ConvolutionDerivative<FreeWill::DeviceType::CPU_NAIVE, FreeWill::BFloat16> convolutionDerivative;
+    convolutionDerivative.setInputParameter("PrevActivation", &prevActivation);
+    convolutionDerivative.setInputParameter("FeatureMap", &derivativeFeatureMap);
+    convolutionDerivative.setInputParameter("OutputGrad", &outputGrad);
+    convolutionDerivative.setOutputParameter("FeatureMapGrad", &featureMapGrad);
+    convolutionDerivative.setOutputParameter("BiasGrad", &biasGrad);
+    convolutionDerivative.setOutputParameter("InputGrad", &inputGrad);
+
+    QVERIFY(convolutionDerivative.init());
+    convolutionDerivative.evaluate();
+
+    for (unsigned int i = 0; i < featureMapGrad.shape().size(); ++i)
+    {
+        QVERIFY(std::abs((float) featureMapGrad[i] - sumReference) <= sumReference / 256.0f);
+    }
+
+    QVERIFY(std::abs((float) biasGrad[0] - sumReference) <= sumReference / 256.0f);
+
+    //an input pixel is covered by as many output positions as fit around it
+    for (unsigned int y = 0; y < 14; ++y)
+    {
+        for (unsigned int x = 0; x < 14; ++x)
+        {
+            unsigned int coverX = std::min(x, 11u) - (x >= 2 ? x - 2 : 0) + 1;
+            unsigned int coverY = std::min(y, 11u) - (y >= 2 ? y - 2 : 0) + 1;
+            float reference = (float) (coverX * coverY) * product;
+
+            QVERIFY(std::abs((float) inputGrad[y * 14 + x] - reference) <= reference / 256.0f);
+        }
+    }
+}
+
 void FreeWillUnitTest::tensorTestGPU()
 {
     FreeWill::Tensor<FreeWill::DeviceType::GPU_CUDA, float> tensor({64,32,32});
@@ -0,0 +1,63 @@
+#include "Calibration.h"
+#include "Model.h"
+#include "../Operator/Quantization.h"
+#include <algorithm>
+#include <iostream>
+
+FreeWill::Calibration::Calibration()
+    :m_maxima()
+{}
+
+bool FreeWill::Calibration::observe(FreeWill::Model *model, const FreeWill::TensorDescriptorHandle &tensorDescriptorHandle)
+{
+    if (model->m_tensors.find(tensorDescriptorHandle.name()) == model->m_tensors.end())
+    {
+        std::cerr << "can't calibrate unknown tensor " << tensorDescriptorHandle.name() << std::endl;
+        return false;
+    }
+
+    TensorDescriptor *tensorDescriptor = model->m_tensors[tensorDescriptorHandle.name()];
+
+    if (tensorDescriptor->m_dataType != DataType::FLOAT || model->m_memoryPlan.isPlanned(tensorDescriptor->m_name))
+    {
+        std::cerr << "can't calibrate tensor " << tensorDescriptor->m_name << ", it has to be an unplanned float tensor" << std::endl;
+        return false;
+    }
+
+    float &maximum = m_maxima[tensorDescriptor->m_name];
+
+    for (unsigned int i = 0; i < tensorDescriptor->m_tensors[DeviceType::CPU_NAIVE].size(); ++i)
+    {
+        Tensor<DeviceType::CPU_NAIVE, float> *tensor = tensorDescriptor->getTensorForDevice<DeviceType::CPU_NAIVE>(i)->toType<float>();
+
+        for (unsigned int e = 0; e < tensor->shape().size(); ++e)
+        {
+            maximum = std::max(maximum, std::abs((*tensor)[e]));
+        }
+    }
+
+    for (unsigned int i = 0; i < tensorDescriptor->m_tensors[DeviceType::GPU_CUDA].size(); ++i)
+    {
+        Tensor<DeviceType::GPU_CUDA, float> *tensor = tensorDescriptor->getTensorForDevice<DeviceType::GPU_CUDA>(i)->toType<float>();
+        tensor->copyFromDeviceToHost();
+
+        for (unsigned int e = 0; e < tensor->shape().size(); ++e)
+        {
+            maximum = std::max(maximum, std::abs((*tensor)[e]));
+        }
+    }
+
+    return true;
+}
+
+float FreeWill::Calibration::scale(const FreeWill::TensorDescriptorHandle &tensorDescriptorHandle) const
+{
+    auto iter = m_maxima.find(tensorDescriptorHandle.name());
+
+    return quantizationScale(iter == m_maxima.end() ? 0.0f : iter->second);
+}
+
+void FreeWill::Calibration::clear()
+{
+    m_maxima.clear();
+}
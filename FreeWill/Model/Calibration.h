@@ -0,0 +1,34 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <map>
+#include <string>
+
+namespace FreeWill
+{
+    class Model;
+    class TensorDescriptorHandle;
+
+    // Finds the InputScale of the int8 operators after training. Run a few
+    // representative batches through Solver::forward of the float model and
+    // observe() the float tensors that will feed a quantized operator after
+    // each one. The scale covers the largest magnitude seen on any device.
+    class Calibration
+    {
+    private:
+        std::map<std::string, float> m_maxima;
+
+    public:
+        Calibration();
+
+        //memory planned tensors are skipped, their data may be gone after forward
+        bool observe(Model *model, const TensorDescriptorHandle &tensorDescriptorHandle);
+
+        //1 for a tensor that was never observed
+        float scale(const TensorDescriptorHandle &tensorDescriptorHandle) const;
+
+        void clear();
+    };
+}
+
+#endif
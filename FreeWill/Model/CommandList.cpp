@@ -0,0 +1,134 @@
+#include "CommandList.h"
+#include "OperatorDescriptor.h"
+#include "TensorDescriptor.h"
+#include "../Context/Context.h"
+
+FreeWill::CommandList::CommandList(std::map<std::string, TensorDescriptor*> *tensors, unsigned int deviceId)
+    :m_tensors(tensors),
+      m_deviceId(deviceId),
+      m_commands(),
+      m_workEstimate(0),
+      m_message(this)
+{}
+
+bool FreeWill::CommandList::record(const std::vector<std::string> &path,
+                                   std::map<std::string, OperatorDescriptor*> &operators,
+                                   std::map<std::string, TensorDescriptor*> &tensors,
+                                   std::vector<CommandList*> &commandLists)
+{
+    if (path.empty())
+    {
+        return true;
+    }
+
+    unsigned int deviceCount = operators[path[0]]->m_operators[DeviceType::CPU_NAIVE].size();
+
+    for (unsigned int deviceId = 0; deviceId < deviceCount; ++deviceId)
+    {
+        commandLists.push_back(new CommandList(&tensors, deviceId));
+    }
+
+    for (unsigned int i = 0; i < path.size(); ++i)
+    {
+        OperatorDescriptor *operatorDescriptor = operators[path[i]];
+
+        if (operatorDescriptor->m_operators[DeviceType::CPU_NAIVE].size() != deviceCount)
+        {
+            std::cerr << "operator " << path[i] << " doesn't have a replica on every device" << std::endl;
+            return false;
+        }
+
+        for (unsigned int deviceId = 0; deviceId < deviceCount; ++deviceId)
+        {
+            Operator<DeviceType::CPU_NAIVE> *operatorBase = std::get<Operator<DeviceType::CPU_NAIVE>*>(operatorDescriptor->m_operators[DeviceType::CPU_NAIVE][deviceId]);
+            commandLists[deviceId]->m_commands.push_back(std::make_pair(operatorDescriptor, operatorBase));
+            commandLists[deviceId]->m_workEstimate += operatorDescriptor->m_workEstimate;
+        }
+    }
+
+    return true;
+}
+
+void FreeWill::CommandList::replay(const std::vector<CommandList*> &commandLists)
+{
+    unsigned long inlineWorkThreshold = Context<DeviceType::CPU_NAIVE>::getSingleton().inlineWorkThreshold();
+
+    for (unsigned int i = 0; i < commandLists.size(); ++i)
+    {
+        if (commandLists[i]->m_workEstimate >= inlineWorkThreshold)
+        {
+            commandLists[i]->submit();
+        }
+    }
+
+    //the small lists run here while the workers are busy with the others
+    for (unsigned int i = 0; i < commandLists.size(); ++i)
+    {
+        if (commandLists[i]->m_workEstimate < inlineWorkThreshold)
+        {
+            commandLists[i]->execute();
+        }
+    }
+
+    for (unsigned int i = 0; i < commandLists.size(); ++i)
+    {
+        if (commandLists[i]->m_workEstimate >= inlineWorkThreshold)
+        {
+            commandLists[i]->join();
+        }
+    }
+}
+
+void FreeWill::CommandList::start(const std::vector<CommandList*> &commandLists)
+{
+    for (unsigned int i = 0; i < commandLists.size(); ++i)
+    {
+        commandLists[i]->submit();
+    }
+}
+
+bool FreeWill::CommandList::finished(const std::vector<CommandList*> &commandLists)
+{
+    for (unsigned int i = 0; i < commandLists.size(); ++i)
+    {
+        if (!commandLists[i]->m_message.finished())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FreeWill::CommandList::wait(const std::vector<CommandList*> &commandLists)
+{
+    for (unsigned int i = 0; i < commandLists.size(); ++i)
+    {
+        commandLists[i]->join();
+    }
+}
+
+bool FreeWill::CommandList::runsInline() const
+{
+    return m_workEstimate < Context<DeviceType::CPU_NAIVE>::getSingleton().inlineWorkThreshold();
+}
+
+void FreeWill::CommandList::execute()
+{
+    for (unsigned int i = 0; i < m_commands.size(); ++i)
+    {
+        m_commands[i].first->reshapeForDevice<DeviceType::CPU_NAIVE>(*m_tensors, m_deviceId);
+        m_commands[i].second->evaluate();
+    }
+}
+
+void FreeWill::CommandList::submit()
+{
+    m_message.reset();
+    Context<DeviceType::CPU_NAIVE>::getSingleton().pushWork(m_deviceId, &m_message);
+}
+
+void FreeWill::CommandList::join()
+{
+    m_message.join();
+}
@@ -0,0 +1,72 @@
+#ifndef COMMANDLIST_H
+#define COMMANDLIST_H
+
+#include "../DeviceSelection.h"
+#include "../Context/WorkerMessage.h"
+#include <vector>
+#include <map>
+#include <string>
+
+namespace FreeWill
+{
+    class OperatorDescriptor;
+    class TensorDescriptor;
+
+    template <DeviceType DeviceUsed>
+    class Operator;
+
+    // The replicas a path runs on one device, recorded once in path order.
+    // Every step submits the single message of the list and the worker that
+    // picks it up runs the whole sequence. Replicas only touch the tensors of
+    // their own device, so lists of different devices never wait on each other.
+    class CommandList
+    {
+    private:
+        std::map<std::string, TensorDescriptor*> *m_tensors;
+        unsigned int m_deviceId;
+        std::vector<std::pair<OperatorDescriptor*, Operator<DeviceType::CPU_NAIVE>*>> m_commands;
+        unsigned long m_workEstimate;
+        WorkerMessage m_message;
+
+    public:
+        CommandList(std::map<std::string, TensorDescriptor*> *tensors, unsigned int deviceId);
+
+        CommandList(const CommandList &) = delete;
+        CommandList &operator=(const CommandList &) = delete;
+
+        static bool record(const std::vector<std::string> &path,
+                           std::map<std::string, OperatorDescriptor*> &operators,
+                           std::map<std::string, TensorDescriptor*> &tensors,
+                           std::vector<CommandList*> &commandLists);
+
+        static void replay(const std::vector<CommandList*> &commandLists);
+
+        //replay without blocking, every list goes to the workers
+        static void start(const std::vector<CommandList*> &commandLists);
+
+        static bool finished(const std::vector<CommandList*> &commandLists);
+
+        static void wait(const std::vector<CommandList*> &commandLists);
+
+        void execute();
+
+        void submit();
+
+        void join();
+
+        unsigned int deviceId() const
+        {
+            return m_deviceId;
+        }
+
+        unsigned int size() const
+        {
+            return m_commands.size();
+        }
+
+        //a list below the inline threshold as a whole is replayed on the caller
+        bool runsInline() const;
+    };
+}
+
+#endif
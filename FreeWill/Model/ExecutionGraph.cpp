@@ -0,0 +1,364 @@
+#include "ExecutionGraph.h"
+#include "OperatorDescriptor.h"
+#include "TensorDescriptor.h"
+#include "../Context/Context.h"
+#include <algorithm>
+
+FreeWill::ExecutionNode::ExecutionNode(ExecutionGraph *graph, OperatorDescriptor *operatorDescriptor, Operator<DeviceType::CPU_NAIVE> *operatorBase, unsigned int deviceId)
+    :m_graph(graph),
+      m_operatorDescriptor(operatorDescriptor),
+      m_operatorBase(operatorBase),
+      m_deviceId(deviceId),
+      m_workerId(deviceId),
+      m_executedWorkerId(-1),
+      m_isPinned(false),
+      m_successors(),
+      m_dependencyCount(0),
+      m_pendingDependencies(0),
+      m_inline(false),
+      m_message(this)
+{}
+
+void FreeWill::ExecutionNode::execute()
+{
+    Device<DeviceType::CPU_NAIVE> *worker = Device<DeviceType::CPU_NAIVE>::currentWorker();
+    m_executedWorkerId.store(worker ? (int) worker->deviceId() : -1, std::memory_order_relaxed);
+
+    m_operatorDescriptor->reshapeForDevice<DeviceType::CPU_NAIVE>(*m_graph->m_tensors, m_deviceId);
+
+    m_operatorBase->evaluate();
+
+    for (unsigned int i = 0; i < m_successors.size(); ++i)
+    {
+        ExecutionNode *successor = m_successors[i];
+
+        if (successor->m_pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            m_graph->submit(successor);
+        }
+    }
+
+    //must be the last thing touching the graph, run() may return right after
+    m_graph->nodeFinished();
+}
+
+FreeWill::ExecutionGraph::ExecutionGraph()
+    :m_nodes(),
+      m_roots(),
+      m_tensors(nullptr),
+      m_remainingNodes(0),
+      m_finished()
+{}
+
+FreeWill::ExecutionGraph::~ExecutionGraph()
+{
+    clear();
+}
+
+void FreeWill::ExecutionGraph::clear()
+{
+    for (unsigned int i = 0; i < m_nodes.size(); ++i)
+    {
+        delete m_nodes[i];
+    }
+
+    m_nodes.clear();
+    m_roots.clear();
+}
+
+void FreeWill::ExecutionGraph::addEdge(ExecutionNode *from, ExecutionNode *to)
+{
+    if (from == nullptr || from == to)
+    {
+        return;
+    }
+
+    if (std::find(from->m_successors.begin(), from->m_successors.end(), to) != from->m_successors.end())
+    {
+        return;
+    }
+
+    from->m_successors.push_back(to);
+    to->m_dependencyCount++;
+}
+
+std::pair<std::string, unsigned int> FreeWill::ExecutionGraph::accessKey(std::map<std::string, TensorDescriptor*> &tensors, const std::string &name, unsigned int deviceId)
+{
+    auto iter = tensors.find(name);
+
+    if (iter != tensors.end() && iter->second->m_isShared)
+    {
+        return std::make_pair(name, 0u);
+    }
+
+    return std::make_pair(name, deviceId);
+}
+
+bool FreeWill::ExecutionGraph::build(const std::vector<std::string> &path,
+                                     std::map<std::string, OperatorDescriptor*> &operators,
+                                     std::map<std::string, TensorDescriptor*> &tensors,
+                                     const std::vector<unsigned int> &stageWorkers)
+{
+    struct TensorAccess
+    {
+        ExecutionNode *m_lastWriter = nullptr;
+        std::vector<ExecutionNode*> m_readersSinceWrite;
+    };
+
+    clear();
+
+    m_tensors = &tensors;
+
+    if (path.empty())
+    {
+        return true;
+    }
+
+    unsigned int deviceCount = operators[path[0]]->m_operators[DeviceType::CPU_NAIVE].size();
+
+    std::vector<unsigned int> stages(path.size(), 0);
+
+    if (!stageWorkers.empty())
+    {
+        Context<DeviceType::CPU_NAIVE> &context = Context<DeviceType::CPU_NAIVE>::getSingleton();
+
+        for (unsigned int i = 0; i < stageWorkers.size(); ++i)
+        {
+            if (stageWorkers[i] >= (unsigned int) context.deviceCount())
+            {
+                std::cerr << "pipeline stage " << i << " has no worker " << stageWorkers[i] << std::endl;
+                return false;
+            }
+        }
+
+        //a worker only ever has one replica of each of its operators queued, as
+        //the replicas are chained, but all of them have to fit its private
+        //queue, with room to spare for runOnDevice
+        std::map<unsigned int, unsigned int> operatorsPerWorker;
+
+        unsigned long totalWork = 0;
+
+        for (unsigned int i = 0; i < path.size(); ++i)
+        {
+            totalWork += operators[path[i]]->m_workEstimate;
+        }
+
+        //an operator belongs to the stage its middle falls into
+        unsigned long workBefore = 0;
+
+        for (unsigned int i = 0; i < path.size(); ++i)
+        {
+            unsigned long work = operators[path[i]]->m_workEstimate;
+
+            if (totalWork > 0)
+            {
+                stages[i] = (unsigned int) (((workBefore + work / 2) * stageWorkers.size()) / totalWork);
+            }
+            else
+            {
+                stages[i] = (i * stageWorkers.size()) / path.size();
+            }
+
+            stages[i] = std::min(stages[i], (unsigned int) stageWorkers.size() - 1);
+            workBefore += work;
+
+            if (++operatorsPerWorker[stageWorkers[stages[i]]] >= context.privateWorkCapacity())
+            {
+                std::cerr << "pipeline worker " << stageWorkers[stages[i]] << " has more operators than its queue holds" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    //replicas only ever touch the tensors of their own device, except for shared
+    //tensors. Those are tracked once for all devices, which orders the devices
+    //wherever one of them writes a shared tensor.
+    std::map<std::pair<std::string, unsigned int>, TensorAccess> accesses;
+    std::vector<ExecutionNode*> previousReplicas(path.size(), nullptr);
+
+    for (unsigned int deviceId = 0; deviceId < deviceCount; ++deviceId)
+    {
+        for (unsigned int i = 0; i < path.size(); ++i)
+        {
+            OperatorDescriptor *operatorDescriptor = operators[path[i]];
+
+            if (operatorDescriptor->m_operators[DeviceType::CPU_NAIVE].size() != deviceCount)
+            {
+                std::cerr << "operator " << path[i] << " has no replica for device " << deviceId << std::endl;
+                clear();
+                return false;
+            }
+
+            Operator<DeviceType::CPU_NAIVE> *operatorBase = std::get<Operator<DeviceType::CPU_NAIVE>*>(operatorDescriptor->m_operators[DeviceType::CPU_NAIVE][deviceId]);
+
+            ExecutionNode *node = new ExecutionNode(this, operatorDescriptor, operatorBase, deviceId);
+            node->m_inline = stageWorkers.empty() && operatorDescriptor->runsInline<DeviceType::CPU_NAIVE>();
+            m_nodes.push_back(node);
+
+            if (!stageWorkers.empty())
+            {
+                //a stage works through the micro-batches one after the other
+                node->m_workerId = stageWorkers[stages[i]];
+                node->m_isPinned = true;
+                addEdge(previousReplicas[i], node);
+                previousReplicas[i] = node;
+            }
+
+            std::vector<std::string> reads;
+            std::vector<std::string> writes;
+
+            for (auto iter = operatorDescriptor->m_inputs.begin(); iter != operatorDescriptor->m_inputs.end(); ++iter)
+            {
+                if (iter->second.isReshaped() || operatorDescriptor->m_operatorName == OperatorName::RESHAPE)
+                {
+                    writes.push_back(iter->second.name());
+                }
+                else
+                {
+                    reads.push_back(iter->second.name());
+                }
+            }
+
+            for (auto iter = operatorDescriptor->m_outputs.begin(); iter != operatorDescriptor->m_outputs.end(); ++iter)
+            {
+                writes.push_back(iter->second.name());
+            }
+
+            for (unsigned int r = 0; r < reads.size(); ++r)
+            {
+                TensorAccess &access = accesses[accessKey(tensors, reads[r], deviceId)];
+                addEdge(access.m_lastWriter, node);
+                access.m_readersSinceWrite.push_back(node);
+            }
+
+            for (unsigned int w = 0; w < writes.size(); ++w)
+            {
+                TensorAccess &access = accesses[accessKey(tensors, writes[w], deviceId)];
+                addEdge(access.m_lastWriter, node);
+
+                for (unsigned int r = 0; r < access.m_readersSinceWrite.size(); ++r)
+                {
+                    addEdge(access.m_readersSinceWrite[r], node);
+                }
+
+                //memory planning reuses this tensor's memory for others, whose
+                //users have to be done before it is written
+                std::vector<std::string> &aliases = tensors[writes[w]]->m_aliases;
+
+                for (unsigned int a = 0; a < aliases.size(); ++a)
+                {
+                    TensorAccess &aliasAccess = accesses[accessKey(tensors, aliases[a], deviceId)];
+                    addEdge(aliasAccess.m_lastWriter, node);
+
+                    for (unsigned int r = 0; r < aliasAccess.m_readersSinceWrite.size(); ++r)
+                    {
+                        addEdge(aliasAccess.m_readersSinceWrite[r], node);
+                    }
+                }
+
+                access.m_lastWriter = node;
+                access.m_readersSinceWrite.clear();
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < m_nodes.size(); ++i)
+    {
+        if (m_nodes[i]->m_dependencyCount == 0)
+        {
+            m_roots.push_back(m_nodes[i]);
+        }
+    }
+
+    return true;
+}
+
+unsigned int FreeWill::ExecutionGraph::edgeCount() const
+{
+    unsigned int count = 0;
+
+    for (unsigned int i = 0; i < m_nodes.size(); ++i)
+    {
+        count += m_nodes[i]->m_successors.size();
+    }
+
+    return count;
+}
+
+void FreeWill::ExecutionGraph::submit(ExecutionNode *node)
+{
+    //recursion is bounded by the length of the path
+    if (node->m_inline)
+    {
+        node->execute();
+        return;
+    }
+
+    if (node->m_isPinned)
+    {
+        Context<DeviceType::CPU_NAIVE>::getSingleton().pushPrivateWork(node->m_workerId, &node->m_message);
+        return;
+    }
+
+    Context<DeviceType::CPU_NAIVE>::getSingleton().pushWork(node->m_workerId, &node->m_message);
+}
+
+void FreeWill::ExecutionGraph::nodeFinished()
+{
+    if (m_remainingNodes.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        m_finished.signal();
+    }
+}
+
+void FreeWill::ExecutionGraph::start()
+{
+    m_finished.reset();
+
+    if (m_nodes.empty())
+    {
+        m_finished.signal();
+        return;
+    }
+
+    for (unsigned int i = 0; i < m_nodes.size(); ++i)
+    {
+        m_nodes[i]->m_pendingDependencies.store(m_nodes[i]->m_dependencyCount, std::memory_order_relaxed);
+    }
+
+    m_remainingNodes.store(m_nodes.size(), std::memory_order_relaxed);
+
+    //the workers get their roots first, an inline root runs right here
+    //together with its inline successors and would hold them back
+    for (unsigned int i = 0; i < m_roots.size(); ++i)
+    {
+        if (!m_roots[i]->m_inline)
+        {
+            submit(m_roots[i]);
+        }
+    }
+
+    for (unsigned int i = 0; i < m_roots.size(); ++i)
+    {
+        if (m_roots[i]->m_inline)
+        {
+            submit(m_roots[i]);
+        }
+    }
+}
+
+bool FreeWill::ExecutionGraph::finished() const
+{
+    return m_finished.isDone();
+}
+
+void FreeWill::ExecutionGraph::wait()
+{
+    m_finished.wait();
+}
+
+void FreeWill::ExecutionGraph::run()
+{
+    start();
+    wait();
+}
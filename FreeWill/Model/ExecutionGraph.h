@@ -0,0 +1,141 @@
+#ifndef EXECUTIONGRAPH_H
+#define EXECUTIONGRAPH_H
+
+#include "../DeviceSelection.h"
+#include "../Context/WorkerMessage.h"
+#include "../Context/Completion.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <atomic>
+#include <utility>
+
+namespace FreeWill
+{
+    class OperatorDescriptor;
+    class TensorDescriptor;
+    class ExecutionGraph;
+
+    template <DeviceType DeviceUsed>
+    class Operator;
+
+    // One operator replica on one device. It is pushed to the workers as soon as
+    // the last node it depends on has finished.
+    class ExecutionNode
+    {
+        friend class ExecutionGraph;
+
+    private:
+        ExecutionGraph *m_graph;
+        OperatorDescriptor *m_operatorDescriptor;
+        Operator<DeviceType::CPU_NAIVE> *m_operatorBase;
+        unsigned int m_deviceId;
+        //the worker the node is pushed to, its device unless the graph is pipelined
+        unsigned int m_workerId;
+        //the worker that ran the node last time, -1 for a thread outside the pool
+        std::atomic<int> m_executedWorkerId;
+        //pipeline stages run only on their own worker, nothing steals them
+        bool m_isPinned;
+
+        std::vector<ExecutionNode*> m_successors;
+        unsigned int m_dependencyCount;
+        std::atomic<unsigned int> m_pendingDependencies;
+        //tiny operators run on the thread that released them
+        bool m_inline;
+
+        WorkerMessage m_message;
+
+    public:
+        ExecutionNode(ExecutionGraph *graph, OperatorDescriptor *operatorDescriptor, Operator<DeviceType::CPU_NAIVE> *operatorBase, unsigned int deviceId);
+
+        ExecutionNode(const ExecutionNode &) = delete;
+        ExecutionNode &operator=(const ExecutionNode &) = delete;
+
+        void execute();
+
+        unsigned int deviceId() const
+        {
+            return m_deviceId;
+        }
+
+        unsigned int workerId() const
+        {
+            return m_workerId;
+        }
+
+        int executedWorkerId() const
+        {
+            return m_executedWorkerId.load(std::memory_order_relaxed);
+        }
+    };
+
+    // Dependency DAG over the replicas of an operator path. Edges come from the
+    // tensors each operator touches: read after write, write after read and
+    // write after write. An input that is reshaped in place counts as a write.
+    // run(), or start() and wait(), is the only synchronization point,
+    // everything in between flows through the workers without barriers.
+    //
+    // Given stage workers the graph is pipelined instead: the path is cut into
+    // that many consecutive stages of about equal work, every replica of a
+    // stage runs on the stage's worker and the replicas act as micro-batches
+    // that pass through each operator in device order. Stage nodes go to the
+    // worker's private queue and are never inlined or stolen.
+    class ExecutionGraph
+    {
+        friend class ExecutionNode;
+
+    private:
+        std::vector<ExecutionNode*> m_nodes;
+        std::vector<ExecutionNode*> m_roots;
+        std::map<std::string, TensorDescriptor*> *m_tensors;
+
+        std::atomic<unsigned int> m_remainingNodes;
+        Completion m_finished;
+
+        void addEdge(ExecutionNode *from, ExecutionNode *to);
+
+        static std::pair<std::string, unsigned int> accessKey(std::map<std::string, TensorDescriptor*> &tensors, const std::string &name, unsigned int deviceId);
+
+        void submit(ExecutionNode *node);
+
+        void nodeFinished();
+
+        void clear();
+
+    public:
+        ExecutionGraph();
+
+        ExecutionGraph(const ExecutionGraph &) = delete;
+        ExecutionGraph &operator=(const ExecutionGraph &) = delete;
+
+        ~ExecutionGraph();
+
+        bool build(const std::vector<std::string> &path,
+                   std::map<std::string, OperatorDescriptor*> &operators,
+                   std::map<std::string, TensorDescriptor*> &tensors,
+                   const std::vector<unsigned int> &stageWorkers = std::vector<unsigned int>());
+
+        void run();
+
+        //start() returns once the roots are submitted, tiny roots run right there
+        void start();
+
+        bool finished() const;
+
+        void wait();
+
+        unsigned int nodeCount() const
+        {
+            return m_nodes.size();
+        }
+
+        const ExecutionNode *node(unsigned int index) const
+        {
+            return m_nodes[index];
+        }
+
+        unsigned int edgeCount() const;
+    };
+}
+
+#endif
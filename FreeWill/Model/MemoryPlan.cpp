@@ -0,0 +1,230 @@
+#include "MemoryPlan.h"
+#include "OperatorDescriptor.h"
+#include "TensorDescriptor.h"
+#include <algorithm>
+
+FreeWill::MemoryPlan::MemoryPlan()
+    :m_placements(),
+      m_peakBytes(0),
+      m_naiveBytes(0),
+      m_plannedBytes(0),
+      m_bufferAllocator(nullptr),
+      m_buffers(),
+      m_sliceAllocators()
+{}
+
+FreeWill::MemoryPlan::~MemoryPlan()
+{
+    releaseBuffers();
+}
+
+void FreeWill::MemoryPlan::build(const std::vector<std::string> &forwardPath,
+                                 const std::vector<std::string> &backwardPath,
+                                 std::map<std::string, OperatorDescriptor*> &operators,
+                                 std::map<std::string, TensorDescriptor*> &tensors,
+                                 const std::set<std::string> &persistentTensors,
+                                 unsigned int batchSize)
+{
+    struct Usage
+    {
+        unsigned int m_firstUse = 0;
+        unsigned int m_lastUse = 0;
+        bool m_writtenFirst = false;
+        bool m_readLast = false;
+        bool m_used = false;
+    };
+
+    releaseBuffers();
+    m_placements.clear();
+    m_peakBytes = 0;
+    m_naiveBytes = 0;
+    m_plannedBytes = 0;
+
+    std::vector<std::string> path = forwardPath;
+    path.insert(path.end(), backwardPath.begin(), backwardPath.end());
+
+    std::map<std::string, Usage> usages;
+
+    auto use = [&](const std::string &name, unsigned int index, bool isWrite)
+    {
+        Usage &usage = usages[name];
+
+        if (!usage.m_used)
+        {
+            usage.m_used = true;
+            usage.m_firstUse = index;
+            usage.m_writtenFirst = isWrite;
+        }
+
+        usage.m_lastUse = index;
+        usage.m_readLast = !isWrite;
+    };
+
+    //an operator reads all its inputs before it writes its outputs, outputs
+    //it adds into are read as well, so they can't be written first here
+    for (unsigned int i = 0; i < path.size(); ++i)
+    {
+        OperatorDescriptor *operatorDescriptor = operators[path[i]];
+
+        for (auto iter = operatorDescriptor->m_inputs.begin(); iter != operatorDescriptor->m_inputs.end(); ++iter)
+        {
+            use(iter->second.name(), i, false);
+        }
+
+        for (auto iter = operatorDescriptor->m_outputs.begin(); iter != operatorDescriptor->m_outputs.end(); ++iter)
+        {
+            if (operatorDescriptor->readsOutput(iter->first))
+            {
+                use(iter->second.name(), i, false);
+            }
+
+            use(iter->second.name(), i, true);
+        }
+    }
+
+    std::vector<std::string> candidates;
+
+    for (auto iter = tensors.begin(); iter != tensors.end(); ++iter)
+    {
+        size_t sizeInByte = Allocator::alignedSize(iter->second->sizeInByte(batchSize));
+        m_naiveBytes += sizeInByte;
+
+        auto usage = usages.find(iter->first);
+
+        if (usage != usages.end() && usage->second.m_writtenFirst && usage->second.m_readLast
+                && !iter->second->m_isShared && !iter->second->m_isBatchSliced && !iter->second->m_fileStorage
+                && persistentTensors.find(iter->first) == persistentTensors.end())
+        {
+            candidates.push_back(iter->first);
+            m_placements[iter->first] = {0, sizeInByte, usage->second.m_firstUse, usage->second.m_lastUse};
+        }
+        else
+        {
+            m_plannedBytes += sizeInByte;
+        }
+    }
+
+    //largest first, each at the lowest offset free for its whole lifetime
+    std::stable_sort(candidates.begin(), candidates.end(), [&](const std::string &a, const std::string &b)
+    {
+        return m_placements[a].m_sizeInByte > m_placements[b].m_sizeInByte;
+    });
+
+    std::vector<std::string> placed;
+
+    for (unsigned int c = 0; c < candidates.size(); ++c)
+    {
+        Placement &placement = m_placements[candidates[c]];
+
+        std::vector<const Placement*> conflicts;
+
+        for (unsigned int p = 0; p < placed.size(); ++p)
+        {
+            const Placement &other = m_placements[placed[p]];
+
+            if (other.m_firstUse <= placement.m_lastUse && placement.m_firstUse <= other.m_lastUse)
+            {
+                conflicts.push_back(&other);
+            }
+        }
+
+        std::sort(conflicts.begin(), conflicts.end(), [](const Placement *a, const Placement *b)
+        {
+            return a->m_offset < b->m_offset;
+        });
+
+        size_t offset = 0;
+
+        for (unsigned int i = 0; i < conflicts.size(); ++i)
+        {
+            if (offset + placement.m_sizeInByte <= conflicts[i]->m_offset)
+            {
+                break;
+            }
+
+            offset = std::max(offset, conflicts[i]->m_offset + conflicts[i]->m_sizeInByte);
+        }
+
+        placement.m_offset = offset;
+        m_peakBytes = std::max(m_peakBytes, offset + placement.m_sizeInByte);
+        placed.push_back(candidates[c]);
+    }
+
+    m_plannedBytes += m_peakBytes;
+}
+
+bool FreeWill::MemoryPlan::allocateBuffers(unsigned int deviceCount, Allocator *allocator)
+{
+    releaseBuffers();
+
+    m_bufferAllocator = allocator ? allocator : Allocator::defaultAllocator();
+
+    for (unsigned int deviceId = 0; deviceId < deviceCount; ++deviceId)
+    {
+        unsigned char *buffer = static_cast<unsigned char*>(m_bufferAllocator->allocate(m_peakBytes));
+
+        if (!buffer && m_peakBytes)
+        {
+            releaseBuffers();
+            return false;
+        }
+
+        m_buffers.push_back(buffer);
+
+        for (auto iter = m_placements.begin(); iter != m_placements.end(); ++iter)
+        {
+            m_sliceAllocators[iter->first].push_back(new SliceAllocator(buffer + iter->second.m_offset, iter->second.m_sizeInByte));
+        }
+    }
+
+    return true;
+}
+
+void FreeWill::MemoryPlan::releaseBuffers()
+{
+    for (auto iter = m_sliceAllocators.begin(); iter != m_sliceAllocators.end(); ++iter)
+    {
+        for (unsigned int i = 0; i < iter->second.size(); ++i)
+        {
+            delete iter->second[i];
+        }
+    }
+
+    m_sliceAllocators.clear();
+
+    for (unsigned int i = 0; i < m_buffers.size(); ++i)
+    {
+        m_bufferAllocator->deallocate(m_buffers[i], m_peakBytes);
+    }
+
+    m_buffers.clear();
+}
+
+const std::vector<FreeWill::Allocator*> &FreeWill::MemoryPlan::deviceAllocators(const std::string &name)
+{
+    return m_sliceAllocators[name];
+}
+
+std::vector<std::string> FreeWill::MemoryPlan::aliases(const std::string &name) const
+{
+    std::vector<std::string> result;
+
+    auto placement = m_placements.find(name);
+
+    if (placement == m_placements.end())
+    {
+        return result;
+    }
+
+    for (auto iter = m_placements.begin(); iter != m_placements.end(); ++iter)
+    {
+        if (iter->first != name
+                && iter->second.m_offset < placement->second.m_offset + placement->second.m_sizeInByte
+                && placement->second.m_offset < iter->second.m_offset + iter->second.m_sizeInByte)
+        {
+            result.push_back(iter->first);
+        }
+    }
+
+    return result;
+}
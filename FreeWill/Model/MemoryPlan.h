@@ -0,0 +1,104 @@
+#ifndef MEMORYPLAN_H
+#define MEMORYPLAN_H
+
+#include "../Tensor/Allocator.h"
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+
+namespace FreeWill
+{
+    class OperatorDescriptor;
+    class TensorDescriptor;
+
+    // Lets intermediate tensors whose lifetimes never overlap share memory.
+    // Lifetimes are measured in operators over the forward path followed by
+    // the backward path. A tensor is planned only if it is written before it
+    // is read within that step and its last use is a read, an output that
+    // an operator adds into counts as read by it. Inputs, results
+    // the caller reads afterwards and the weight update pairs keep memory of
+    // their own. A planned tensor holds valid data only from its first write
+    // to its last read.
+    //
+    // Every device gets one buffer of peakBytes(), each planned tensor a fixed
+    // offset into it.
+    class MemoryPlan
+    {
+    public:
+        struct Placement
+        {
+            size_t m_offset;
+            size_t m_sizeInByte;
+            unsigned int m_firstUse;
+            unsigned int m_lastUse;
+        };
+
+    private:
+        std::map<std::string, Placement> m_placements;
+        size_t m_peakBytes;
+        size_t m_naiveBytes;
+        size_t m_plannedBytes;
+
+        Allocator *m_bufferAllocator;
+        std::vector<unsigned char*> m_buffers;
+        std::map<std::string, std::vector<Allocator*>> m_sliceAllocators;
+
+    public:
+        MemoryPlan();
+
+        MemoryPlan(const MemoryPlan &) = delete;
+        MemoryPlan &operator=(const MemoryPlan &) = delete;
+
+        ~MemoryPlan();
+
+        void build(const std::vector<std::string> &forwardPath,
+                   const std::vector<std::string> &backwardPath,
+                   std::map<std::string, OperatorDescriptor*> &operators,
+                   std::map<std::string, TensorDescriptor*> &tensors,
+                   const std::set<std::string> &persistentTensors,
+                   unsigned int batchSize);
+
+        //takes the per device buffers from allocator, nullptr means the default
+        bool allocateBuffers(unsigned int deviceCount, Allocator *allocator);
+
+        //every planned tensor has to be gone by now
+        void releaseBuffers();
+
+        bool isPlanned(const std::string &name) const
+        {
+            return m_placements.find(name) != m_placements.end();
+        }
+
+        //the slice of a planned tensor, one per device
+        const std::vector<Allocator*> &deviceAllocators(const std::string &name);
+
+        //planned tensors that share some memory with this one
+        std::vector<std::string> aliases(const std::string &name) const;
+
+        const std::map<std::string, Placement> &placements() const
+        {
+            return m_placements;
+        }
+
+        //one device's buffer for the planned tensors
+        size_t peakBytes() const
+        {
+            return m_peakBytes;
+        }
+
+        //one device's memory if every tensor had its own
+        size_t naiveBytes() const
+        {
+            return m_naiveBytes;
+        }
+
+        //one device's memory with the plan, unplanned tensors plus the buffer
+        size_t plannedBytes() const
+        {
+            return m_plannedBytes;
+        }
+    };
+}
+
+#endif
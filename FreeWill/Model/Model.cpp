@@ -26,10 +26,50 @@ FreeWill::TensorDescriptorHandle FreeWill::Model::addTensor(const std::string &n
 
 FreeWill::Model::Model()
     :m_tensors(),
-      m_operators()
+      m_operators(),
+      m_forwardGraph(nullptr),
+      m_backwardGraph(nullptr),
+      m_forwardCommandLists(),
+      m_backwardCommandLists(),
+      m_arenaAllocation(false),
+      m_arena(nullptr),
+      m_memoryPlanning(false),
+      m_memoryPlan()
 {
 }
 
+void FreeWill::Model::setArenaAllocation(bool enabled)
+{
+    m_arenaAllocation = enabled;
+}
+
+void FreeWill::Model::setMemoryPlanning(bool enabled)
+{
+    m_memoryPlanning = enabled;
+}
+
+void FreeWill::Model::clearExecutionGraphs()
+{
+    delete m_forwardGraph;
+    m_forwardGraph = nullptr;
+    delete m_backwardGraph;
+    m_backwardGraph = nullptr;
+
+    for(unsigned int i = 0; i < m_forwardCommandLists.size(); ++i)
+    {
+        delete m_forwardCommandLists[i];
+    }
+
+    m_forwardCommandLists.clear();
+
+    for(unsigned int i = 0; i < m_backwardCommandLists.size(); ++i)
+    {
+        delete m_backwardCommandLists[i];
+    }
+
+    m_backwardCommandLists.clear();
+}
+
 FreeWill::OperatorDescriptorHandle FreeWill::Model::addOperator(const std::string &name,
                                  const std::string &operatorNameString,
                                  const std::map<std::string, FreeWill::TensorDescriptorHandle> &inputs,
@@ -68,6 +108,8 @@ FreeWill::OperatorDescriptorHandle FreeWill::Model::addOperator(const std::strin
 
 bool FreeWill::Model::init(Solver const &solver)
 {
+    clearExecutionGraphs();
+
     //allocating tensors
     std::map<std::string, TensorDescriptor*>::iterator iterTensor = m_tensors.begin();
 
@@ -75,6 +117,94 @@ bool FreeWill::Model::init(Solver const &solver)
 
     std::map<std::string, OperatorDescriptor*>::iterator iterOperator = m_operators.begin();
 
+    //pipeline stages push all micro-batches through the same parameters, only
+    //activations and gradients need a copy per device
+    if (solver.m_deviceUsed == DeviceType::CPU_NAIVE && solver.m_executionMode == ExecutionMode::PIPELINE)
+    {
+        for(auto iter = m_updatePairs.begin(); iter != m_updatePairs.end(); ++iter)
+        {
+            if (m_tensors.find(iter->first.name()) != m_tensors.end())
+            {
+                m_tensors[iter->first.name()]->m_isShared = true;
+            }
+        }
+    }
+
+    //on shared memory every tensor no operator writes can be read by all
+    //devices from one copy, only batch tensors and gradients stay per device
+    if (solver.m_deviceUsed == DeviceType::CPU_NAIVE && solver.m_sharedParameters)
+    {
+        std::set<std::string> perDeviceTensors;
+
+        for(auto iter = m_operators.begin(); iter != m_operators.end(); ++iter)
+        {
+            for(auto output = iter->second->m_outputs.begin(); output != iter->second->m_outputs.end(); ++output)
+            {
+                perDeviceTensors.insert(output->second.name());
+            }
+        }
+
+        for(auto iter = m_updatePairs.begin(); iter != m_updatePairs.end(); ++iter)
+        {
+            perDeviceTensors.insert(iter->second.name());
+        }
+
+        for(auto iter = m_tensors.begin(); iter != m_tensors.end(); ++iter)
+        {
+            if (!iter->second->m_isBatchTensor && perDeviceTensors.find(iter->first) == perDeviceTensors.end())
+            {
+                iter->second->m_isShared = true;
+            }
+        }
+    }
+
+    unsigned int deviceCount = (solver.m_deviceUsed == DeviceType::GPU_CUDA) ? Context<DeviceType::GPU_CUDA>::getSingleton().deviceCount()
+                                                                            : Context<DeviceType::CPU_NAIVE>::getSingleton().deviceCount();
+
+    if (m_memoryPlanning && solver.m_deviceUsed == DeviceType::CPU_NAIVE)
+    {
+        std::set<std::string> persistentTensors;
+
+        for(auto iter = m_updatePairs.begin(); iter != m_updatePairs.end(); ++iter)
+        {
+            persistentTensors.insert(iter->first.name());
+            persistentTensors.insert(iter->second.name());
+        }
+
+        m_memoryPlan.build(m_forwardPath, m_backwardPath, m_operators, m_tensors, persistentTensors, solver.m_batchSize);
+
+        for(auto iter = m_tensors.begin(); iter != m_tensors.end(); ++iter)
+        {
+            iter->second->m_aliases = m_memoryPlan.aliases(iter->first);
+        }
+    }
+
+    if (m_arenaAllocation && !m_arena)
+    {
+        size_t arenaSize = 0;
+
+        for(auto iter = m_tensors.begin(); iter != m_tensors.end(); ++iter)
+        {
+            if (m_memoryPlan.isPlanned(iter->first) || iter->second->m_fileStorage)
+            {
+                continue;
+            }
+
+            unsigned int copyCount = iter->second->m_isShared ? 1 : deviceCount;
+            arenaSize += copyCount * Allocator::alignedSize(iter->second->sizeInByte(solver.m_batchSize));
+        }
+
+        arenaSize += deviceCount * Allocator::alignedSize(m_memoryPlan.peakBytes());
+
+        m_arena = new ArenaAllocator(arenaSize);
+    }
+
+    if (!m_memoryPlan.placements().empty() && !m_memoryPlan.allocateBuffers(deviceCount, m_arena))
+    {
+        std::cerr << "can't allocate the planned buffers" << std::endl;
+        return false;
+    }
+
     switch (solver.m_deviceUsed)
     {
     case DeviceType::CPU_NAIVE:
@@ -82,7 +212,7 @@ bool FreeWill::Model::init(Solver const &solver)
         {
             std::cout << iterTensor->first << std::endl;
             TensorDescriptor *descriptor = iterTensor->second;
-            descriptor->allocateTensor<FreeWill::DeviceType::CPU_NAIVE>(solver.m_batchSize);
+            descriptor->allocateTensor<FreeWill::DeviceType::CPU_NAIVE>(solver.m_batchSize, m_arena, m_memoryPlan.deviceAllocators(iterTensor->first));
         }
 
         for(;iterOperator != m_operators.end(); ++iterOperator)
@@ -104,7 +234,7 @@ bool FreeWill::Model::init(Solver const &solver)
         {
             std::cout << iterTensor->first << std::endl;
             TensorDescriptor *descriptor = iterTensor->second;
-            descriptor->allocateTensor<FreeWill::DeviceType::GPU_CUDA>(solver.m_batchSize);
+            descriptor->allocateTensor<FreeWill::DeviceType::GPU_CUDA>(solver.m_batchSize, m_arena);
         }
 
         for(;iterOperator != m_operators.end(); ++iterOperator)
@@ -130,6 +260,7 @@ bool FreeWill::Model::init(Solver const &solver)
 bool FreeWill::Model::defineForwardPath(const std::vector<FreeWill::OperatorDescriptorHandle> &forwardOperators)
 {
     m_forwardPath.clear();
+    clearExecutionGraphs();
 
     for(unsigned int i = 0; i<forwardOperators.size();++i)
     {
@@ -150,6 +281,7 @@ bool FreeWill::Model::defineForwardPath(const std::vector<FreeWill::OperatorDesc
 bool FreeWill::Model::defineBackwardPath(const std::vector<FreeWill::OperatorDescriptorHandle> &backwardOperators)
 {
     m_backwardPath.clear();
+    clearExecutionGraphs();
 
     for(unsigned int i = 0; i<backwardOperators.size();++i)
     {
@@ -234,4 +366,26 @@ void FreeWill::Model::generateSVGDiagram(const std::string &filename)
     outputStream.close();
 }
 
-FreeWill::Model::~Model(){}
+FreeWill::Model::~Model()
+{
+    clearExecutionGraphs();
+
+    //operators first, their replicas point into the tensors
+    for(auto iter = m_operators.begin(); iter != m_operators.end(); ++iter)
+    {
+        delete iter->second;
+    }
+
+    m_operators.clear();
+
+    for(auto iter = m_tensors.begin(); iter != m_tensors.end(); ++iter)
+    {
+        delete iter->second;
+    }
+
+    m_tensors.clear();
+
+    m_memoryPlan.releaseBuffers();
+
+    delete m_arena;
+}
@@ -11,6 +11,10 @@
 #include "TensorDescriptor.h"
 #include "OperatorDescriptor.h"
 #include "Solver.h"
+#include "ExecutionGraph.h"
+#include "CommandList.h"
+#include "MemoryPlan.h"
+#include "Calibration.h"
 #include <sstream>
 
 
@@ -22,6 +26,7 @@ namespace FreeWill
     {
         friend class Solver;
         friend class TensorDescriptorHandle;
+        friend class Calibration;
 
     private:
         Model();
@@ -35,12 +40,52 @@ namespace FreeWill
         std::vector<OperatorDescriptorHandle> m_forwardPath;
         std::vector<OperatorDescriptorHandle> m_backwardPath;
 
+        //built on first use by the Solver, dropped whenever paths or operators change
+        ExecutionGraph *m_forwardGraph;
+        ExecutionGraph *m_backwardGraph;
+        std::vector<CommandList*> m_forwardCommandLists;
+        std::vector<CommandList*> m_backwardCommandLists;
+
+        //with arena allocation all tensors of init() come from this one slab
+        bool m_arenaAllocation;
+        ArenaAllocator *m_arena;
+
+        //with memory planning intermediates with disjoint lifetimes share memory
+        bool m_memoryPlanning;
+        MemoryPlan m_memoryPlan;
+
+        void clearExecutionGraphs();
+
 
 
     public:
         static Model* create();
         ~Model();
         bool init(Solver const &solver);
+
+        //call before init(), the slab is sized for all tensors and released
+        //in one go when the model is deleted
+        void setArenaAllocation(bool enabled);
+
+        const ArenaAllocator *arena() const
+        {
+            return m_arena;
+        }
+
+        //call before init(), see MemoryPlan for which tensors get planned.
+        //Only CPU models are planned.
+        void setMemoryPlanning(bool enabled);
+
+        const MemoryPlan &memoryPlan() const
+        {
+            return m_memoryPlan;
+        }
+
+        //the CPU graph of GRAPH and PIPELINE mode, nullptr until it is built
+        const ExecutionGraph *executionGraph(bool isBackward) const
+        {
+            return isBackward ? m_backwardGraph : m_forwardGraph;
+        }
         TensorDescriptorHandle addTensor(const std::string &name, const Shape &shape, DataType dataType = DataType::FLOAT, bool isBatchTensor = false, bool isRandomlyInitialized = false);
         OperatorDescriptorHandle addOperator(const std::string &name,
                         const std::string &operatorName,
@@ -81,11 +126,33 @@ namespace FreeWill
            return static_cast<DataType*>(tensorBase->cpuDataHandle());
         }
 
+        //the whole batch of a sliced tensor, device 0's samples first. filling it
+        //fills every device's tensor, there is nothing to end afterwards
+        template<typename DataType = float>
+        DataType *beginMutateBatch(const TensorDescriptorHandle &tensorDescriptorHandle)
+        {
+           TensorDescriptor* tensorDescriptor = m_tensors[tensorDescriptorHandle.name()];
+
+           if (!tensorDescriptor->m_slicedBatch)
+           {
+               std::cerr << "tensor " << tensorDescriptorHandle.name() << " has no sliced batch" << std::endl;
+               return nullptr;
+           }
+
+           return static_cast<DataType*>(tensorDescriptor->m_slicedBatch->cpuDataHandle());
+        }
+
         template<DeviceType DeviceUsed = DeviceType::CPU_NAIVE>
         void endMutateData(const TensorDescriptorHandle &tensorDescriptorHandle, int deviceId = -1)
         {
             TensorDescriptor* tensorDescriptor = m_tensors[tensorDescriptorHandle.name()];
 
+            //every device has samples of its own, there is nothing to broadcast
+            if (deviceId < 0 && tensorDescriptor->m_slicedBatch)
+            {
+                return;
+            }
+
             if (deviceId < 0)
             {
                 unsigned char *sourcePtr = static_cast<unsigned char*>(std::get<TensorBase<DeviceUsed>*>(tensorDescriptor->m_tensors[DeviceUsed][0])->cpuDataHandle());
@@ -95,6 +162,11 @@ namespace FreeWill
                 {
                     unsigned char *destPtr = static_cast<unsigned char*>(std::get<TensorBase<DeviceUsed>*>(tensorDescriptor->m_tensors[DeviceUsed][i])->cpuDataHandle());
 
+                    if (destPtr == sourcePtr)
+                    {
+                        continue;
+                    }
+
                     std::copy(sourcePtr, sourcePtr + sourceSize, destPtr);
 
                     if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
@@ -151,6 +223,11 @@ namespace FreeWill
             {
                 TensorBase<DeviceUsed> *tensor = std::get<TensorBase<DeviceUsed>*> (tensorDescriptor->m_tensors[DeviceUsed][i]);
 
+                if (tensor == tensorBase)
+                {
+                    continue;
+                }
+
                 ElementwiseAdd<DeviceUsed, DataType> *elementwiseAdd = new ElementwiseAdd<DeviceUsed, DataType>();
                 elementwiseAdd->setInputParameter("OperandA", tensorBase);
                 elementwiseAdd->setInputParameter("OperandB", tensor);
@@ -194,6 +271,12 @@ namespace FreeWill
             {
                 TensorBase<DeviceUsed> *operandATensorBaseDup = std::get<TensorBase<DeviceUsed>*>(operandATensorDescriptor->m_tensors[DeviceUsed][i]);
 
+                //shared parameters are updated in place for every device
+                if (operandATensorBaseDup == operandATensorBase)
+                {
+                    continue;
+                }
+
                 ElementwiseAdd<DeviceUsed, DataType> *elementwiseAdd = new ElementwiseAdd<DeviceUsed, DataType>(0.0f);
 
                 elementwiseAdd->setInputParameter("OperandA", operandATensorBase);
@@ -12,9 +12,86 @@ FreeWill::OperatorDescriptor::OperatorDescriptor(const std::string &name,
       m_operatorName(operatorName),
       m_inputs(inputs),
       m_outputs(outputs),
-      m_parameters(parameters)
+      m_parameters(parameters),
+      m_workEstimate(0)
+{
+}
+
+void FreeWill::OperatorDescriptor::estimateWork(std::map<std::string, FreeWill::TensorDescriptor*> &tensors)
+{
+    auto elementCount = [&](const FreeWill::TensorDescriptorHandle &handle) -> unsigned long
+    {
+        FreeWill::TensorDescriptor *tensorDescriptor = tensors[handle.name()];
+        unsigned long count = tensorDescriptor->m_shape.size();
+        return tensorDescriptor->m_isBatchTensor ? count * tensorDescriptor->m_batchSize : count;
+    };
+
+    unsigned long batchSize = 1;
+    unsigned long elements = 0;
+
+    for(auto iter = m_inputs.begin(); iter != m_inputs.end(); ++iter)
+    {
+        FreeWill::TensorDescriptor *tensorDescriptor = tensors[iter->second.name()];
+        if (tensorDescriptor->m_isBatchTensor)
+        {
+            batchSize = std::max(batchSize, (unsigned long) tensorDescriptor->m_batchSize);
+        }
+        elements += elementCount(iter->second);
+    }
+
+    for(auto iter = m_outputs.begin(); iter != m_outputs.end(); ++iter)
+    {
+        elements += elementCount(iter->second);
+    }
+
+    //multiply-adds for the dense and convolution kernels, touched elements for the rest
+    if (m_inputs.find("Weight") != m_inputs.end())
+    {
+        m_workEstimate = elementCount(m_inputs["Weight"]) * batchSize;
+    }
+    else if (m_inputs.find("FeatureMap") != m_inputs.end())
+    {
+        FreeWill::TensorDescriptorHandle &featureMap = m_inputs["FeatureMap"];
+        const FreeWill::Shape &featureMapShape = tensors[featureMap.name()]->m_shape;
+        unsigned long filterSize = featureMapShape.dimension() ? featureMapShape.size() / std::max(featureMapShape[featureMapShape.dimension() - 1], 1u) : 1;
+        unsigned long outputSize = 0;
+
+        if (m_outputs.find("Output") != m_outputs.end())
+        {
+            outputSize = elementCount(m_outputs["Output"]);
+        }
+        else if (m_inputs.find("OutputGrad") != m_inputs.end())
+        {
+            outputSize = elementCount(m_inputs["OutputGrad"]);
+        }
+
+        m_workEstimate = outputSize * filterSize;
+    }
+    else
+    {
+        m_workEstimate = elements;
+    }
+}
 
+bool FreeWill::OperatorDescriptor::readsOutput(const std::string &outputName) const
 {
+    switch(m_operatorName)
+    {
+    case FreeWill::OperatorName::CONVOLUTION:
+        return outputName == "Output" && m_dataType != DataType::INT8;
+    case FreeWill::OperatorName::CONVOLUTION_DERIVATIVE:
+        return true;
+    case FreeWill::OperatorName::MAX_POOLING_DERIVATIVE:
+        //only the maximum of every window gets a gradient
+        return outputName == "InputGrad";
+    case FreeWill::OperatorName::DOT_PRODUCT_WITH_BIAS_DERIVATIVE:
+    {
+        auto accumulate = m_parameters.find("Accumulate");
+        return accumulate != m_parameters.end() && std::any_cast<bool>(accumulate->second);
+    }
+    default:
+        return false;
+    }
 }
 
 FreeWill::OperatorDescriptor::~OperatorDescriptor()
@@ -38,6 +115,16 @@ FreeWill::OperatorDescriptor::~OperatorDescriptor()
     }
 
     m_operators[FreeWill::DeviceType::GPU_CUDA].clear();
+
+    for(auto iter = m_messages.begin(); iter != m_messages.end(); ++iter)
+    {
+        for(unsigned int i = 0; i < iter->second.size(); ++i)
+        {
+            delete iter->second[i];
+        }
+    }
+
+    m_messages.clear();
 }
 
 void FreeWill::OperatorDescriptor::evaluateSVGDiagramSize(unsigned int &width, unsigned int &height)
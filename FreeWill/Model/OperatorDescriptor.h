@@ -17,6 +17,8 @@
 #include "../Operator/SoftmaxLogLossDerivative.h"
 #include "../Operator/Duplicate.h"
 #include "../Operator/Reshape.h"
+#include "../Operator/QuantizedDotProductWithBias.h"
+#include "../Operator/QuantizedConvolution.h"
 #include "TensorDescriptor.h"
 #include <any>
 #include <fstream>
@@ -29,6 +31,9 @@ namespace FreeWill
 
     class Model;
     class Solver;
+    class ExecutionGraph;
+    class ExecutionNode;
+    class MemoryPlan;
 
     typedef std::string OperatorDescriptorHandle;
 
@@ -36,6 +41,10 @@ namespace FreeWill
     {
         friend class Model;
         friend class Solver;
+        friend class ExecutionGraph;
+        friend class ExecutionNode;
+        friend class CommandList;
+        friend class MemoryPlan;
 
         constexpr static const float topBottomMargin = 20;
         constexpr static const float centerSpace = 40;
@@ -56,8 +65,12 @@ namespace FreeWill
         std::map<std::string, FreeWill::TensorDescriptorHandle> m_outputs;
         std::map<std::string, std::any> m_parameters;
         std::map<DeviceType, std::vector<std::variant<Operator<DeviceType::GPU_CUDA>*, Operator<DeviceType::CPU_NAIVE>*>>> m_operators;
-        std::vector<FreeWill::TensorDescriptorHandle> m_inputsNeedReshape;
-        std::vector<FreeWill::TensorDescriptorHandle> m_outputsNeedReshape;
+        //tensors this operator sees in a different shape, with the batch already appended
+        std::vector<std::pair<TensorDescriptor*, Shape>> m_reshapeTargets;
+        //one message per replica, reused by every evaluate()
+        std::map<DeviceType, std::vector<WorkerMessage*>> m_messages;
+        //rough cost of one replica, set by init()
+        unsigned long m_workEstimate;
 
         OperatorDescriptor(const std::string &name, OperatorName operatorName,
                            const std::map<std::string, FreeWill::TensorDescriptorHandle> &inputs,
@@ -68,10 +81,69 @@ namespace FreeWill
         void generateSVGDiagram(std::ostream &outputStream, unsigned int &width, unsigned int &height);
         void evaluateSVGDiagramSize(unsigned int &width, unsigned int &height);
 
+        void estimateWork(std::map<std::string, TensorDescriptor*> &tensors);
+
+        //the CPU kernel adds into this output or writes only part of it, so
+        //whatever the output held before evaluate() is part of the result
+        bool readsOutput(const std::string &outputName) const;
+
+        //too little work to be worth a round trip through a worker
+        template<DeviceType DeviceUsed>
+        bool runsInline() const
+        {
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                return m_workEstimate < Context<DeviceUsed>::getSingleton().inlineWorkThreshold();
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        //one shape per tensor, evaluate() can't reshape it two ways at once
+        bool addReshapeTarget(TensorDescriptor *tensorDescriptor, const Shape &newShape)
+        {
+            Shape targetShape = tensorDescriptor->m_isBatchTensor?(newShape + tensorDescriptor->m_batchSize):newShape;
+
+            for(unsigned int i = 0;i<m_reshapeTargets.size();++i)
+            {
+                if (m_reshapeTargets[i].first == tensorDescriptor)
+                {
+                    if (m_reshapeTargets[i].second != targetShape)
+                    {
+                        std::cerr << "operator " << m_name << " reshapes tensor " << tensorDescriptor->m_name << " to both " << m_reshapeTargets[i].second << " and " << targetShape << std::endl;
+                        return false;
+                    }
+
+                    return true;
+                }
+            }
+
+            m_reshapeTargets.push_back(std::make_pair(tensorDescriptor, targetShape));
+
+            return true;
+        }
+
+        //16 bit and int8 data only have CPU kernels, anything else gets no operator
+        template<DeviceType DeviceUsed, typename CPUOperator, typename ...Arguments>
+        Operator<DeviceUsed> *newCPUOperator(Arguments ...arguments)
+        {
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                return new CPUOperator(arguments...);
+            }
+            else
+            {
+                std::cerr << "operator " << m_name << " has no GPU kernel for its data type" << std::endl;
+                return nullptr;
+            }
+        }
+
         template<DeviceType DeviceUsed>
         bool setInput(Operator<DeviceUsed> *operatorBase, const std::string &inputName, std::map<std::string, FreeWill::TensorDescriptor*> &tensors, int deviceId)
         {
-            if (m_inputs.find(inputName) == m_inputs.end())
+            if (!operatorBase || m_inputs.find(inputName) == m_inputs.end())
             {
                 return false;
             }
@@ -87,7 +159,11 @@ namespace FreeWill
                     std::cerr << "Reshape failed for input: " << inputName << " tensor: " << tensorBase->name() << " from: " << tensorBase->shape() << " to: " << m_inputs[inputName].shape() << std::endl;
                     return false;
                 }
-                m_inputsNeedReshape.push_back(m_inputs[inputName]);
+
+                if (!addReshapeTarget(tensorDescriptor, newShape))
+                {
+                    return false;
+                }
             }
 
             operatorBase->setInputParameter(inputName, tensorBase);
@@ -98,7 +174,7 @@ namespace FreeWill
         template<DeviceType DeviceUsed>
         bool setOutput(Operator<DeviceUsed> *operatorBase, const std::string &outputName, std::map<std::string, FreeWill::TensorDescriptor*> &tensors, int deviceId)
         {
-            if (m_outputs.find(outputName) == m_outputs.end())
+            if (!operatorBase || m_outputs.find(outputName) == m_outputs.end())
             {
                 return false;
             }
@@ -115,7 +191,11 @@ namespace FreeWill
                     std::cerr << "Reshape failed for output: " << outputName << " tensor: " << tensorBase->name() << " from: " << tensorBase->shape() << " to: " << m_outputs[outputName].shape() << std::endl;
                     return false;
                 }
-                m_outputsNeedReshape.push_back(m_outputs[outputName]);
+
+                if (!addReshapeTarget(tensorDescriptor, newShape))
+                {
+                    return false;
+                }
             }
 
             operatorBase->setOutputParameter(outputName, tensorBase);
@@ -144,10 +224,17 @@ namespace FreeWill
                 case DataType::DOUBLE:
                     operatorBase = new Activation<ActivationMode::SIGMOID, DeviceUsed, double>(deviceId);
                     break;
+                case DataType::BFLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, Activation<ActivationMode::SIGMOID, DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                    break;
+                case DataType::FLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, Activation<ActivationMode::SIGMOID, DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                    break;
                 /*case UNSIGNED_INT:
                     operatorBase = new Activation<SIGMOID, DeviceUsed, unsigned int>();
                     break;*/
                 case DataType::UNSIGNED_INT:
+                case DataType::INT8:
                     return nullptr;
                 }
                 break;
@@ -160,10 +247,17 @@ namespace FreeWill
                 case DataType::DOUBLE:
                     operatorBase = new Activation<ActivationMode::RELU, DeviceUsed, double>(deviceId);
                     break;
+                case DataType::BFLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, Activation<ActivationMode::RELU, DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                    break;
+                case DataType::FLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, Activation<ActivationMode::RELU, DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                    break;
                 /*case UNSIGNED_INT:
                     operatorBase = new Activation<RELU, DeviceUsed, unsigned int>();
                     break;*/
                 case DataType::UNSIGNED_INT:
+                case DataType::INT8:
                     return nullptr;
 
                 }
@@ -177,10 +271,17 @@ namespace FreeWill
                 case DataType::DOUBLE:
                     operatorBase = new Activation<ActivationMode::TANH, DeviceUsed, double>(deviceId);
                     break;
+                case DataType::BFLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, Activation<ActivationMode::TANH, DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                    break;
+                case DataType::FLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, Activation<ActivationMode::TANH, DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                    break;
                 /*case UNSIGNED_INT:
                     operatorBase = new Activation<TANH, DeviceUsed, unsigned int>();
                     break;*/
                 case DataType::UNSIGNED_INT:
+                case DataType::INT8:
                     return nullptr;
 
                 }
@@ -194,10 +295,17 @@ namespace FreeWill
                 case DataType::DOUBLE:
                     operatorBase = new Activation<ActivationMode::CLIPPED_RELU, DeviceUsed, double>(deviceId);
                     break;
+                case DataType::BFLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, Activation<ActivationMode::CLIPPED_RELU, DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                    break;
+                case DataType::FLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, Activation<ActivationMode::CLIPPED_RELU, DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                    break;
                 /*case UNSIGNED_INT:
                     operatorBase = new Activation<CLIPPED_RELU, DeviceUsed, unsigned int>();
                     break;*/
                 case DataType::UNSIGNED_INT:
+                case DataType::INT8:
                     return nullptr;
 
                 }
@@ -235,10 +343,17 @@ namespace FreeWill
                 case DataType::DOUBLE:
                     operatorBase = new ActivationDerivative<ActivationMode::SIGMOID, DeviceUsed, double>(deviceId);
                     break;
+                case DataType::BFLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, ActivationDerivative<ActivationMode::SIGMOID, DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                    break;
+                case DataType::FLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, ActivationDerivative<ActivationMode::SIGMOID, DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                    break;
                 /*case UNSIGNED_INT:
                     operatorBase = new ActivationDerivative<SIGMOID, DeviceUsed, unsigned int>();
                     break;*/
                 case DataType::UNSIGNED_INT:
+                case DataType::INT8:
                     return nullptr;
                 }
                 break;
@@ -251,10 +366,17 @@ namespace FreeWill
                 case DataType::DOUBLE:
                     operatorBase = new ActivationDerivative<ActivationMode::RELU, DeviceUsed, double>(deviceId);
                     break;
+                case DataType::BFLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, ActivationDerivative<ActivationMode::RELU, DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                    break;
+                case DataType::FLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, ActivationDerivative<ActivationMode::RELU, DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                    break;
                 /*case UNSIGNED_INT:
                     operatorBase = new ActivationDerivative<RELU, DeviceUsed, unsigned int>();
                     break;*/
                 case DataType::UNSIGNED_INT:
+                case DataType::INT8:
                     return nullptr;
                 }
                 break;
@@ -267,10 +389,17 @@ namespace FreeWill
                 case DataType::DOUBLE:
                     operatorBase = new ActivationDerivative<ActivationMode::TANH, DeviceUsed, double>(deviceId);
                     break;
+                case DataType::BFLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, ActivationDerivative<ActivationMode::TANH, DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                    break;
+                case DataType::FLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, ActivationDerivative<ActivationMode::TANH, DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                    break;
                 /*case UNSIGNED_INT:
                     operatorBase = new ActivationDerivative<TANH, DeviceUsed, unsigned int>();
                     break;*/
                 case DataType::UNSIGNED_INT:
+                case DataType::INT8:
                     return nullptr;
                 }
                 break;
@@ -283,10 +412,17 @@ namespace FreeWill
                 case DataType::DOUBLE:
                     operatorBase = new ActivationDerivative<ActivationMode::CLIPPED_RELU, DeviceUsed, double>(deviceId);
                     break;
+                case DataType::BFLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, ActivationDerivative<ActivationMode::CLIPPED_RELU, DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                    break;
+                case DataType::FLOAT16:
+                    operatorBase = newCPUOperator<DeviceUsed, ActivationDerivative<ActivationMode::CLIPPED_RELU, DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                    break;
                 /*case UNSIGNED_INT:
                     operatorBase = new ActivationDerivative<CLIPPED_RELU, DeviceUsed, unsigned int>();
                     break;*/
                 case DataType::UNSIGNED_INT:
+                case DataType::INT8:
                     return nullptr;
                 }
                 break;
@@ -340,13 +476,28 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new Convolution<DeviceUsed, double>(strideX,strideY,zeroPaddingX,zeroPaddingY,deviceId);
 
+                break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, Convolution<DeviceType::CPU_NAIVE, BFloat16>>(strideX,strideY,zeroPaddingX,zeroPaddingY,deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, Convolution<DeviceType::CPU_NAIVE, Float16>>(strideX,strideY,zeroPaddingX,zeroPaddingY,deviceId);
                 break;
             /*case UNSIGNED_INT:
                 operatorBase = new Convolution<DeviceUsed, unsigned int>();
                 break;*/
             case DataType::UNSIGNED_INT:
                 return nullptr;
+            case DataType::INT8:
+                operatorBase = newCPUOperator<DeviceUsed, QuantizedConvolution<DeviceType::CPU_NAIVE>>(strideX,strideY,zeroPaddingX,zeroPaddingY,deviceId);
 
+                if (!setInput(operatorBase, "InputScale", tensors, deviceId) ||
+                        !setInput(operatorBase, "FeatureMapScale", tensors, deviceId))
+                {
+                    delete operatorBase;
+                    return nullptr;
+                }
+                break;
             }
 
             if (!setInput(operatorBase, "Input", tensors, deviceId) ||
@@ -399,10 +550,17 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new ConvolutionDerivative<DeviceUsed, double>(strideX,strideY,zeroPaddingX,zeroPaddingY,deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, ConvolutionDerivative<DeviceType::CPU_NAIVE, BFloat16>>(strideX,strideY,zeroPaddingX,zeroPaddingY,deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, ConvolutionDerivative<DeviceType::CPU_NAIVE, Float16>>(strideX,strideY,zeroPaddingX,zeroPaddingY,deviceId);
+                break;
             /*case UNSIGNED_INT:
                 operatorBase = new ConvolutionDerivative<DeviceUsed, unsigned int>();
                 break;*/
             case DataType::UNSIGNED_INT:
+            case DataType::INT8:
                 return nullptr;
 
             }
@@ -434,10 +592,17 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new CrossEntropyLoss<DeviceUsed, double>(deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, CrossEntropyLoss<DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, CrossEntropyLoss<DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                break;
             /*case UNSIGNED_INT:
                 operatorBase = new CrossEntropyLoss<DeviceUsed, unsigned int>();
                 break;*/
             case DataType::UNSIGNED_INT:
+            case DataType::INT8:
                 return nullptr;
             }
 
@@ -474,11 +639,27 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new DotProductWithBias<DeviceUsed, double>(hasBias, deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, DotProductWithBias<DeviceType::CPU_NAIVE, BFloat16>>(hasBias, deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, DotProductWithBias<DeviceType::CPU_NAIVE, Float16>>(hasBias, deviceId);
+                break;
             /*case UNSIGNED_INT:
                 operatorBase = new DotProductWithBias<DeviceUsed, unsigned int>();
                 break;*/
             case DataType::UNSIGNED_INT:
                 return nullptr;
+            case DataType::INT8:
+                operatorBase = newCPUOperator<DeviceUsed, QuantizedDotProductWithBias<DeviceType::CPU_NAIVE>>(hasBias, deviceId);
+
+                if (!setInput(operatorBase, "InputScale", tensors, deviceId) ||
+                        !setInput(operatorBase, "WeightScale", tensors, deviceId))
+                {
+                    delete operatorBase;
+                    return nullptr;
+                }
+                break;
             }
 
             if (!setInput(operatorBase, "Input", tensors, deviceId) ||
@@ -505,19 +686,32 @@ namespace FreeWill
                 hasBias = std::any_cast<bool>(m_parameters["HasBias"]);
             }
 
+            bool isAccumulating = false;
+            if (m_parameters.find("Accumulate") != m_parameters.end())
+            {
+                isAccumulating = std::any_cast<bool>(m_parameters["Accumulate"]);
+            }
+
             switch(m_dataType)
             {
             case DataType::FLOAT:
-                operatorBase = new DotProductWithBiasDerivative<DeviceUsed, float>(hasBias, deviceId);
+                operatorBase = new DotProductWithBiasDerivative<DeviceUsed, float>(hasBias, deviceId, isAccumulating);
                 break;
             case DataType::DOUBLE:
-                operatorBase = new DotProductWithBiasDerivative<DeviceUsed, double>(hasBias, deviceId);
+                operatorBase = new DotProductWithBiasDerivative<DeviceUsed, double>(hasBias, deviceId, isAccumulating);
+                break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, DotProductWithBiasDerivative<DeviceType::CPU_NAIVE, BFloat16>>(hasBias, deviceId, isAccumulating);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, DotProductWithBiasDerivative<DeviceType::CPU_NAIVE, Float16>>(hasBias, deviceId, isAccumulating);
                 break;
             /*case UNSIGNED_INT:
                 operatorBase = new DotProductWithBiasDerivative<DeviceUsed, unsigned int>();
 
                 break;*/
             case DataType::UNSIGNED_INT:
+            case DataType::INT8:
                 return nullptr;
             }
 
@@ -555,10 +749,17 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new ElementwiseAdd<DeviceUsed, double>(rate, deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, ElementwiseAdd<DeviceType::CPU_NAIVE, BFloat16>>(rate, deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, ElementwiseAdd<DeviceType::CPU_NAIVE, Float16>>(rate, deviceId);
+                break;
             /*case UNSIGNED_INT:
                 operatorBase = new ElementwiseAdd<DeviceUsed, unsigned int>();
                 break;*/
             case DataType::UNSIGNED_INT:
+            case DataType::INT8:
                 return nullptr;
             }
 
@@ -586,10 +787,17 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new MaxPooling<DeviceUsed, double>(deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, MaxPooling<DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, MaxPooling<DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                break;
             /*case UNSIGNED_INT:
                 operatorBase = new MaxPooling<DeviceUsed, unsigned int>();
                 break;*/
             case DataType::UNSIGNED_INT:
+            case DataType::INT8:
                 return nullptr;
             }
 
@@ -619,10 +827,17 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new MaxPoolingDerivative<DeviceUsed, double>(deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, MaxPoolingDerivative<DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, MaxPoolingDerivative<DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                break;
             /*case UNSIGNED_INT:
                 operatorBase = new MaxPoolingDerivative<DeviceUsed, unsigned int>();
                 break;*/
             case DataType::UNSIGNED_INT:
+            case DataType::INT8:
                 return nullptr;
             }
 
@@ -665,11 +880,18 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new SigmoidCrossEntropyLossDerivative<DeviceUsed, double>(deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, SigmoidCrossEntropyLossDerivative<DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, SigmoidCrossEntropyLossDerivative<DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                break;
             /*case UNSIGNED_INT:
                 operatorBase = new SigmoidCrossEntropyLossDerivative<DeviceUsed, unsigned int>();
 
                 break;*/
             case DataType::UNSIGNED_INT:
+            case DataType::INT8:
                 return nullptr;
             }
 
@@ -698,10 +920,17 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new SoftmaxLogLoss<DeviceUsed, double>(deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, SoftmaxLogLoss<DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, SoftmaxLogLoss<DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                break;
             /*case UNSIGNED_INT:
                 operatorBase = new SoftmaxLogLoss<DeviceUsed, unsigned int>();
                 break;*/
             case DataType::UNSIGNED_INT:
+            case DataType::INT8:
                 return nullptr;
             }
 
@@ -730,10 +959,17 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new SoftmaxLogLossDerivative<DeviceUsed, double>(deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, SoftmaxLogLossDerivative<DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, SoftmaxLogLossDerivative<DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                break;
             /*case UNSIGNED_INT:
                 operatorBase = new SoftmaxLogLossDerivative<DeviceUsed, unsigned int>();
                 break;*/
             case DataType::UNSIGNED_INT:
+            case DataType::INT8:
                 return nullptr;
             }
 
@@ -761,9 +997,18 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new Duplicate<DeviceUsed, double>(deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, Duplicate<DeviceType::CPU_NAIVE, BFloat16>>(deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, Duplicate<DeviceType::CPU_NAIVE, Float16>>(deviceId);
+                break;
             case DataType::UNSIGNED_INT:
                 operatorBase = new Duplicate<DeviceUsed, unsigned int>(deviceId);
                 break;
+            case DataType::INT8:
+                operatorBase = new Duplicate<DeviceUsed, int8_t>(deviceId);
+                break;
 
             }
 
@@ -778,49 +1023,33 @@ namespace FreeWill
         }
 
         template<DeviceType DeviceUsed>
-        void reshape(std::map<std::string, FreeWill::TensorDescriptor*> &tensors, unsigned int deviceCount)
+        bool reshapeForDevice(std::map<std::string, FreeWill::TensorDescriptor*> &tensors, unsigned int deviceId)
         {
-
-            if (m_inputsNeedReshape.size() > 0)
+            //called before every evaluation, the target shapes are computed once in setInput/setOutput
+            for(unsigned int i = 0;i<m_reshapeTargets.size();++i)
             {
-                for(unsigned int i = 0;i<m_inputsNeedReshape.size();++i)
-                {
-                    TensorDescriptor *tensorDescriptor = tensors[m_inputsNeedReshape[i].name()];
-                    Shape newShape = m_inputsNeedReshape[i].shape();
+                TensorBase<DeviceUsed> *tensorBase = m_reshapeTargets[i].first->template getTensorForDevice<DeviceUsed>(deviceId);
 
-                    for (unsigned int e = 0;e<deviceCount;++e)
-                    {
-                        TensorBase<DeviceUsed> *tensorBase = tensorDescriptor->getTensorForDevice<DeviceUsed>(e);
-
-                        if (! tensorBase->reshape(tensorDescriptor->m_isBatchTensor?(newShape + tensorDescriptor->m_batchSize):newShape ))
-                        {
-                            std::cerr << "Reshape failed for tensor: " << tensorBase->name() << " from: " << tensorBase->shape() << " to: " << newShape << std::endl;
-                            return;
-                        }
-                    }
+                if (! tensorBase->reshape(m_reshapeTargets[i].second))
+                {
+                    std::cerr << "Reshape failed for tensor: " << tensorBase->name() << " from: " << tensorBase->shape() << " to: " << m_reshapeTargets[i].second << std::endl;
+                    return false;
                 }
             }
 
-            if (m_outputsNeedReshape.size() > 0)
+            return true;
+        }
+
+        template<DeviceType DeviceUsed>
+        void reshape(std::map<std::string, FreeWill::TensorDescriptor*> &tensors, unsigned int deviceCount)
+        {
+            for (unsigned int e = 0;e<deviceCount;++e)
             {
-                for(unsigned int i = 0;i<m_outputsNeedReshape.size();++i)
+                if (!reshapeForDevice<DeviceUsed>(tensors, e))
                 {
-                    TensorDescriptor *tensorDescriptor = tensors[m_outputsNeedReshape[i].name()];
-                    Shape newShape = m_outputsNeedReshape[i].shape();
-
-                    for (unsigned int e = 0;e<deviceCount;++e)
-                    {
-                        TensorBase<DeviceUsed> *tensorBase = tensorDescriptor->getTensorForDevice<DeviceUsed>(e);
-
-                        if (! tensorBase->reshape(tensorDescriptor->m_isBatchTensor?(newShape + tensorDescriptor->m_batchSize):newShape ))
-                        {
-                            std::cerr << "Reshape failed for tensor: " << tensorBase->name() << " from: " << tensorBase->shape() << " to: " << newShape << std::endl;
-                            return;
-                        }
-                    }
+                    return;
                 }
             }
-
         }
 
         template<DeviceType DeviceUsed>
@@ -841,9 +1070,18 @@ namespace FreeWill
             case DataType::DOUBLE:
                 operatorBase = new Reshape<DeviceUsed, double>(Shape(), deviceId);
                 break;
+            case DataType::BFLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, Reshape<DeviceType::CPU_NAIVE, BFloat16>>(Shape(), deviceId);
+                break;
+            case DataType::FLOAT16:
+                operatorBase = newCPUOperator<DeviceUsed, Reshape<DeviceType::CPU_NAIVE, Float16>>(Shape(), deviceId);
+                break;
             case DataType::UNSIGNED_INT:
                 operatorBase = new Reshape<DeviceUsed, unsigned int>(Shape(), deviceId);
                 break;
+            case DataType::INT8:
+                operatorBase = new Reshape<DeviceUsed, int8_t>(Shape(), deviceId);
+                break;
             }
 
             if (!setInput(operatorBase, "Tensor", tensors, deviceId))
@@ -855,41 +1093,33 @@ namespace FreeWill
         }
 
         template<DeviceType DeviceUsed>
-        void evaluate(std::vector<WorkerMessage*> &messageQueue, std::map<std::string, FreeWill::TensorDescriptor*> &tensors)
+        void evaluate(std::map<std::string, FreeWill::TensorDescriptor*> &tensors)
         {
-            int deviceId = 0;
-            unsigned int deviceCount = m_operators[DeviceUsed].size();
-
-            std::vector<WorkerMessage*> messages(deviceCount, nullptr);
+            std::vector<WorkerMessage*> &messages = m_messages[DeviceUsed];
+            unsigned int deviceCount = messages.size();
 
             reshape<DeviceUsed>(tensors, deviceCount);
 
-            auto iter = m_operators[DeviceUsed].begin();
-            //auto startTime = std::chrono::steady_clock::now();
+            if (runsInline<DeviceUsed>())
+            {
+                for(unsigned int deviceId = 0;deviceId<deviceCount;++deviceId)
+                {
+                    std::get<Operator<DeviceUsed>*>(m_operators[DeviceUsed][deviceId])->evaluate();
+                }
 
-            for(;iter != m_operators[DeviceUsed].end(); ++iter)
+                return;
+            }
+
+            for(unsigned int deviceId = 0;deviceId<deviceCount;++deviceId)
             {
-                Operator<DeviceUsed> *operatorBase = std::get<Operator<DeviceUsed>*>(*iter);
-                messages[deviceId] = new WorkerMessage(WorkerMessage::Type::FORWARD, operatorBase);
-                messages[deviceId]->debug_num = deviceId;
+                messages[deviceId]->reset();
                 Context<DeviceUsed>::getSingleton().pushWork(deviceId, messages[deviceId]);
-                deviceId++;
-                //messageQueue.push_back(message);
             }
 
-            //auto middle = std::chrono::steady_clock::now();
-
-            for(int i =0;i<deviceCount;++i)
+            for(unsigned int i =0;i<deviceCount;++i)
             {
                 messages[i]->join();
-                delete messages[i];
             }
-
-            //auto endTime = std::chrono::steady_clock::now();
-            //auto diff = middle - startTime;
-
-            //std::cout << "time for wait: " << std::chrono::duration <double, std::milli> (diff).count() << " ms used for 1 epoch" << std::endl;
-
         }
 
         template<DeviceType DeviceUsed>
@@ -898,9 +1128,9 @@ namespace FreeWill
             auto iter = m_operators[DeviceUsed].begin();
 
             int deviceId = 0;
-            unsigned int deviceCount = m_operators[DeviceUsed].size();
-
-            std::vector<WorkerMessage*> messages(deviceCount, nullptr);
+            std::vector<WorkerMessage*> &messages = m_messages[DeviceUsed];
+            unsigned int deviceCount = messages.size();
+            bool runInline = runsInline<DeviceUsed>();
 
             reshape<DeviceUsed>(tensors, deviceCount);
 
@@ -937,23 +1167,45 @@ namespace FreeWill
                             dynamic_cast<ElementwiseAdd<DeviceUsed, double>*>(operatorBase)->setRate(rate);
                             break;
                         case DataType::UNSIGNED_INT:
+                        case DataType::INT8:
+                            break;
+                        case DataType::BFLOAT16:
+                            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+                            {
+                                dynamic_cast<ElementwiseAdd<DeviceUsed, BFloat16>*>(operatorBase)->setRate(rate);
+                            }
+                            break;
+                        case DataType::FLOAT16:
+                            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+                            {
+                                dynamic_cast<ElementwiseAdd<DeviceUsed, Float16>*>(operatorBase)->setRate(rate);
+                            }
                             break;
                         }
                     }
                     break;
                 }
 
-                //operatorBase->evaluate();
+                if (runInline)
+                {
+                    operatorBase->evaluate();
+                    deviceId++;
+                    continue;
+                }
 
-                messages[deviceId] /*WorkerMessage *message*/ = new WorkerMessage(WorkerMessage::Type::FORWARD, operatorBase);
-                Context<DeviceUsed>::getSingleton().pushWork(deviceId, messages[deviceId] /* message*/);
+                messages[deviceId]->reset();
+                Context<DeviceUsed>::getSingleton().pushWork(deviceId, messages[deviceId]);
                 deviceId++;
             }
 
-            for(int i =0;i<deviceCount;++i)
+            if (runInline)
+            {
+                return;
+            }
+
+            for(unsigned int i =0;i<deviceCount;++i)
             {
                 messages[i]->join();
-                delete messages[i];
             }
 
         }
@@ -1032,7 +1284,11 @@ namespace FreeWill
                 }
 
                 m_operators[DeviceUsed].push_back(operatorBase);
+                m_messages[DeviceUsed].push_back(new WorkerMessage(WorkerMessage::Type::FORWARD, operatorBase));
             }
+
+            estimateWork(tensors);
+
             return true;
         }
     };
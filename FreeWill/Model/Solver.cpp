@@ -13,13 +13,72 @@ bool FreeWill::Solver::init(FreeWill::Model *model)
 
     clearUpdateOperators();
 
-    m_dataType = model->m_tensors[model->m_updatePairs.begin()->second.name()]->m_dataType;
+    if (m_deviceUsed == DeviceType::CPU_NAIVE && m_executionMode == ExecutionMode::COMMAND_LIST)
+    {
+        if (!recordCommandLists(model))
+        {
+            return false;
+        }
+    }
+    else if (m_deviceUsed == DeviceType::CPU_NAIVE)
+    {
+        model->clearExecutionGraphs();
+
+        if (!executionGraph(model, model->m_forwardGraph, model->m_forwardPath, false)
+                || !executionGraph(model, model->m_backwardGraph, model->m_backwardPath, true))
+        {
+            std::cerr << "can't build execution graphs" << std::endl;
+            return false;
+        }
+    }
+
+    //inference only models have nothing to update
+    if (!model->m_updatePairs.empty())
+    {
+        m_dataType = model->m_tensors[model->m_updatePairs.begin()->second.name()]->m_dataType;
+    }
 
+    switch (m_dataType)
+    {
+    case DataType::DOUBLE:
+        generateUpdateOperators<double>(model);
+        break;
+    case DataType::BFLOAT16:
+        generateUpdateOperators<BFloat16>(model);
+        break;
+    case DataType::FLOAT16:
+        generateUpdateOperators<Float16>(model);
+        break;
+    default:
+        generateUpdateOperators<float>(model);
+        break;
+    }
+
+    /*for(auto iter = m_updateOperators.begin(); iter != m_updateOperators.end(); ++iter)
+    {
+        switch(m_deviceUsed)
+        {
+        case FreeWill::DeviceType::CPU_NAIVE:
+        (*iter)->init<FreeWill::DeviceType::CPU_NAIVE>(model->m_tensors);
+            break;
+        case FreeWill::DeviceType::GPU_CUDA:
+        (*iter)->init<FreeWill::DeviceType::GPU_CUDA>(model->m_tensors);
+            break;
+        }
+    }*/
+
+    return true;
+}
+
+//the merge, update and broadcast operators have to match the parameters' type
+template<typename DataType>
+void FreeWill::Solver::generateUpdateOperators(FreeWill::Model *model)
+{
     for(auto iter = model->m_updatePairs.begin(); iter != model->m_updatePairs.end(); ++iter)
     {
         FreeWill::TensorDescriptorHandle operandB = iter->second;
 
-        model->generateGradientMergeOperators(m_mergeGradientOperators, operandB);
+        model->generateGradientMergeOperators<DeviceType::CPU_NAIVE, DataType>(m_mergeGradientOperators, operandB);
 
     }
 
@@ -38,7 +97,7 @@ bool FreeWill::Solver::init(FreeWill::Model *model)
                             {{"OperandA", operandA}, {"OperandB", operandB}},
                             {{"Result", operandA}},{}, dataType);*/
 
-        model->generateUpdateFirstDeviceTensorOperators(m_updateFirstDeviceTensorOperators, operandA, operandB);
+        model->generateUpdateFirstDeviceTensorOperators<DeviceType::CPU_NAIVE, DataType>(m_updateFirstDeviceTensorOperators, operandA, operandB);
 
 
     }
@@ -47,23 +106,8 @@ bool FreeWill::Solver::init(FreeWill::Model *model)
     {
         FreeWill::TensorDescriptorHandle operandA = iter->first;
 
-        model->generateBroadcastFirstDeviceTensorOperators(m_broadcastTensorToSiblingOperators, operandA);
+        model->generateBroadcastFirstDeviceTensorOperators<DeviceType::CPU_NAIVE, DataType>(m_broadcastTensorToSiblingOperators, operandA);
     }
-
-    /*for(auto iter = m_updateOperators.begin(); iter != m_updateOperators.end(); ++iter)
-    {
-        switch(m_deviceUsed)
-        {
-        case FreeWill::DeviceType::CPU_NAIVE:
-        (*iter)->init<FreeWill::DeviceType::CPU_NAIVE>(model->m_tensors);
-            break;
-        case FreeWill::DeviceType::GPU_CUDA:
-        (*iter)->init<FreeWill::DeviceType::GPU_CUDA>(model->m_tensors);
-            break;
-        }
-    }*/
-
-    return true;
 }
 /*
 FreeWill::OperatorDescriptorHandle FreeWill::Solver::addUpdateOperator(const std::string &name,
@@ -138,65 +182,172 @@ void FreeWill::Solver::clearUpdateOperators()
 
 void FreeWill::Solver::forward(FreeWill::Model *model)
 {
-
-    std::vector<WorkerMessage*> messageQueue;
-
     auto iter = model->m_forwardPath.begin();
 
     switch(m_deviceUsed)
     {
     case FreeWill::DeviceType::CPU_NAIVE:
-        messageQueue.reserve(model->m_forwardPath.size() * Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().deviceCount());
-        for(; iter != model->m_forwardPath.end();++iter)
+        if (m_executionMode == ExecutionMode::COMMAND_LIST)
         {
-            model->m_operators[(*iter)]->evaluate<FreeWill::DeviceType::CPU_NAIVE>(messageQueue, model->m_tensors);
-            //break;
+            CommandList::replay(commandLists(model, model->m_forwardCommandLists, model->m_forwardPath));
+        }
+        else
+        {
+            ExecutionGraph *forwardGraph = executionGraph(model, model->m_forwardGraph, model->m_forwardPath, false);
+
+            if (forwardGraph)
+            {
+                forwardGraph->run();
+            }
         }
         break;
     case FreeWill::DeviceType::GPU_CUDA:
         for(; iter != model->m_forwardPath.end();++iter)
         {
-            model->m_operators[(*iter)]->evaluate<FreeWill::DeviceType::GPU_CUDA>(messageQueue, model->m_tensors);
+            model->m_operators[(*iter)]->evaluate<FreeWill::DeviceType::GPU_CUDA>(model->m_tensors);
         }
         break;
     }
-
-    for(int i=0;i<messageQueue.size();++i)
-    {
-        messageQueue[i]->join();
-        delete messageQueue[i];
-    }
 }
 
 void FreeWill::Solver::backward(FreeWill::Model *model)
 {
-    std::vector<WorkerMessage*> messageQueue;
-
     auto iter = model->m_backwardPath.begin();
 
     switch(m_deviceUsed)
     {
     case FreeWill::DeviceType::CPU_NAIVE:
-        messageQueue.reserve(model->m_forwardPath.size() * Context<FreeWill::DeviceType::CPU_NAIVE>::getSingleton().deviceCount());
-
-        for(; iter != model->m_backwardPath.end();++iter)
+        if (m_executionMode == ExecutionMode::COMMAND_LIST)
         {
-            model->m_operators[(*iter)]->evaluate<FreeWill::DeviceType::CPU_NAIVE>(messageQueue, model->m_tensors);
+            CommandList::replay(commandLists(model, model->m_backwardCommandLists, model->m_backwardPath));
+        }
+        else
+        {
+            ExecutionGraph *backwardGraph = executionGraph(model, model->m_backwardGraph, model->m_backwardPath, true);
+
+            if (backwardGraph)
+            {
+                backwardGraph->run();
+            }
         }
         break;
     case FreeWill::DeviceType::GPU_CUDA:
         for(; iter != model->m_backwardPath.end();++iter)
         {
-            model->m_operators[(*iter)]->evaluate<FreeWill::DeviceType::GPU_CUDA>(messageQueue, model->m_tensors);
+            model->m_operators[(*iter)]->evaluate<FreeWill::DeviceType::GPU_CUDA>(model->m_tensors);
         }
         break;
     }
+}
+
+FreeWill::SolverStep FreeWill::Solver::forwardAsync(FreeWill::Model *model)
+{
+    if (m_deviceUsed == FreeWill::DeviceType::CPU_NAIVE)
+    {
+        if (m_executionMode == ExecutionMode::COMMAND_LIST)
+        {
+            const std::vector<CommandList*> &forwardCommandLists = commandLists(model, model->m_forwardCommandLists, model->m_forwardPath);
+            CommandList::start(forwardCommandLists);
+            return SolverStep(nullptr, &forwardCommandLists);
+        }
+
+        ExecutionGraph *forwardGraph = executionGraph(model, model->m_forwardGraph, model->m_forwardPath, false);
+
+        if (!forwardGraph)
+        {
+            return SolverStep();
+        }
+
+        forwardGraph->start();
+        return SolverStep(forwardGraph, nullptr);
+    }
+
+    //the GPU path has no async variant yet
+    forward(model);
+    return SolverStep();
+}
+
+FreeWill::SolverStep FreeWill::Solver::backwardAsync(FreeWill::Model *model)
+{
+    if (m_deviceUsed == FreeWill::DeviceType::CPU_NAIVE)
+    {
+        if (m_executionMode == ExecutionMode::COMMAND_LIST)
+        {
+            const std::vector<CommandList*> &backwardCommandLists = commandLists(model, model->m_backwardCommandLists, model->m_backwardPath);
+            CommandList::start(backwardCommandLists);
+            return SolverStep(nullptr, &backwardCommandLists);
+        }
+
+        ExecutionGraph *backwardGraph = executionGraph(model, model->m_backwardGraph, model->m_backwardPath, true);
+
+        if (!backwardGraph)
+        {
+            return SolverStep();
+        }
+
+        backwardGraph->start();
+        return SolverStep(backwardGraph, nullptr);
+    }
+
+    backward(model);
+    return SolverStep();
+}
 
-    for(int i=0;i<messageQueue.size();++i)
+const std::vector<FreeWill::CommandList*> &FreeWill::Solver::commandLists(FreeWill::Model *model, std::vector<CommandList*> &commandLists, const std::vector<OperatorDescriptorHandle> &path)
+{
+    //paths changed since init, a failed recording leaves the lists empty
+    //and nothing gets replayed
+    if (commandLists.empty() && !path.empty())
     {
-        messageQueue[i]->join();
-        delete messageQueue[i];
+        recordCommandLists(model);
     }
+
+    return commandLists;
+}
+
+FreeWill::ExecutionGraph *FreeWill::Solver::executionGraph(FreeWill::Model *model, ExecutionGraph *&graph, const std::vector<OperatorDescriptorHandle> &path, bool isBackward)
+{
+    if (!graph)
+    {
+        graph = new ExecutionGraph();
+
+        bool isBuilt = false;
+
+        if (m_executionMode == ExecutionMode::PIPELINE)
+        {
+            isBuilt = graph->build(path, model->m_operators, model->m_tensors, pipelineStageWorkers(isBackward));
+        }
+        else
+        {
+            isBuilt = graph->build(path, model->m_operators, model->m_tensors);
+        }
+
+        if (!isBuilt)
+        {
+            std::cerr << "can't build execution graph" << std::endl;
+            delete graph;
+            graph = nullptr;
+        }
+    }
+
+    return graph;
+}
+
+std::vector<unsigned int> FreeWill::Solver::pipelineStageWorkers(bool isBackward) const
+{
+    unsigned int workerCount = Context<DeviceType::CPU_NAIVE>::getSingleton().deviceCount();
+    unsigned int stageCount = m_pipelineStageCount ? m_pipelineStageCount : workerCount;
+
+    std::vector<unsigned int> stageWorkers(stageCount);
+
+    //the backward path walks the layers in reverse, so do its stages, which
+    //keeps a layer's gradients on the worker that holds its weights in cache
+    for (unsigned int i = 0; i < stageCount; ++i)
+    {
+        stageWorkers[i] = (isBackward ? stageCount - 1 - i : i) % workerCount;
+    }
+
+    return stageWorkers;
 }
 
 void FreeWill::Solver::update(double learningRate)
@@ -267,6 +418,16 @@ void FreeWill::Solver::update(double learningRate)
                 ElementwiseAdd<DeviceType::CPU_NAIVE, double> *elementwiseAdd = dynamic_cast<ElementwiseAdd<DeviceType::CPU_NAIVE, double>*>(operatorBase);
                 elementwiseAdd->setRate(learningRate);
             }
+            else if(m_dataType == DataType::BFLOAT16)
+            {
+                ElementwiseAdd<DeviceType::CPU_NAIVE, BFloat16> *elementwiseAdd = dynamic_cast<ElementwiseAdd<DeviceType::CPU_NAIVE, BFloat16>*>(operatorBase);
+                elementwiseAdd->setRate(learningRate);
+            }
+            else if(m_dataType == DataType::FLOAT16)
+            {
+                ElementwiseAdd<DeviceType::CPU_NAIVE, Float16> *elementwiseAdd = dynamic_cast<ElementwiseAdd<DeviceType::CPU_NAIVE, Float16>*>(operatorBase);
+                elementwiseAdd->setRate(learningRate);
+            }
             operatorBase->evaluate();
         }
             break;
@@ -316,11 +477,99 @@ void FreeWill::Solver::update(double learningRate)
 
 }
 
+bool FreeWill::Solver::recordCommandLists(FreeWill::Model *model)
+{
+    model->clearExecutionGraphs();
+
+    if (!CommandList::record(model->m_forwardPath, model->m_operators, model->m_tensors, model->m_forwardCommandLists)
+            || !CommandList::record(model->m_backwardPath, model->m_operators, model->m_tensors, model->m_backwardCommandLists))
+    {
+        std::cerr << "can't record command lists" << std::endl;
+        //never replay a partial recording
+        model->clearExecutionGraphs();
+        return false;
+    }
+
+    return true;
+}
+
 FreeWill::Solver::Solver()
-    :m_previousLearningRate(0.0)
+    :m_previousLearningRate(0.0),
+      m_dataType(DataType::FLOAT),
+      m_executionMode(ExecutionMode::COMMAND_LIST),
+      m_pipelineStageCount(0),
+      m_sharedParameters(false)
 {}
 
 FreeWill::Solver::~Solver()
 {
     clearUpdateOperators();
 }
+
+FreeWill::SolverStep::SolverStep(ExecutionGraph *graph, const std::vector<CommandList*> *commandLists)
+    :m_graph(graph),
+      m_commandLists(commandLists)
+{}
+
+FreeWill::SolverStep::SolverStep()
+    :m_graph(nullptr),
+      m_commandLists(nullptr)
+{}
+
+FreeWill::SolverStep::SolverStep(SolverStep &&in)
+    :m_graph(in.m_graph),
+      m_commandLists(in.m_commandLists)
+{
+    in.m_graph = nullptr;
+    in.m_commandLists = nullptr;
+}
+
+FreeWill::SolverStep &FreeWill::SolverStep::operator=(SolverStep &&in)
+{
+    if (this != &in)
+    {
+        wait();
+
+        m_graph = in.m_graph;
+        m_commandLists = in.m_commandLists;
+        in.m_graph = nullptr;
+        in.m_commandLists = nullptr;
+    }
+
+    return *this;
+}
+
+FreeWill::SolverStep::~SolverStep()
+{
+    wait();
+}
+
+bool FreeWill::SolverStep::isReady() const
+{
+    if (m_graph)
+    {
+        return m_graph->finished();
+    }
+
+    if (m_commandLists)
+    {
+        return CommandList::finished(*m_commandLists);
+    }
+
+    return true;
+}
+
+void FreeWill::SolverStep::wait()
+{
+    if (m_graph)
+    {
+        m_graph->wait();
+        m_graph = nullptr;
+    }
+
+    if (m_commandLists)
+    {
+        CommandList::wait(*m_commandLists);
+        m_commandLists = nullptr;
+    }
+}
@@ -9,6 +9,50 @@
 namespace FreeWill
 {
     class Model;
+
+    // How the CPU solver dispatches the forward and backward paths. COMMAND_LIST
+    // replays one recorded list per device, GRAPH schedules every replica
+    // separately as soon as its inputs are ready, which lets independent
+    // branches of the same device run on different workers. PIPELINE cuts
+    // the paths into stages pinned to workers, the device replicas become
+    // micro-batches flowing through them and all devices share one copy of
+    // every parameter in the weight update pairs.
+    enum class ExecutionMode
+    {
+        COMMAND_LIST,
+        GRAPH,
+        PIPELINE
+    };
+
+    class ExecutionGraph;
+    class CommandList;
+
+    // A forward or backward pass that is still running on the workers. Nothing
+    // may touch the model's tensors, or start another pass, until wait() has
+    // returned. Dropping the handle waits as well.
+    class SolverStep
+    {
+        friend class Solver;
+
+    private:
+        ExecutionGraph *m_graph;
+        const std::vector<CommandList*> *m_commandLists;
+
+        SolverStep(ExecutionGraph *graph, const std::vector<CommandList*> *commandLists);
+
+    public:
+        SolverStep();
+        SolverStep(SolverStep &&in);
+        SolverStep &operator=(SolverStep &&in);
+        SolverStep(const SolverStep &) = delete;
+        SolverStep &operator=(const SolverStep &) = delete;
+        ~SolverStep();
+
+        bool isReady() const;
+
+        void wait();
+    };
+
     class Solver
     {
         //std::vector<OperatorDescriptor*> m_updateOperators;
@@ -21,12 +65,24 @@ namespace FreeWill
         DeviceType m_deviceUsed;
         unsigned int m_batchSize;
         DataType m_dataType;
+        ExecutionMode m_executionMode;
+        //0 gives every worker a stage
+        unsigned int m_pipelineStageCount;
+        //CPU devices read one copy of every parameter instead of a replica
+        //each, the update writes it in place and nothing gets broadcast
+        bool m_sharedParameters;
 
         bool init(Model *model);
 
         void forward(Model *model);
         void backward(Model *model);
 
+        //return as soon as the pass is handed to the workers, e.g. to load the
+        //next batch meanwhile. Inline root operators still run on the calling
+        //thread, after the workers got theirs. The GPU path still runs synchronously.
+        SolverStep forwardAsync(Model *model);
+        SolverStep backwardAsync(Model *model);
+
         void update(double learningRate = -0.01);
 
         Solver();
@@ -41,6 +97,17 @@ namespace FreeWill
                                  const std::map<std::string, std::any> &properties, DataType dataType);
 
         void clearUpdateOperators();
+
+        template<typename DataType>
+        void generateUpdateOperators(Model *model);
+
+        bool recordCommandLists(Model *model);
+
+        const std::vector<CommandList*> &commandLists(Model *model, std::vector<CommandList*> &commandLists, const std::vector<OperatorDescriptorHandle> &path);
+
+        ExecutionGraph *executionGraph(Model *model, ExecutionGraph *&graph, const std::vector<OperatorDescriptorHandle> &path, bool isBackward);
+
+        std::vector<unsigned int> pipelineStageWorkers(bool isBackward) const;
     };
 }
 
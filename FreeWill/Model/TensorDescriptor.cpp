@@ -8,6 +8,12 @@ FreeWill::TensorDescriptor::TensorDescriptor(const TensorDescriptor &in)
       m_batchSize(in.m_batchSize),
       m_isRandomlyInitialized(in.m_isRandomlyInitialized),
       m_dataType(in.m_dataType),
+      m_isShared(in.m_isShared),
+      m_aliases(in.m_aliases),
+      m_isBatchSliced(in.m_isBatchSliced),
+      m_slicedBatch(in.m_slicedBatch),
+      m_fileStorage(in.m_fileStorage),
+      m_replicaFileStorage(in.m_replicaFileStorage),
       m_tensors(in.m_tensors)
 {
 }
@@ -20,6 +26,12 @@ void FreeWill::TensorDescriptor::operator =(const TensorDescriptor &in)
     m_batchSize = in.m_batchSize;
     m_isRandomlyInitialized = in.m_isRandomlyInitialized;
     m_dataType = in.m_dataType;
+    m_isShared = in.m_isShared;
+    m_aliases = in.m_aliases;
+    m_isBatchSliced = in.m_isBatchSliced;
+    m_slicedBatch = in.m_slicedBatch;
+    m_fileStorage = in.m_fileStorage;
+    m_replicaFileStorage = in.m_replicaFileStorage;
     m_tensors = in.m_tensors;
 }
 
@@ -30,11 +42,40 @@ FreeWill::TensorDescriptor::TensorDescriptor(const std::string &name, const Shap
       m_batchSize(0),
       m_isRandomlyInitialized(isRandomlyInitialized),
       m_dataType(dataType),
+      m_isShared(false),
+      m_aliases(),
+      m_isBatchSliced(false),
+      m_slicedBatch(nullptr),
+      m_fileStorage(nullptr),
+      m_replicaFileStorage(),
       m_tensors()
 {
 
 }
 
+unsigned int FreeWill::TensorDescriptor::sizeInByte(unsigned int batchSize) const
+{
+    unsigned int elementCount = (m_isBatchTensor ? (m_shape + batchSize) : m_shape).size();
+
+    switch (m_dataType)
+    {
+    case DataType::FLOAT:
+        return elementCount * sizeof(float);
+    case DataType::DOUBLE:
+        return elementCount * sizeof(double);
+    case DataType::UNSIGNED_INT:
+        return elementCount * sizeof(unsigned int);
+    case DataType::BFLOAT16:
+        return elementCount * sizeof(BFloat16);
+    case DataType::FLOAT16:
+        return elementCount * sizeof(Float16);
+    case DataType::INT8:
+        return elementCount * sizeof(int8_t);
+    default:
+        return 0;
+    }
+}
+
 FreeWill::TensorDescriptor::~TensorDescriptor()
 {
     std::map<DeviceType, std::vector<std::variant<TensorBase<DeviceType::GPU_CUDA>* ,TensorBase<DeviceType::CPU_NAIVE>* >>>::iterator iter = m_tensors.begin();
@@ -44,6 +85,12 @@ FreeWill::TensorDescriptor::~TensorDescriptor()
 
         std::vector<std::variant<TensorBase<DeviceType::GPU_CUDA>* ,TensorBase<DeviceType::CPU_NAIVE>* >> &tensorList = iter->second;
 
+        //a shared tensor is listed once per device but owned only once
+        if (m_isShared && tensorList.size() > 1)
+        {
+            tensorList.resize(1);
+        }
+
         switch(deviceType)
         {
         case DeviceType::CPU_NAIVE:
@@ -69,6 +116,45 @@ FreeWill::TensorDescriptor::~TensorDescriptor()
         tensorList.clear();
 
     }
+
+    delete m_slicedBatch;
+    m_slicedBatch = nullptr;
+
+    //the mappings are gone with the tensors
+    delete m_fileStorage;
+    m_fileStorage = nullptr;
+
+    for (unsigned int i = 0; i < m_replicaFileStorage.size(); ++i)
+    {
+        delete m_replicaFileStorage[i];
+    }
+
+    m_replicaFileStorage.clear();
+}
+
+FreeWill::Allocator *FreeWill::TensorDescriptor::fileStorage(int deviceId, unsigned int batchSize)
+{
+    MappedFileAllocator *mappedFile = dynamic_cast<MappedFileAllocator*>(m_fileStorage);
+
+    if (deviceId == 0 || m_isShared || !mappedFile || mappedFile->mapping() != MappedFileAllocator::Mapping::SHARED)
+    {
+        return m_fileStorage;
+    }
+
+    if (m_replicaFileStorage.size() < (size_t) deviceId)
+    {
+        m_replicaFileStorage.resize(deviceId, nullptr);
+    }
+
+    Allocator *&replica = m_replicaFileStorage[deviceId - 1];
+
+    if (!replica)
+    {
+        replica = new MappedFileAllocator(mappedFile->path(), mappedFile->offset() + deviceId * Allocator::alignedSize(sizeInByte(batchSize)),
+                                          MappedFileAllocator::Mapping::SHARED);
+    }
+
+    return replica;
 }
 
 
@@ -102,6 +188,43 @@ FreeWill::TensorDescriptorHandle &FreeWill::TensorDescriptorHandle::enableBatch(
     return *this;
 }
 
+FreeWill::TensorDescriptorHandle &FreeWill::TensorDescriptorHandle::enableBatchSlicing()
+{
+    TensorDescriptor* tensorDescriptor = m_model->m_tensors[m_name];
+
+    if (!tensorDescriptor->m_isBatchTensor)
+    {
+        std::cerr << "Only a batch tensor can be sliced!"<<std::endl;
+    }
+    else if (!tensorDescriptor->isInitialized())
+    {
+        tensorDescriptor->m_isBatchSliced = true;
+    }
+    else
+    {
+        std::cerr << "Can't enable batch slicing after tensor is initialized!"<<std::endl;
+    }
+
+    return *this;
+}
+
+FreeWill::TensorDescriptorHandle &FreeWill::TensorDescriptorHandle::mapFile(const std::string &path, size_t offset, MappedFileAllocator::Mapping mapping)
+{
+    TensorDescriptor* tensorDescriptor = m_model->m_tensors[m_name];
+
+    if (!tensorDescriptor->isInitialized())
+    {
+        delete tensorDescriptor->m_fileStorage;
+        tensorDescriptor->m_fileStorage = new MappedFileAllocator(path, offset, mapping);
+    }
+    else
+    {
+        std::cerr << "Can't map a file after tensor is initialized!"<<std::endl;
+    }
+
+    return *this;
+}
+
 FreeWill::TensorDescriptorHandle &FreeWill::TensorDescriptorHandle::randomize()
 {
     TensorDescriptor* tensorDescriptor = m_model->m_tensors[m_name];
@@ -15,7 +15,12 @@ namespace FreeWill
     {
         FLOAT,
         DOUBLE,
-        UNSIGNED_INT
+        UNSIGNED_INT,
+        //16 bit storage, CPU operators compute in float
+        BFLOAT16,
+        FLOAT16,
+        //quantized weights, see Operator/Quantization.h
+        INT8
     };
 
     class Model;
@@ -45,6 +50,11 @@ namespace FreeWill
             m_isReshaped = in.m_isReshaped;
         }
         TensorDescriptorHandle &enableBatch();
+        TensorDescriptorHandle &enableBatchSlicing();
+        //with a SHARED mapping every device's replica gets its own aligned
+        //range of the file, device i's starts i tensors past offset
+        TensorDescriptorHandle &mapFile(const std::string &path, size_t offset = 0,
+                                        MappedFileAllocator::Mapping mapping = MappedFileAllocator::Mapping::PRIVATE);
         TensorDescriptorHandle &randomize();
 
         const std::string &name() const
@@ -74,6 +84,18 @@ namespace FreeWill
         int m_batchSize;
         bool m_isRandomlyInitialized;
         DataType m_dataType;
+        //every device gets the same tensor instead of a replica of its own
+        bool m_isShared;
+        //planned tensors that reuse some of this tensor's memory at other times
+        std::vector<std::string> m_aliases;
+        //the devices' batches are consecutive slices of one host tensor
+        bool m_isBatchSliced;
+        TensorBase<DeviceType::CPU_NAIVE> *m_slicedBatch;
+        //maps the tensor from a file instead of allocating it, the file
+        //provides the initial values
+        Allocator *m_fileStorage;
+        //the mappings of devices 1 and up when they need a range of their own
+        std::vector<Allocator*> m_replicaFileStorage;
 
         std::map<DeviceType, std::vector<std::variant<TensorBase<DeviceType::GPU_CUDA>*, TensorBase<DeviceType::CPU_NAIVE>*>>> m_tensors;
 
@@ -88,65 +110,174 @@ namespace FreeWill
             return !((m_tensors[FreeWill::DeviceType::CPU_NAIVE].size() == 0) && (m_tensors[FreeWill::DeviceType::GPU_CUDA].size() == 0));
         }
 
+        //host memory of one device's tensor
+        unsigned int sizeInByte(unsigned int batchSize) const;
+
+        //a SHARED mapping writes through, so every device's replica maps the
+        //aligned tensor after the previous device's instead of the same bytes.
+        //PRIVATE mappings and shared tensors all map the given range
+        Allocator *fileStorage(int deviceId, unsigned int batchSize);
+
+        //nullptr takes the default allocator, deviceAllocators override it per device
         template<DeviceType DeviceUsed = DeviceType::CPU_NAIVE>
-        void allocateTensor(unsigned int batchSize)
+        void allocateTensor(unsigned int batchSize, Allocator *allocator = nullptr, const std::vector<Allocator*> &deviceAllocators = std::vector<Allocator*>())
         {
             int deviceCount = Context<DeviceUsed>::getSingleton().deviceCount();
 
+            if constexpr (DeviceUsed == FreeWill::DeviceType::CPU_NAIVE)
+            {
+                if (m_isBatchSliced && m_isBatchTensor && !m_isShared)
+                {
+                    switch (m_dataType)
+                    {
+                    case DataType::FLOAT:
+                        allocateSlicedBatch<float>(batchSize, deviceCount, m_fileStorage ? m_fileStorage : allocator);
+                        break;
+                    case DataType::DOUBLE:
+                        allocateSlicedBatch<double>(batchSize, deviceCount, m_fileStorage ? m_fileStorage : allocator);
+                        break;
+                    case DataType::UNSIGNED_INT:
+                        allocateSlicedBatch<unsigned int>(batchSize, deviceCount, m_fileStorage ? m_fileStorage : allocator);
+                        break;
+                    case DataType::BFLOAT16:
+                        allocateSlicedBatch<BFloat16>(batchSize, deviceCount, m_fileStorage ? m_fileStorage : allocator);
+                        break;
+                    case DataType::FLOAT16:
+                        allocateSlicedBatch<Float16>(batchSize, deviceCount, m_fileStorage ? m_fileStorage : allocator);
+                        break;
+                    case DataType::INT8:
+                        allocateSlicedBatch<int8_t>(batchSize, deviceCount, m_fileStorage ? m_fileStorage : allocator);
+                        break;
+                    default:
+                        break;
+                    }
+
+                    return;
+                }
+            }
+
             for (int i =0;i<deviceCount;++i)
             {
+                if (m_isShared && i > 0)
+                {
+                    m_tensors[DeviceUsed].push_back(m_tensors[DeviceUsed][0]);
+                    continue;
+                }
+
                 if constexpr (DeviceUsed == FreeWill::DeviceType::GPU_CUDA)
                 {
                     RUN_CUDA(cudaSetDevice(i));
                 }
 
                 FreeWill::TensorBase<DeviceUsed> *tensor = nullptr;
-                switch (m_dataType)
+                Allocator *tensorAllocator = m_fileStorage ? fileStorage(i, batchSize)
+                                                           : ((i < (int) deviceAllocators.size()) ? deviceAllocators[i] : allocator);
+
+                //with pinned workers the owning thread allocates and clears the tensor,
+                //so its pages are first touched on that worker's NUMA node
+                auto createTensor = [&]()
                 {
-                case DataType::FLOAT:
-                    tensor = new FreeWill::Tensor<DeviceUsed, float>(m_isBatchTensor?(m_shape + (m_batchSize = batchSize)):m_shape, m_name);
-                    tensor->template toType<float>()->init();
-                    if (m_isRandomlyInitialized)
+                    switch (m_dataType)
                     {
-                        if (i == 0)
+                    case DataType::FLOAT:
+                        tensor = new FreeWill::Tensor<DeviceUsed, float>(m_isBatchTensor?(m_shape + (m_batchSize = batchSize)):m_shape, m_name);
+                        tensor->template toType<float>()->init(tensorAllocator);
+                        if (m_isRandomlyInitialized && !m_fileStorage)
                         {
-                            tensor->template toType<float>()->randomize();
+                            if (i == 0)
+                            {
+                                tensor->template toType<float>()->randomize();
+                            }
+                            else
+                            {
+                                TensorBase<DeviceUsed> *firstTensor = std::get<TensorBase<DeviceUsed>*>(m_tensors[DeviceUsed][0]);
+                                std::copy((unsigned char*)firstTensor->cpuDataHandle(),
+                                          ((unsigned char*)firstTensor->cpuDataHandle())+firstTensor->sizeInByte(), (unsigned char*) tensor->cpuDataHandle());
+                            }
                         }
-                        else
+                        break;
+                    case DataType::DOUBLE:
+                        tensor = new FreeWill::Tensor<DeviceUsed, double>(m_isBatchTensor?(m_shape + (m_batchSize = batchSize)):m_shape, m_name);
+                        tensor->template toType<double>()->init(tensorAllocator);
+                        if (m_isRandomlyInitialized && !m_fileStorage)
                         {
-                            TensorBase<DeviceUsed> *firstTensor = std::get<TensorBase<DeviceUsed>*>(m_tensors[DeviceUsed][0]);
-                            std::copy((unsigned char*)firstTensor->cpuDataHandle(),
-                                      ((unsigned char*)firstTensor->cpuDataHandle())+firstTensor->sizeInByte(), (unsigned char*) tensor->cpuDataHandle());
+                            if (i == 0)
+                            {
+                                tensor->template toType<double>()->randomize();
+                            }
+                            else
+                            {
+                                TensorBase<DeviceUsed> *firstTensor = std::get<TensorBase<DeviceUsed>*>(m_tensors[DeviceUsed][0]);
+                                std::copy((unsigned char*)firstTensor->cpuDataHandle(),
+                                          ((unsigned char*)firstTensor->cpuDataHandle())+firstTensor->sizeInByte(), (unsigned char*) tensor->cpuDataHandle());
+                            }
                         }
-                    }
-                    break;
-                case DataType::DOUBLE:
-                    tensor = new FreeWill::Tensor<DeviceUsed, double>(m_isBatchTensor?(m_shape + (m_batchSize = batchSize)):m_shape, m_name);
-                    tensor->template toType<double>()->init();
-                    if (m_isRandomlyInitialized)
-                    {
-                        if (i == 0)
+                        break;
+                    case DataType::BFLOAT16:
+                        tensor = new FreeWill::Tensor<DeviceUsed, BFloat16>(m_isBatchTensor?(m_shape + (m_batchSize = batchSize)):m_shape, m_name);
+                        tensor->template toType<BFloat16>()->init(tensorAllocator);
+                        if (m_isRandomlyInitialized && !m_fileStorage)
+                        {
+                            if (i == 0)
+                            {
+                                tensor->template toType<BFloat16>()->randomize();
+                            }
+                            else
+                            {
+                                TensorBase<DeviceUsed> *firstTensor = std::get<TensorBase<DeviceUsed>*>(m_tensors[DeviceUsed][0]);
+                                std::copy((unsigned char*)firstTensor->cpuDataHandle(),
+                                          ((unsigned char*)firstTensor->cpuDataHandle())+firstTensor->sizeInByte(), (unsigned char*) tensor->cpuDataHandle());
+                            }
+                        }
+                        break;
+                    case DataType::FLOAT16:
+                        tensor = new FreeWill::Tensor<DeviceUsed, Float16>(m_isBatchTensor?(m_shape + (m_batchSize = batchSize)):m_shape, m_name);
+                        tensor->template toType<Float16>()->init(tensorAllocator);
+                        if (m_isRandomlyInitialized && !m_fileStorage)
                         {
-                            tensor->template toType<double>()->randomize();
+                            if (i == 0)
+                            {
+                                tensor->template toType<Float16>()->randomize();
+                            }
+                            else
+                            {
+                                TensorBase<DeviceUsed> *firstTensor = std::get<TensorBase<DeviceUsed>*>(m_tensors[DeviceUsed][0]);
+                                std::copy((unsigned char*)firstTensor->cpuDataHandle(),
+                                          ((unsigned char*)firstTensor->cpuDataHandle())+firstTensor->sizeInByte(), (unsigned char*) tensor->cpuDataHandle());
+                            }
                         }
-                        else
+                        break;
+                    case DataType::UNSIGNED_INT:
+                        tensor = new FreeWill::Tensor<DeviceUsed, unsigned int>(m_isBatchTensor?(m_shape + (m_batchSize = batchSize)):m_shape, m_name);
+                        tensor->template toType<unsigned int>()->init(tensorAllocator);
+                        if (m_isRandomlyInitialized)
                         {
-                            TensorBase<DeviceUsed> *firstTensor = std::get<TensorBase<DeviceUsed>*>(m_tensors[DeviceUsed][0]);
-                            std::copy((unsigned char*)firstTensor->cpuDataHandle(),
-                                      ((unsigned char*)firstTensor->cpuDataHandle())+firstTensor->sizeInByte(), (unsigned char*) tensor->cpuDataHandle());
+                            //tensor->template toType<unsigned int>()->randomize();
                         }
+                        break;
+                    case DataType::INT8:
+                        tensor = new FreeWill::Tensor<DeviceUsed, int8_t>(m_isBatchTensor?(m_shape + (m_batchSize = batchSize)):m_shape, m_name);
+                        tensor->template toType<int8_t>()->init(tensorAllocator);
+                        break;
+                    default:
+                        break;
                     }
-                    break;
-                case DataType::UNSIGNED_INT:
-                    tensor = new FreeWill::Tensor<DeviceUsed, unsigned int>(m_isBatchTensor?(m_shape + (m_batchSize = batchSize)):m_shape, m_name);
-                    tensor->template toType<unsigned int>()->init();
-                    if (m_isRandomlyInitialized)
+                };
+
+                if constexpr (DeviceUsed == FreeWill::DeviceType::CPU_NAIVE)
+                {
+                    if (Context<DeviceUsed>::getSingleton().threadPinning())
+                    {
+                        Context<DeviceUsed>::getSingleton().runOnDevice(i, createTensor);
+                    }
+                    else
                     {
-                        //tensor->template toType<unsigned int>()->randomize();
+                        createTensor();
                     }
-                    break;
-                default:
-                    break;
+                }
+                else
+                {
+                    createTensor();
                 }
 
                 m_tensors[DeviceUsed].push_back(tensor);
@@ -155,6 +286,32 @@ namespace FreeWill
             cudaSetDevice(0);
         }
 
+        //one allocation for all devices, each device's tensor is a view of its
+        //samples. the whole batch is first touched by the calling thread
+        template<typename DataType_>
+        void allocateSlicedBatch(unsigned int batchSize, int deviceCount, Allocator *allocator)
+        {
+            m_batchSize = batchSize;
+
+            Tensor<DeviceType::CPU_NAIVE, DataType_> *slicedBatch = new Tensor<DeviceType::CPU_NAIVE, DataType_>(m_shape + batchSize * deviceCount, m_name);
+            slicedBatch->init(allocator);
+
+            if constexpr (!std::is_integral<DataType_>::value)
+            {
+                if (m_isRandomlyInitialized && !m_fileStorage)
+                {
+                    slicedBatch->randomize();
+                }
+            }
+
+            m_slicedBatch = slicedBatch;
+
+            for (int i = 0; i < deviceCount; ++i)
+            {
+                m_tensors[DeviceType::CPU_NAIVE].push_back(new Tensor<DeviceType::CPU_NAIVE, DataType_>(slicedBatch->sliceBatch(i * batchSize, (i + 1) * batchSize)));
+            }
+        }
+
         template<DeviceType DeviceUsed = DeviceType::CPU_NAIVE>
         TensorBase<DeviceUsed> *getTensorForDevice(unsigned int deviceIndex)
         {
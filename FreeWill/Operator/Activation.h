@@ -86,18 +86,21 @@ namespace FreeWill
             {
                 unsigned int size = _input->shape().size();
 
+                using Accumulator = typename AccumulatorType<DataType>::type;
+
                 if constexpr (ActivationModeUsed == ActivationMode::SIGMOID)
                 {
                     for(unsigned int i = 0; i < size; ++i)
                     {
-                        (*_output)[i] = 1 / (1 + exp(-(*_input)[i]));
+                        (*_output)[i] = 1 / (1 + exp(-(Accumulator) (*_input)[i]));
                     }
                 }
                 else if constexpr (ActivationModeUsed == ActivationMode::RELU)
                 {
                     for(unsigned int i =0;i<size; ++i)
                     {
-                        (*_output)[i] = (*_input)[i] > 0.0 ? (*_input)[i] : 0.0;
+                        Accumulator value = (*_input)[i];
+                        (*_output)[i] = value > 0.0 ? value : 0.0;
                     }
                 }
                 else if constexpr (ActivationModeUsed == ActivationMode::TANH)
@@ -88,18 +88,21 @@ namespace FreeWill
 
             if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
             {
+                using Accumulator = typename AccumulatorType<DataType>::type;
+
                 if constexpr (ActivationModeUsed == ActivationMode::SIGMOID)
                 {
                     for (unsigned int i =0; i<size; ++i)
                     {
-                        (*_inputDelta)[i] = (*_output)[i] * (1.0 - (*_output)[i]) * (*_outputDelta)[i];
+                        Accumulator output = (*_output)[i];
+                        (*_inputDelta)[i] = output * (1 - output) * (Accumulator) (*_outputDelta)[i];
                     }
                 }
                 else if constexpr (ActivationModeUsed == ActivationMode::RELU)
                 {
                     for(unsigned int i =0;i<size; ++i)
                     {
-                        (*_inputDelta)[i] = ((*_output)[i] > 0.0 ? 1.0 : 0.0) * (*_outputDelta)[i];
+                        (*_inputDelta)[i] = ((Accumulator) (*_output)[i] > 0 ? (Accumulator) (*_outputDelta)[i] : 0);
                     }
                 }
                 else if constexpr (ActivationModeUsed == ActivationMode::TANH)
@@ -4,11 +4,15 @@
 #include <QDebug>
 #include "Operator.h"
 #include "../Context/Context.h"
+#include "Gemm.h"
+#include "Im2col.h"
+#include "Winograd.h"
+#include "FftConvolution.h"
+#include "ConvolutionAlgorithm.h"
 
 namespace FreeWill
 {
 
-
     template<DeviceType DeviceUsed = DeviceType::CPU_NAIVE, typename DataType = float>
     class Convolution : public Operator<DeviceUsed>
     {
@@ -21,6 +25,9 @@ namespace FreeWill
         unsigned int m_strideX;
         unsigned int m_zeroPaddingY;
         unsigned int m_strideY;
+        ConvolutionAlgorithm m_algorithm;
+        WinogradConvolution<DataType> m_winograd;
+        FftConvolution<DataType> m_fft;
 
         cudnnTensorDescriptor_t m_inputGPUTensorDescriptor;
         cudnnTensorDescriptor_t m_outputGPUTensorDescriptor;
@@ -39,6 +46,9 @@ namespace FreeWill
             m_strideX(strideX),
             m_zeroPaddingY(zeroPaddingY),
             m_strideY(strideY),
+            m_algorithm(ConvolutionAlgorithm::AUTO),
+            m_winograd(),
+            m_fft(),
             m_inputGPUTensorDescriptor(0),
             m_outputGPUTensorDescriptor(0),
             m_biasGPUTensorDescriptor(0),
@@ -119,6 +129,17 @@ namespace FreeWill
             printf("Tensor descriptor: %d, dim: %d,%d,%d,%d | stride: %d,%d,%d,%d\n", dimnb, dimA[0], dimA[1], dimA[2], dimA[3],strideA[0],strideA[1],strideA[2],strideA[3]);
         }
 
+        //ignored on GPU and for the 16 bit types, which always loop
+        void setAlgorithm(ConvolutionAlgorithm algorithm)
+        {
+            m_algorithm = algorithm;
+        }
+
+        ConvolutionAlgorithm algorithm() const
+        {
+            return m_algorithm;
+        }
+
         static void reg()
         {
             OperatorRegistry<Convolution<DeviceUsed, DataType>>::m_operatorFactoryInitializer.getA();
@@ -320,13 +341,46 @@ namespace FreeWill
 
             unsigned int batchSize = _input->shape()[3];
 
-            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE && (std::is_same<DataType, float>::value || std::is_same<DataType, double>::value))
             {
-                for (unsigned int b = 0; b < batchSize; ++b)
+                ConvolutionAlgorithm algorithm = cpuAlgorithm(channelCount, featureMapLength, featureMapCount, newWidth, newHeight);
+
+                switch (algorithm)
                 {
+                case ConvolutionAlgorithm::WINOGRAD_2X2:
+                case ConvolutionAlgorithm::WINOGRAD_4X4:
+                    m_winograd.setFilter(_featureMap->cpuDataHandle(), channelCount, featureMapCount,
+                                         algorithm == ConvolutionAlgorithm::WINOGRAD_4X4 ? 4 : 2, false);
+                    m_winograd.evaluate(_input->cpuDataHandle(), originalWidth, originalHeight, batchSize, m_zeroPaddingX, m_zeroPaddingY,
+                                        _output->cpuDataHandle(), newWidth, newHeight, _bias->cpuDataHandle());
+                    return;
+                case ConvolutionAlgorithm::FFT:
+                    m_fft.setFilter(_featureMap->cpuDataHandle(), channelCount, featureMapLength, featureMapCount, newWidth, newHeight);
+                    m_fft.evaluate(_input->cpuDataHandle(), originalWidth, originalHeight, batchSize, m_zeroPaddingX, m_zeroPaddingY,
+                                   _output->cpuDataHandle(), newWidth, newHeight, _bias->cpuDataHandle());
+                    return;
+                case ConvolutionAlgorithm::GEMM:
+                    evaluateGemm(_input, _featureMap, _bias, _output, newWidth, newHeight);
+                    return;
+                default:
+                    break;
+                }
+            }
 
-                    for(unsigned int newIndexY = 0; newIndexY < newHeight;++newIndexY)
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                //the sum stays in the accumulator type and is stored once, so 16 bit
+                //outputs are rounded once per pixel instead of once per tap
+                using Accumulator = typename AccumulatorType<DataType>::type;
+
+                //rows of the output never overlap, so the chunks can run on any worker
+                Context<DeviceUsed>::getSingleton().parallelFor(0, batchSize * newHeight, [&](unsigned int rowBegin, unsigned int rowEnd)
+                {
+                    for (unsigned int row = rowBegin; row < rowEnd; ++row)
                     {
+                        unsigned int b = row / newHeight;
+                        unsigned int newIndexY = row % newHeight;
+
                         for (unsigned int newIndexX = 0; newIndexX < newWidth;++newIndexX)
                         {
 
@@ -336,7 +390,7 @@ namespace FreeWill
                             for (unsigned int k = 0; k < featureMapCount; ++k)
                             {
                                 unsigned int resultBaseIndex = (b * newWidth*newHeight +newIndexY * newWidth + newIndexX) * featureMapCount;
-
+                                Accumulator sum = (Accumulator) (*_output)[resultBaseIndex + k];
 
                                 for(int y = 0; y< (int)featureMapLength; ++y)
                                 {
@@ -353,10 +407,9 @@ namespace FreeWill
                                 
                                             for(unsigned int c = 0;c<channelCount;++c)
                                             {
-                                                (*_output)[resultBaseIndex + k] +=
-                                                    (*_featureMap)[(k * (featureMapLength * featureMapLength) +
+                                                sum += (Accumulator) (*_featureMap)[(k * (featureMapLength * featureMapLength) +
                                                         y*featureMapLength +x) * channelCount + c]
-                                                    * (*_input)[originalBaseIndex + c];
+                                                    * (Accumulator) (*_input)[originalBaseIndex + c];
                                             }
                                         
                                             //qDebug() << "base index" << realX << ";" << realY << ";" <<originalWidth <<";"<< originalBaseIndex;
@@ -369,11 +422,11 @@ namespace FreeWill
 
                                 //qDebug() << "result loc" << resultBaseIndex + k;
 
-                                (*_output)[resultBaseIndex + k] += (*_bias)[k];
+                                (*_output)[resultBaseIndex + k] = sum + (Accumulator) (*_bias)[k];
                             }
                         }
                     }
-                }
+                });
 
             }
             else if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
@@ -420,6 +473,104 @@ namespace FreeWill
             }
 
         }
+
+    protected:
+        //the algorithm that runs, AUTO and what can't run the shape resolved
+        ConvolutionAlgorithm cpuAlgorithm(unsigned int channelCount, unsigned int featureMapLength, unsigned int featureMapCount,
+                                          unsigned int newWidth, unsigned int newHeight) const
+        {
+            bool isWinogradSupported = WinogradConvolution<DataType>::isSupported(featureMapLength, m_strideX, m_strideY);
+            bool isFftSupported = FftConvolution<DataType>::isSupported(featureMapLength, m_strideX, m_strideY);
+
+            switch (m_algorithm)
+            {
+            case ConvolutionAlgorithm::AUTO:
+                //the transforms pay off once enough channels and filters share them
+                if (isWinogradSupported && channelCount >= 32 && featureMapCount >= 32)
+                {
+                    return (newWidth >= 16 && newHeight >= 16) ? ConvolutionAlgorithm::WINOGRAD_4X4 : ConvolutionAlgorithm::WINOGRAD_2X2;
+                }
+
+                //large filters over a few channels, on outputs several filters wide
+                if (isFftSupported && featureMapLength >= 5 && channelCount >= 4 &&
+                        newWidth >= 4 * featureMapLength && newHeight >= 4 * featureMapLength)
+                {
+                    return ConvolutionAlgorithm::FFT;
+                }
+
+                //a gemm row costs a copy of the filter's taps, which the direct loop
+                //wins back on bounds checks only when a few filters reuse it
+                if (featureMapCount >= 4 && featureMapLength * featureMapLength * channelCount >= 8)
+                {
+                    return ConvolutionAlgorithm::GEMM;
+                }
+
+                return ConvolutionAlgorithm::DIRECT;
+            case ConvolutionAlgorithm::WINOGRAD_2X2:
+            case ConvolutionAlgorithm::WINOGRAD_4X4:
+                return isWinogradSupported ? m_algorithm : ConvolutionAlgorithm::DIRECT;
+            case ConvolutionAlgorithm::FFT:
+                return isFftSupported ? m_algorithm : ConvolutionAlgorithm::DIRECT;
+            default:
+                return m_algorithm;
+            }
+        }
+
+        //output (pixels x filters) += im2col rows (pixels x taps) * featureMap^T (taps x filters) + bias,
+        //adding like the direct loop does
+        void evaluateGemm(Tensor<DeviceUsed, DataType> *_input, Tensor<DeviceUsed, DataType> *_featureMap,
+                          Tensor<DeviceUsed, DataType> *_bias, Tensor<DeviceUsed, DataType> *_output,
+                          unsigned int newWidth, unsigned int newHeight)
+        {
+            unsigned int featureMapCount = _featureMap->shape()[3];
+            unsigned int featureMapLength = _featureMap->shape()[1];
+            unsigned int channelCount = _featureMap->shape()[0];
+            unsigned int originalWidth = _input->shape()[1];
+            unsigned int originalHeight = _input->shape()[2];
+            unsigned int batchSize = _input->shape()[3];
+
+            unsigned int filterLength = featureMapLength * featureMapLength * channelCount;
+            unsigned int pixelCount = batchSize * newWidth * newHeight;
+
+            //a 1x1 filter at stride 1 reads the input pixels as they are
+            bool isInPlace = featureMapLength == 1 && m_strideX == 1 && m_strideY == 1 && m_zeroPaddingX == 0 && m_zeroPaddingY == 0;
+
+            //rows that fit the workspace in L2, at least a few register blocks of them
+            unsigned int pixelsPerBlock = std::max(24u, (unsigned int) ((256 * 1024) / (filterLength * sizeof(DataType))));
+            unsigned int blockCount = (pixelCount + pixelsPerBlock - 1) / pixelsPerBlock;
+
+            const DataType *input = _input->cpuDataHandle();
+            const DataType *featureMap = _featureMap->cpuDataHandle();
+            const DataType *bias = _bias->cpuDataHandle();
+            DataType *output = _output->cpuDataHandle();
+
+            Context<DeviceUsed>::getSingleton().parallelFor(0, blockCount, [&](unsigned int blockBegin, unsigned int blockEnd)
+            {
+                for (unsigned int block = blockBegin; block < blockEnd; ++block)
+                {
+                    unsigned int pixelBegin = block * pixelsPerBlock;
+                    unsigned int pixelEnd = std::min(pixelCount, pixelBegin + pixelsPerBlock);
+
+                    const DataType *columns = input + pixelBegin * channelCount;
+
+                    if (!isInPlace)
+                    {
+                        DataType *workspace = gemmWorkspace<DataType>((size_t) pixelsPerBlock * filterLength);
+
+                        im2col(input, originalWidth, originalHeight, channelCount, featureMapLength,
+                               m_strideX, m_strideY, m_zeroPaddingX, m_zeroPaddingY, newWidth, newHeight,
+                               pixelBegin, pixelEnd, workspace);
+
+                        columns = workspace;
+                    }
+
+                    gemm<DataType>(pixelEnd - pixelBegin, featureMapCount, filterLength,
+                                   columns, filterLength, 1,
+                                   featureMap, 1, filterLength,
+                                   output + pixelBegin * featureMapCount, featureMapCount, true, bias);
+                }
+            });
+        }
     };
 }
 
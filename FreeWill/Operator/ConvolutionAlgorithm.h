@@ -0,0 +1,21 @@
+#ifndef CONVOLUTIONALGORITHM_H
+#define CONVOLUTIONALGORITHM_H
+
+namespace FreeWill
+{
+    // How the CPU evaluates a Convolution or the InputGrad of a
+    // ConvolutionDerivative. AUTO picks by the filter, stride, channel counts
+    // and output size, DIRECT is the plain loop and stays as the reference for
+    // the others. An algorithm that can't run the shape falls back to DIRECT.
+    enum class ConvolutionAlgorithm
+    {
+        AUTO,
+        DIRECT,
+        GEMM,
+        WINOGRAD_2X2,
+        WINOGRAD_4X4,
+        FFT
+    };
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "Operator.h"
 #include "../Context/Context.h"
+#include "Winograd.h"
+#include "ConvolutionAlgorithm.h"
 
 namespace FreeWill
 {
@@ -19,6 +21,8 @@ namespace FreeWill
         unsigned int m_strideY;
         unsigned int m_zeroPaddingX;
         unsigned int m_zeroPaddingY;
+        ConvolutionAlgorithm m_algorithm;
+        WinogradConvolution<DataType> m_winograd;
 
         cudnnTensorDescriptor_t m_prevActivationGPUTensorDescriptor;
         cudnnTensorDescriptor_t m_outputDeltaGPUTensorDescriptor;
@@ -42,6 +46,8 @@ namespace FreeWill
             m_strideY(strideY),
             m_zeroPaddingX(zeroPaddingX),
             m_zeroPaddingY(zeroPaddingY),
+            m_algorithm(ConvolutionAlgorithm::AUTO),
+            m_winograd(),
             m_prevActivationGPUTensorDescriptor(0),
             m_outputDeltaGPUTensorDescriptor(0),
             m_biasGradGPUTensorDescriptor(0),
@@ -133,6 +139,17 @@ namespace FreeWill
             }           
         }
 
+        //for InputGrad on CPU, only DIRECT and the Winograd ones apply here
+        void setAlgorithm(ConvolutionAlgorithm algorithm)
+        {
+            m_algorithm = algorithm;
+        }
+
+        ConvolutionAlgorithm algorithm() const
+        {
+            return m_algorithm;
+        }
+
         virtual bool init() override
         {
             CHECK_GPU;
@@ -416,67 +433,129 @@ namespace FreeWill
             unsigned int batchSize = _prevActivation->shape()[3];
             if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
             {
-                for (unsigned int b = 0; b < batchSize; ++b)
+                using Accumulator = typename AccumulatorType<DataType>::type;
+
+                std::vector<Accumulator> featureMapGradScratch;
+                std::vector<Accumulator> biasGradScratch;
+                std::vector<Accumulator> inputGradScratch;
+                Accumulator *featureMapGrad = accumulatorData(_featureMapGrad, featureMapGradScratch);
+                Accumulator *biasGrad = accumulatorData(_biasGrad, biasGradScratch);
+                Accumulator *inputGrad = accumulatorData(_inputGrad, inputGradScratch);
+
+                //FeatureMapGrad and BiasGrad are summed over the whole batch, split them by filter.
+                //InputGrad is private to each sample, split it by batch. Within a chunk every
+                //element is accumulated in the same order as a single threaded pass.
+                Context<DeviceUsed>::getSingleton().parallelFor(0, featureMapCount, [&](unsigned int featureMapBegin, unsigned int featureMapEnd)
                 {
-                    for(unsigned int newIndexY = 0; newIndexY < newHeight;++newIndexY)
+                    for (unsigned int k = featureMapBegin; k < featureMapEnd; ++k)
                     {
-                        for (unsigned int newIndexX = 0; newIndexX < newWidth;++newIndexX)
+                        for (unsigned int b = 0; b < batchSize; ++b)
                         {
+                            for(unsigned int newIndexY = 0; newIndexY < newHeight;++newIndexY)
+                            {
+                                for (unsigned int newIndexX = 0; newIndexX < newWidth;++newIndexX)
+                                {
+                                    int startX = -m_zeroPaddingX + newIndexX * m_strideX;
+                                    int startY = -m_zeroPaddingY + newIndexY * m_strideY;
 
-                            int startX = -m_zeroPaddingX + newIndexX * m_strideX;
-                            int startY = -m_zeroPaddingY + newIndexY * m_strideY;
+                                    unsigned int resultBaseIndex = (b * newWidth*newHeight +newIndexY * newWidth + newIndexX) * featureMapCount;
 
-                            unsigned int resultBaseIndex = (b * newWidth*newHeight +newIndexY * newWidth + newIndexX) * featureMapCount; 
+                                    for(int y = 0; y< (int)featureMapLength; ++y)
+                                    {
+                                        for(int x = 0; x < (int)featureMapLength; ++x)
+                                        {
+                                            int realX = x + startX;
+                                            int realY = y + startY;
 
-                            for (unsigned int k = 0; k < featureMapCount; ++k)
-                            {
+                                            if ((realX >= 0 && realX < (int)originalWidth)
+                                                    && (realY>=0 && realY< (int)originalHeight))
+                                            {
+                                                unsigned int originalBaseIndex = (b* originalHeight * originalWidth + realY*originalWidth + realX)
+                                                    *channelCount;
+                                                unsigned int featureMapBaseIndex = (k*(featureMapLength * featureMapLength) + y*featureMapLength + x) * channelCount;
+
+                                                for(unsigned int c = 0;c<channelCount;++c)
+                                                {
+                                                    featureMapGrad[featureMapBaseIndex + c]
+                                                        += (Accumulator) (*_outputGrad)[resultBaseIndex + k] * (Accumulator) (*_prevActivation)[originalBaseIndex + c];
+                                                }
+                                            }
+                                        }
+                                    }
 
-                                for(int y = 0; y< (int)featureMapLength; ++y)
+                                    biasGrad[k] += (Accumulator) (*_outputGrad)[resultBaseIndex + k];
+                                }
+                            }
+                        }
+                    }
+                });
+
+                //InputGrad is the stride 1 correlation of OutputGrad, padded by 2 - zero padding,
+                //with the filters turned by 180 degrees
+                ConvolutionAlgorithm inputGradAlgorithm = inputGradCpuAlgorithm(channelCount, featureMapLength, featureMapCount,
+                                                                                originalWidth, originalHeight);
+
+                if constexpr (std::is_same<DataType, float>::value || std::is_same<DataType, double>::value)
+                {
+                    if (inputGradAlgorithm != ConvolutionAlgorithm::DIRECT)
+                    {
+                        m_winograd.setFilter(_featureMap->cpuDataHandle(), channelCount, featureMapCount,
+                                             inputGradAlgorithm == ConvolutionAlgorithm::WINOGRAD_4X4 ? 4 : 2, true);
+                        m_winograd.evaluate(_outputGrad->cpuDataHandle(), newWidth, newHeight, batchSize,
+                                            2 - m_zeroPaddingX, 2 - m_zeroPaddingY,
+                                            _inputGrad->cpuDataHandle(), originalWidth, originalHeight);
+                    }
+                }
+
+                if (inputGradAlgorithm == ConvolutionAlgorithm::DIRECT)
+                {
+                    Context<DeviceUsed>::getSingleton().parallelFor(0, batchSize, [&](unsigned int batchBegin, unsigned int batchEnd)
+                    {
+                        for (unsigned int b = batchBegin; b < batchEnd; ++b)
+                        {
+                            for(unsigned int newIndexY = 0; newIndexY < newHeight;++newIndexY)
+                            {
+                                for (unsigned int newIndexX = 0; newIndexX < newWidth;++newIndexX)
                                 {
-                                    for(int x = 0; x < (int)featureMapLength; ++x)
-                                    {
-                                        int realX = x + startX;
-                                        int realY = y + startY;
+                                    int startX = -m_zeroPaddingX + newIndexX * m_strideX;
+                                    int startY = -m_zeroPaddingY + newIndexY * m_strideY;
+
+                                    unsigned int resultBaseIndex = (b * newWidth*newHeight +newIndexY * newWidth + newIndexX) * featureMapCount;
 
-                                        if ((realX >= 0 && realX < (int)originalWidth) 
-                                                && (realY>=0 && realY< (int)originalHeight))
+                                    for (unsigned int k = 0; k < featureMapCount; ++k)
+                                    {
+                                        for(int y = 0; y< (int)featureMapLength; ++y)
                                         {
-                                            unsigned int originalBaseIndex = (b* originalHeight * originalWidth + realY*originalWidth + realX)
-                                                *channelCount;
-                                            unsigned int featureMapBaseIndex = (k*(featureMapLength * featureMapLength) + y*featureMapLength + x) * channelCount; 
-                                
-                                            for(unsigned int c = 0;c<channelCount;++c)
+                                            for(int x = 0; x < (int)featureMapLength; ++x)
                                             {
-                                                /*(*_output)[resultBaseIndex + k] += 
-                                                    (*_featureMap)[(k * (featureMapLength * featureMapLength) + 
-                                                            y*featureMapLength +x) * channelCount + c]
-                                                    * (*_input)[originalBaseIndex + c];
-                                                */
-
-                                                (*_featureMapGrad)[featureMapBaseIndex + c]
-                                                    += (*_outputGrad)[resultBaseIndex + k] * (*_prevActivation)[originalBaseIndex + c];
-
-                                                (*_inputGrad)[originalBaseIndex + c] += (*_featureMap)[(k * (featureMapLength * featureMapLength) + 
-                                                    y*featureMapLength + x)*channelCount + c] * (*_outputGrad)[resultBaseIndex + k];
-                                             
+                                                int realX = x + startX;
+                                                int realY = y + startY;
+
+                                                if ((realX >= 0 && realX < (int)originalWidth)
+                                                        && (realY>=0 && realY< (int)originalHeight))
+                                                {
+                                                    unsigned int originalBaseIndex = (b* originalHeight * originalWidth + realY*originalWidth + realX)
+                                                        *channelCount;
+
+                                                    for(unsigned int c = 0;c<channelCount;++c)
+                                                    {
+                                                        inputGrad[originalBaseIndex + c] += (Accumulator) (*_featureMap)[(k * (featureMapLength * featureMapLength) +
+                                                            y*featureMapLength + x)*channelCount + c] * (Accumulator) (*_outputGrad)[resultBaseIndex + k];
+                                                    }
+                                                }
                                             }
-                                        
-                                            //qDebug() << "base index" << realX << ";" << realY << ";" <<originalWidth <<";"<< originalBaseIndex;
-                                            //qDebug() << "feature map" << (*_featureMap)[(k * (featureMapLength * featureMapLength) +
-                                            //            y*featureMapLength +x) * channelCount + 0];                                   
-                                            //qDebug() << (*_input)[originalBaseIndex ];
                                         }
                                     }
                                 }
-
-                                //qDebug() << "result loc" << resultBaseIndex + k;
-                                (*_biasGrad)[k] += (*_outputGrad)[resultBaseIndex + k];
-                                //(*_output)[resultBaseIndex + k] += (*_bias)[k]; 
                             }
                         }
-                    }                
+                    });
                 }
 
+                storeAccumulatorData(_featureMapGrad, featureMapGradScratch);
+                storeAccumulatorData(_biasGrad, biasGradScratch);
+                storeAccumulatorData(_inputGrad, inputGradScratch);
+
                 //DataType scale = 1.0 / (newWidth * newHeight);
 
 
@@ -541,6 +620,61 @@ namespace FreeWill
 
         }
 
+
+    protected:
+        //16 bit gradients are summed in a float copy and rounded back once by
+        //storeAccumulatorData, wider types are summed in place
+        static typename AccumulatorType<DataType>::type *accumulatorData(Tensor<DeviceUsed, DataType> *tensor,
+                                                                         std::vector<typename AccumulatorType<DataType>::type> &scratch)
+        {
+            if constexpr (std::is_same<typename AccumulatorType<DataType>::type, DataType>::value)
+            {
+                return tensor->cpuDataHandle();
+            }
+            else
+            {
+                scratch.resize(tensor->shape().size());
+                convertData(tensor->cpuDataHandle(), scratch.data(), scratch.size());
+                return scratch.data();
+            }
+        }
+
+        static void storeAccumulatorData(Tensor<DeviceUsed, DataType> *tensor, const std::vector<typename AccumulatorType<DataType>::type> &scratch)
+        {
+            if constexpr (!std::is_same<typename AccumulatorType<DataType>::type, DataType>::value)
+            {
+                convertData(scratch.data(), tensor->cpuDataHandle(), scratch.size());
+            }
+        }
+
+        //the algorithm InputGrad runs with, AUTO and what can't run the shape resolved
+        ConvolutionAlgorithm inputGradCpuAlgorithm(unsigned int channelCount, unsigned int featureMapLength, unsigned int featureMapCount,
+                                                   unsigned int originalWidth, unsigned int originalHeight) const
+        {
+            if constexpr (!std::is_same<DataType, float>::value && !std::is_same<DataType, double>::value)
+            {
+                return ConvolutionAlgorithm::DIRECT;
+            }
+
+            bool isWinogradSupported = WinogradConvolution<DataType>::isSupported(featureMapLength, m_strideX, m_strideY) &&
+                    m_zeroPaddingX <= 2 && m_zeroPaddingY <= 2;
+
+            switch (m_algorithm)
+            {
+            case ConvolutionAlgorithm::AUTO:
+                if (isWinogradSupported && channelCount >= 32 && featureMapCount >= 32)
+                {
+                    return (originalWidth >= 16 && originalHeight >= 16) ? ConvolutionAlgorithm::WINOGRAD_4X4 : ConvolutionAlgorithm::WINOGRAD_2X2;
+                }
+
+                return ConvolutionAlgorithm::DIRECT;
+            case ConvolutionAlgorithm::WINOGRAD_2X2:
+            case ConvolutionAlgorithm::WINOGRAD_4X4:
+                return isWinogradSupported ? m_algorithm : ConvolutionAlgorithm::DIRECT;
+            default:
+                return ConvolutionAlgorithm::DIRECT;
+            }
+        }
     };
 }
 
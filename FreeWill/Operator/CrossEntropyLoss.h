@@ -52,16 +52,19 @@ namespace FreeWill
 
             if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
             {
+                using Accumulator = typename AccumulatorType<DataType>::type;
+
                 for(unsigned int e = 0; e< batchSize; ++e)
                 {
-                    (*_cost)[e] = 0;
+                    Accumulator cost = 0;
                     for(size_t i = 0; i < vectorSize; ++i)
                     {
-                        (*_cost)[e] += (*_label)[e * vectorSize + i]*log((*_input)[e * vectorSize + i]) 
-                            + (1.0 - (*_label)[e*vectorSize +i])*log(1.0 - (*_input)[e* vectorSize + i]);
+                        Accumulator label = (*_label)[e * vectorSize + i];
+                        Accumulator value = (*_input)[e * vectorSize + i];
+                        cost += label*log(value) + (1.0 - label)*log(1.0 - value);
                     }
                 
-                    (*_cost)[e] *= -1.0;
+                    (*_cost)[e] = -cost;
                 }
             }
             else if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
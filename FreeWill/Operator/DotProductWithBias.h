@@ -7,6 +7,7 @@
 #include <cublas_v2.h>
 #include <type_traits>
 #include "../Context/Context.h"
+#include "Gemm.h"
 
 
 namespace FreeWill
@@ -77,24 +78,40 @@ namespace FreeWill
             Tensor<DeviceUsed, DataType> *_output = output("Output")->template toType<DataType>();
             Tensor<DeviceUsed, DataType> *_bias = input("Bias")->template toType<DataType>();
 
-            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE && (std::is_same<DataType, float>::value || std::is_same<DataType, double>::value))
             {
-                for(unsigned int b = 0; b < batchSize; ++b)
+                //output (batch x output) = input (batch x input) * weight (input x output), all row major
+                parallelGemm<DataType>(batchSize, outputSize, inputSize,
+                                       _input->cpuDataHandle(), inputSize, 1,
+                                       _weight->cpuDataHandle(), outputSize, 1,
+                                       _output->cpuDataHandle(), outputSize, false, m_hasBias ? _bias->cpuDataHandle() : nullptr);
+            }
+            else if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                using Accumulator = typename AccumulatorType<DataType>::type;
+
+                //split over batch x output, so a single large sample still spreads over the workers
+                Context<DeviceUsed>::getSingleton().parallelFor(0, batchSize * outputSize, [&](unsigned int indexBegin, unsigned int indexEnd)
                 {
-                    for(unsigned int o =0; o<outputSize;++o)
+                    for(unsigned int index = indexBegin; index < indexEnd; ++index)
                     {
-                        (*_output)[b * outputSize + o] = 0;
+                        unsigned int b = index / outputSize;
+                        unsigned int o = index % outputSize;
+
+                        Accumulator sum = 0;
                         for(unsigned int i = 0; i< inputSize; ++i)
                         {
-                            (*_output)[b * outputSize + o] += (*_weight)[i * outputSize + o] * (*_input)[b* inputSize + i];
+                            sum += (Accumulator) (*_weight)[i * outputSize + o] * (Accumulator) (*_input)[b* inputSize + i];
                         }
 
                         if (m_hasBias)
                         {
-                            (*_output)[b * outputSize + o] += (*_bias)[ o];
+                            sum += (Accumulator) (*_bias)[ o];
                         }
+
+                        (*_output)[b * outputSize + o] = sum;
                     }
-                }        
+                }, std::max(1u, 4096 / std::max(inputSize, 1u)));
             }
             else if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
             {
@@ -3,9 +3,13 @@
 
 #include "Operator.h"
 #include "../Context/Context.h"
+#include "Gemm.h"
 
 namespace FreeWill
 {
+    // WeightGrad and BiasGrad are overwritten with this batch's gradient, so
+    // they don't need to be cleared before backward. With isAccumulating the
+    // gradient is added to them instead, e.g. to sum it over several batches.
     template<DeviceType DeviceUsed = DeviceType::CPU_NAIVE, typename DataType = float>
     class DotProductWithBiasDerivative : public Operator<DeviceUsed>
     {
@@ -14,11 +18,13 @@ namespace FreeWill
         using Operator<DeviceUsed>::output;
         using Operator<DeviceUsed>::m_deviceId;
         bool m_hasBias;
+        bool m_isAccumulating;
 
     public:
-        DotProductWithBiasDerivative(bool hasBias = true, unsigned int deviceId = 0)
+        DotProductWithBiasDerivative(bool hasBias = true, unsigned int deviceId = 0, bool isAccumulating = false)
             :Operator<DeviceUsed>({"InputActivation", "OutputDelta", "Weight"},{"WeightGrad", "BiasGrad", "InputDelta"}, deviceId),
-             m_hasBias(hasBias)
+             m_hasBias(hasBias),
+             m_isAccumulating(isAccumulating)
         {
         }
         
@@ -79,28 +85,61 @@ namespace FreeWill
            Tensor<DeviceUsed, DataType> *weight = input("Weight")->template toType<DataType>();
            Tensor<DeviceUsed, DataType> *biasGrad = output("BiasGrad")->template toType<DataType>();
 
-           if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+           if constexpr (DeviceUsed == DeviceType::CPU_NAIVE && (std::is_same<DataType, float>::value || std::is_same<DataType, double>::value))
            {
-                for(unsigned int b = 0;b<batchSize;++b)
+                //weightGrad (input x output) = preActivation^T (input x batch) * outputGrad (batch x output)
+                parallelGemm<DataType>(inputSize, outputSize, batchSize,
+                                       preActivation->cpuDataHandle(), 1, inputSize,
+                                       outputGrad->cpuDataHandle(), outputSize, 1,
+                                       weightGrad->cpuDataHandle(), outputSize, m_isAccumulating);
+
+                if (m_hasBias)
                 {
-                    for(unsigned int e = 0; e<inputSize; ++e)
+                    for(unsigned int i =0;i<outputSize;++i)
                     {
-                        for(unsigned int i =0;i<outputSize;++i)
+                        DataType sum = m_isAccumulating ? (*biasGrad)[i] : 0;
+                        for(unsigned int b = 0;b<batchSize;++b)
                         {
-                            /*if (e*outputSize + i == 0)
-                            {
-                                printf("adding %f %f\n", (*preActivation)[b*inputSize + e] , (*outputGrad)[b*outputSize + i]);
-                            }*/ 
-                            (*weightGrad)[ e * outputSize + i] += (*preActivation)[b*inputSize + e] * (*outputGrad)[b*outputSize + i];
+                            sum += (*outputGrad)[b*outputSize + i];
                         }
-                    }     
+                        (*biasGrad)[i] = sum;
+                    }
+                }
 
-                    if (m_hasBias)
+                //inputGrad (batch x input) = outputGrad (batch x output) * weight^T (output x input)
+                parallelGemm<DataType>(batchSize, inputSize, outputSize,
+                                       outputGrad->cpuDataHandle(), outputSize, 1,
+                                       weight->cpuDataHandle(), 1, outputSize,
+                                       inputGrad->cpuDataHandle(), inputSize);
+           }
+           else if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+           {
+                using Accumulator = typename AccumulatorType<DataType>::type;
+
+                //sum over the batch first, so a 16 bit gradient is rounded once per step
+                for(unsigned int e = 0; e<inputSize; ++e)
+                {
+                    for(unsigned int i =0;i<outputSize;++i)
                     {
-                        for(unsigned int i =0;i<outputSize;++i)
+                        Accumulator sum = m_isAccumulating ? (Accumulator) (*weightGrad)[ e * outputSize + i] : 0;
+                        for(unsigned int b = 0;b<batchSize;++b)
                         {
-                            (*biasGrad)[i] += (*outputGrad)[b*outputSize + i];
+                            sum += (Accumulator) (*preActivation)[b*inputSize + e] * (Accumulator) (*outputGrad)[b*outputSize + i];
                         }
+                        (*weightGrad)[ e * outputSize + i] = sum;
+                    }
+                }
+
+                if (m_hasBias)
+                {
+                    for(unsigned int i =0;i<outputSize;++i)
+                    {
+                        Accumulator sum = m_isAccumulating ? (Accumulator) (*biasGrad)[i] : 0;
+                        for(unsigned int b = 0;b<batchSize;++b)
+                        {
+                            sum += (Accumulator) (*outputGrad)[b*outputSize + i];
+                        }
+                        (*biasGrad)[i] = sum;
                     }
                 }
 
@@ -108,12 +147,14 @@ namespace FreeWill
                 {
                     for(unsigned int i = 0;i<inputSize;++i)
                     {
-                        (*inputGrad)[b *inputSize +  i] = 0;
+                        Accumulator sum = 0;
 
                         for (unsigned int e = 0;e<outputSize;++e)
                         {
-                            (*inputGrad)[b*inputSize + i] += (*weight)[i * outputSize + e] * (*outputGrad)[b*outputSize + e];
+                            sum += (Accumulator) (*weight)[i * outputSize + e] * (Accumulator) (*outputGrad)[b*outputSize + e];
                         }
+
+                        (*inputGrad)[b*inputSize + i] = sum;
                     }
                 }
            }
@@ -121,19 +162,20 @@ namespace FreeWill
            {
                DataType alpha = 1.0;
                DataType beta = 0.0;
+               DataType gradientBeta = m_isAccumulating ? 1.0 : 0.0;
 
                 if constexpr (std::is_same<DataType, float>::value)
                 {
                     RUN_CUBLAS(cublasSgemm(Context<DeviceUsed>::getSingleton().cublasHandle(m_deviceId), CUBLAS_OP_N, CUBLAS_OP_T,
                                            outputSize, inputSize, batchSize, &alpha, outputGrad->gpuDataHandle(), outputSize,
                                            preActivation->gpuDataHandle(), inputSize, 
-                                           &beta, weightGrad->gpuDataHandle(), outputSize));
+                                           &gradientBeta, weightGrad->gpuDataHandle(), outputSize));
                     if (m_hasBias)
                     {
                         RUN_CUBLAS(cublasSgemv(Context<DeviceUsed>::getSingleton().cublasHandle(m_deviceId),CUBLAS_OP_N,
                                     outputSize, batchSize, &alpha, outputGrad->gpuDataHandle(),outputSize,
                                     Context<DeviceUsed>::getSingleton().template getSharedOneVector<DataType>(batchSize), 1, 
-                                     &beta,biasGrad->gpuDataHandle(), 1));
+                                     &gradientBeta,biasGrad->gpuDataHandle(), 1));
                     }
 
                     RUN_CUBLAS(cublasSgemm(Context<DeviceUsed>::getSingleton().cublasHandle(m_deviceId), CUBLAS_OP_T, CUBLAS_OP_N,
@@ -147,13 +189,13 @@ namespace FreeWill
                      RUN_CUBLAS(cublasDgemm(Context<DeviceUsed>::getSingleton().cublasHandle(m_deviceId), CUBLAS_OP_N, CUBLAS_OP_T,
                                            outputSize, inputSize, batchSize, &alpha, outputGrad->gpuDataHandle(), outputSize,
                                            preActivation->gpuDataHandle(), inputSize, 
-                                           &beta, weightGrad->gpuDataHandle(), outputSize));
+                                           &gradientBeta, weightGrad->gpuDataHandle(), outputSize));
                     if (m_hasBias)
                     {
                         RUN_CUBLAS(cublasDgemv(Context<DeviceUsed>::getSingleton().cublasHandle(m_deviceId),CUBLAS_OP_N,
                                     outputSize, batchSize, &alpha, outputGrad->gpuDataHandle(),outputSize,
                                     Context<DeviceUsed>::getSingleton().template getSharedOneVector<DataType>(batchSize), 1,
-                                     &beta,biasGrad->gpuDataHandle(), 1));
+                                     &gradientBeta,biasGrad->gpuDataHandle(), 1));
                     }
 
                     RUN_CUBLAS(cublasDgemm(Context<DeviceUsed>::getSingleton().cublasHandle(m_deviceId), CUBLAS_OP_T, CUBLAS_OP_N,
@@ -13,7 +13,7 @@ namespace FreeWill
     class ElementwiseAdd : public Operator<DeviceUsed>
     {
     protected:
-        DataType m_rate;
+        typename AccumulatorType<DataType>::type m_rate;
         using Operator<DeviceUsed>::input;
         using Operator<DeviceUsed>::output;
         using Operator<DeviceUsed>::m_deviceId;
@@ -25,7 +25,7 @@ namespace FreeWill
         {
         }
 
-        void setRate(DataType rate)
+        void setRate(typename AccumulatorType<DataType>::type rate)
         {
             m_rate = rate;
         }
@@ -61,7 +61,7 @@ namespace FreeWill
             {
                 for(unsigned int e = 0; e<size; ++e)
                 {
-                    (*result)[e] = (*operandA)[e] + (*operandB)[e]*m_rate;
+                    (*result)[e] = (typename AccumulatorType<DataType>::type) (*operandA)[e] + (typename AccumulatorType<DataType>::type) (*operandB)[e]*m_rate;
                 }
             }
             else if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
@@ -0,0 +1,595 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+namespace FreeWill
+{
+    // Unnormalized complex DFT of any size, X[k] = sum x[n] e^(-2 pi i n k / size),
+    // as self-sorting (Stockham) mixed-radix stages: radix 4 and 2 first, then
+    // 3, 5 and whatever primes are left. Real and imaginary parts are kept in
+    // separate arrays, and batchSize transforms run side by side on interleaved
+    // data, element n of transform r is at r + batchSize * n, so that every
+    // butterfly is a plain loop over the batch. Source and destination of a
+    // stage never overlap, but with this many pointers gcc gives up checking
+    // that at run time, hence the ivdep on the batch loops.
+    template<typename DataType>
+    class Fft
+    {
+    private:
+        unsigned int m_size;
+        std::vector<unsigned int> m_factors;
+        //per stage of length l and radix p, twiddle[q * p + u] = e^(-2 pi i q u / l)
+        std::vector<DataType> m_twiddleReal;
+        std::vector<DataType> m_twiddleImaginary;
+        //per stage, root[t] = e^(-2 pi i t / p) for the generic butterfly
+        std::vector<DataType> m_rootReal;
+        std::vector<DataType> m_rootImaginary;
+
+        //one stage: reads x[r + stride * (q + j * m)], writes y[r + stride * (radix * q + u)]
+        struct Stage
+        {
+            unsigned int m;
+            size_t stride;
+            const DataType *twiddleReal;
+            const DataType *twiddleImaginary;
+            const DataType *sourceReal;
+            const DataType *sourceImaginary;
+            DataType *destinationReal;
+            DataType *destinationImaginary;
+        };
+
+        //i x forward, -i x inverse, as (real, imaginary) += sign * (-imaginary, real)
+        template<bool IsInverse>
+        static DataType sign()
+        {
+            return IsInverse ? DataType(1) : DataType(-1);
+        }
+
+        template<bool IsInverse>
+        static void radix2(const Stage &stage)
+        {
+            size_t stride = stage.stride;
+
+            for (unsigned int q = 0; q < stage.m; ++q)
+            {
+                DataType w1Real = stage.twiddleReal[q * 2 + 1];
+                DataType w1Imaginary = -sign<IsInverse>() * stage.twiddleImaginary[q * 2 + 1];
+
+                const DataType *a0Real = stage.sourceReal + stride * q;
+                const DataType *a0Imaginary = stage.sourceImaginary + stride * q;
+                const DataType *a1Real = a0Real + stride * stage.m;
+                const DataType *a1Imaginary = a0Imaginary + stride * stage.m;
+                DataType *yReal = stage.destinationReal + stride * (2 * q);
+                DataType *yImaginary = stage.destinationImaginary + stride * (2 * q);
+
+                #pragma GCC ivdep
+                for (size_t r = 0; r < stride; ++r)
+                {
+                    DataType differenceReal = a0Real[r] - a1Real[r];
+                    DataType differenceImaginary = a0Imaginary[r] - a1Imaginary[r];
+
+                    yReal[r] = a0Real[r] + a1Real[r];
+                    yImaginary[r] = a0Imaginary[r] + a1Imaginary[r];
+                    yReal[r + stride] = differenceReal * w1Real - differenceImaginary * w1Imaginary;
+                    yImaginary[r + stride] = differenceReal * w1Imaginary + differenceImaginary * w1Real;
+                }
+            }
+        }
+
+        template<bool IsInverse>
+        static void radix3(const Stage &stage)
+        {
+            size_t stride = stage.stride;
+            const DataType c = -0.5;
+            const DataType s = sign<IsInverse>() * DataType(0.86602540378443864676);
+
+            for (unsigned int q = 0; q < stage.m; ++q)
+            {
+                DataType wReal[3];
+                DataType wImaginary[3];
+
+                for (unsigned int u = 1; u < 3; ++u)
+                {
+                    wReal[u] = stage.twiddleReal[q * 3 + u];
+                    wImaginary[u] = -sign<IsInverse>() * stage.twiddleImaginary[q * 3 + u];
+                }
+
+                const DataType *a0Real = stage.sourceReal + stride * q;
+                const DataType *a0Imaginary = stage.sourceImaginary + stride * q;
+                const DataType *a1Real = a0Real + stride * stage.m;
+                const DataType *a1Imaginary = a0Imaginary + stride * stage.m;
+                const DataType *a2Real = a1Real + stride * stage.m;
+                const DataType *a2Imaginary = a1Imaginary + stride * stage.m;
+                DataType *yReal = stage.destinationReal + stride * (3 * q);
+                DataType *yImaginary = stage.destinationImaginary + stride * (3 * q);
+
+                #pragma GCC ivdep
+                for (size_t r = 0; r < stride; ++r)
+                {
+                    DataType sumReal = a1Real[r] + a2Real[r];
+                    DataType sumImaginary = a1Imaginary[r] + a2Imaginary[r];
+                    DataType middleReal = a0Real[r] + c * sumReal;
+                    DataType middleImaginary = a0Imaginary[r] + c * sumImaginary;
+                    DataType rotatedReal = -s * (a1Imaginary[r] - a2Imaginary[r]);
+                    DataType rotatedImaginary = s * (a1Real[r] - a2Real[r]);
+
+                    DataType b1Real = middleReal + rotatedReal;
+                    DataType b1Imaginary = middleImaginary + rotatedImaginary;
+                    DataType b2Real = middleReal - rotatedReal;
+                    DataType b2Imaginary = middleImaginary - rotatedImaginary;
+
+                    yReal[r] = a0Real[r] + sumReal;
+                    yImaginary[r] = a0Imaginary[r] + sumImaginary;
+                    yReal[r + stride] = b1Real * wReal[1] - b1Imaginary * wImaginary[1];
+                    yImaginary[r + stride] = b1Real * wImaginary[1] + b1Imaginary * wReal[1];
+                    yReal[r + 2 * stride] = b2Real * wReal[2] - b2Imaginary * wImaginary[2];
+                    yImaginary[r + 2 * stride] = b2Real * wImaginary[2] + b2Imaginary * wReal[2];
+                }
+            }
+        }
+
+        template<bool IsInverse>
+        static void radix4(const Stage &stage)
+        {
+            size_t stride = stage.stride;
+            const DataType s = sign<IsInverse>();
+
+            for (unsigned int q = 0; q < stage.m; ++q)
+            {
+                DataType wReal[4];
+                DataType wImaginary[4];
+
+                for (unsigned int u = 1; u < 4; ++u)
+                {
+                    wReal[u] = stage.twiddleReal[q * 4 + u];
+                    wImaginary[u] = -s * stage.twiddleImaginary[q * 4 + u];
+                }
+
+                const DataType *a0Real = stage.sourceReal + stride * q;
+                const DataType *a0Imaginary = stage.sourceImaginary + stride * q;
+                const DataType *a1Real = a0Real + stride * stage.m;
+                const DataType *a1Imaginary = a0Imaginary + stride * stage.m;
+                const DataType *a2Real = a1Real + stride * stage.m;
+                const DataType *a2Imaginary = a1Imaginary + stride * stage.m;
+                const DataType *a3Real = a2Real + stride * stage.m;
+                const DataType *a3Imaginary = a2Imaginary + stride * stage.m;
+                DataType *yReal = stage.destinationReal + stride * (4 * q);
+                DataType *yImaginary = stage.destinationImaginary + stride * (4 * q);
+
+                #pragma GCC ivdep
+                for (size_t r = 0; r < stride; ++r)
+                {
+                    DataType t0Real = a0Real[r] + a2Real[r];
+                    DataType t0Imaginary = a0Imaginary[r] + a2Imaginary[r];
+                    DataType t1Real = a0Real[r] - a2Real[r];
+                    DataType t1Imaginary = a0Imaginary[r] - a2Imaginary[r];
+                    DataType t2Real = a1Real[r] + a3Real[r];
+                    DataType t2Imaginary = a1Imaginary[r] + a3Imaginary[r];
+                    //-i (a1 - a3) forward, i (a1 - a3) inverse
+                    DataType t3Real = -s * (a1Imaginary[r] - a3Imaginary[r]);
+                    DataType t3Imaginary = s * (a1Real[r] - a3Real[r]);
+
+                    DataType b1Real = t1Real + t3Real;
+                    DataType b1Imaginary = t1Imaginary + t3Imaginary;
+                    DataType b2Real = t0Real - t2Real;
+                    DataType b2Imaginary = t0Imaginary - t2Imaginary;
+                    DataType b3Real = t1Real - t3Real;
+                    DataType b3Imaginary = t1Imaginary - t3Imaginary;
+
+                    yReal[r] = t0Real + t2Real;
+                    yImaginary[r] = t0Imaginary + t2Imaginary;
+                    yReal[r + stride] = b1Real * wReal[1] - b1Imaginary * wImaginary[1];
+                    yImaginary[r + stride] = b1Real * wImaginary[1] + b1Imaginary * wReal[1];
+                    yReal[r + 2 * stride] = b2Real * wReal[2] - b2Imaginary * wImaginary[2];
+                    yImaginary[r + 2 * stride] = b2Real * wImaginary[2] + b2Imaginary * wReal[2];
+                    yReal[r + 3 * stride] = b3Real * wReal[3] - b3Imaginary * wImaginary[3];
+                    yImaginary[r + 3 * stride] = b3Real * wImaginary[3] + b3Imaginary * wReal[3];
+                }
+            }
+        }
+
+        template<bool IsInverse>
+        static void radix5(const Stage &stage)
+        {
+            size_t stride = stage.stride;
+            const DataType c1 = 0.30901699437494742410;
+            const DataType c2 = -0.80901699437494742410;
+            const DataType s1 = sign<IsInverse>() * DataType(0.95105651629515357212);
+            const DataType s2 = sign<IsInverse>() * DataType(0.58778525229247312917);
+
+            for (unsigned int q = 0; q < stage.m; ++q)
+            {
+                DataType wReal[5];
+                DataType wImaginary[5];
+
+                for (unsigned int u = 1; u < 5; ++u)
+                {
+                    wReal[u] = stage.twiddleReal[q * 5 + u];
+                    wImaginary[u] = -sign<IsInverse>() * stage.twiddleImaginary[q * 5 + u];
+                }
+
+                const DataType *aReal[5];
+                const DataType *aImaginary[5];
+
+                for (unsigned int j = 0; j < 5; ++j)
+                {
+                    aReal[j] = stage.sourceReal + stride * (q + j * stage.m);
+                    aImaginary[j] = stage.sourceImaginary + stride * (q + j * stage.m);
+                }
+
+                DataType *yReal = stage.destinationReal + stride * (5 * q);
+                DataType *yImaginary = stage.destinationImaginary + stride * (5 * q);
+
+                #pragma GCC ivdep
+                for (size_t r = 0; r < stride; ++r)
+                {
+                    DataType t1Real = aReal[1][r] + aReal[4][r];
+                    DataType t1Imaginary = aImaginary[1][r] + aImaginary[4][r];
+                    DataType t2Real = aReal[2][r] + aReal[3][r];
+                    DataType t2Imaginary = aImaginary[2][r] + aImaginary[3][r];
+                    DataType t3Real = aReal[1][r] - aReal[4][r];
+                    DataType t3Imaginary = aImaginary[1][r] - aImaginary[4][r];
+                    DataType t4Real = aReal[2][r] - aReal[3][r];
+                    DataType t4Imaginary = aImaginary[2][r] - aImaginary[3][r];
+
+                    DataType m1Real = aReal[0][r] + c1 * t1Real + c2 * t2Real;
+                    DataType m1Imaginary = aImaginary[0][r] + c1 * t1Imaginary + c2 * t2Imaginary;
+                    DataType m2Real = aReal[0][r] + c2 * t1Real + c1 * t2Real;
+                    DataType m2Imaginary = aImaginary[0][r] + c2 * t1Imaginary + c1 * t2Imaginary;
+                    //i (s1 t3 + s2 t4) and i (s2 t3 - s1 t4), signed by the direction
+                    DataType n1Real = -(s1 * t3Imaginary + s2 * t4Imaginary);
+                    DataType n1Imaginary = s1 * t3Real + s2 * t4Real;
+                    DataType n2Real = -(s2 * t3Imaginary - s1 * t4Imaginary);
+                    DataType n2Imaginary = s2 * t3Real - s1 * t4Real;
+
+                    DataType bReal[5] = {aReal[0][r] + t1Real + t2Real, m1Real + n1Real, m2Real + n2Real, m2Real - n2Real, m1Real - n1Real};
+                    DataType bImaginary[5] = {aImaginary[0][r] + t1Imaginary + t2Imaginary, m1Imaginary + n1Imaginary,
+                                              m2Imaginary + n2Imaginary, m2Imaginary - n2Imaginary, m1Imaginary - n1Imaginary};
+
+                    yReal[r] = bReal[0];
+                    yImaginary[r] = bImaginary[0];
+
+                    for (unsigned int u = 1; u < 5; ++u)
+                    {
+                        yReal[r + u * stride] = bReal[u] * wReal[u] - bImaginary[u] * wImaginary[u];
+                        yImaginary[r + u * stride] = bReal[u] * wImaginary[u] + bImaginary[u] * wReal[u];
+                    }
+                }
+            }
+        }
+
+        template<bool IsInverse>
+        static void radixGeneric(const Stage &stage, unsigned int radix, const DataType *rootReal, const DataType *rootImaginary)
+        {
+            size_t stride = stage.stride;
+
+            for (unsigned int q = 0; q < stage.m; ++q)
+            {
+                for (unsigned int u = 0; u < radix; ++u)
+                {
+                    DataType wReal = stage.twiddleReal[q * radix + u];
+                    DataType wImaginary = -sign<IsInverse>() * stage.twiddleImaginary[q * radix + u];
+                    DataType *yReal = stage.destinationReal + stride * (radix * q + u);
+                    DataType *yImaginary = stage.destinationImaginary + stride * (radix * q + u);
+
+                    std::copy(stage.sourceReal + stride * q, stage.sourceReal + stride * (q + 1), yReal);
+                    std::copy(stage.sourceImaginary + stride * q, stage.sourceImaginary + stride * (q + 1), yImaginary);
+
+                    for (unsigned int j = 1; j < radix; ++j)
+                    {
+                        DataType cosine = rootReal[(j * u) % radix];
+                        DataType sine = -sign<IsInverse>() * rootImaginary[(j * u) % radix];
+                        const DataType *aReal = stage.sourceReal + stride * (q + j * stage.m);
+                        const DataType *aImaginary = stage.sourceImaginary + stride * (q + j * stage.m);
+
+                        #pragma GCC ivdep
+                        for (size_t r = 0; r < stride; ++r)
+                        {
+                            yReal[r] += aReal[r] * cosine - aImaginary[r] * sine;
+                            yImaginary[r] += aReal[r] * sine + aImaginary[r] * cosine;
+                        }
+                    }
+
+                    #pragma GCC ivdep
+                    for (size_t r = 0; r < stride; ++r)
+                    {
+                        DataType real = yReal[r];
+                        yReal[r] = real * wReal - yImaginary[r] * wImaginary;
+                        yImaginary[r] = real * wImaginary + yImaginary[r] * wReal;
+                    }
+                }
+            }
+        }
+
+        template<bool IsInverse>
+        void stages(DataType *real, DataType *imaginary, DataType *scratchReal, DataType *scratchImaginary, size_t batchSize) const
+        {
+            Stage stage;
+            stage.twiddleReal = m_twiddleReal.data();
+            stage.twiddleImaginary = m_twiddleImaginary.data();
+            stage.sourceReal = real;
+            stage.sourceImaginary = imaginary;
+            stage.destinationReal = scratchReal;
+            stage.destinationImaginary = scratchImaginary;
+            stage.stride = batchSize;
+
+            const DataType *rootReal = m_rootReal.data();
+            const DataType *rootImaginary = m_rootImaginary.data();
+            unsigned int length = m_size;
+
+            for (unsigned int radix : m_factors)
+            {
+                stage.m = length / radix;
+
+                switch (radix)
+                {
+                case 2:
+                    radix2<IsInverse>(stage);
+                    break;
+                case 3:
+                    radix3<IsInverse>(stage);
+                    break;
+                case 4:
+                    radix4<IsInverse>(stage);
+                    break;
+                case 5:
+                    radix5<IsInverse>(stage);
+                    break;
+                default:
+                    radixGeneric<IsInverse>(stage, radix, rootReal, rootImaginary);
+                    break;
+                }
+
+                DataType *nextReal = const_cast<DataType *>(stage.sourceReal);
+                DataType *nextImaginary = const_cast<DataType *>(stage.sourceImaginary);
+                stage.sourceReal = stage.destinationReal;
+                stage.sourceImaginary = stage.destinationImaginary;
+                stage.destinationReal = nextReal;
+                stage.destinationImaginary = nextImaginary;
+
+                stage.twiddleReal += length;
+                stage.twiddleImaginary += length;
+                rootReal += radix;
+                rootImaginary += radix;
+                length = stage.m;
+                stage.stride *= radix;
+            }
+
+            if (stage.sourceReal != real)
+            {
+                std::copy(stage.sourceReal, stage.sourceReal + m_size * batchSize, real);
+                std::copy(stage.sourceImaginary, stage.sourceImaginary + m_size * batchSize, imaginary);
+            }
+        }
+
+    public:
+        Fft(unsigned int size = 1)
+            :m_size(0),
+            m_factors(),
+            m_twiddleReal(),
+            m_twiddleImaginary(),
+            m_rootReal(),
+            m_rootImaginary()
+        {
+            init(size);
+        }
+
+        void init(unsigned int size)
+        {
+            m_size = size;
+            m_factors.clear();
+            m_twiddleReal.clear();
+            m_twiddleImaginary.clear();
+            m_rootReal.clear();
+            m_rootImaginary.clear();
+
+            unsigned int rest = size;
+            const unsigned int preferred[] = {4, 2, 3, 5};
+
+            for (unsigned int radix : preferred)
+            {
+                while (rest % radix == 0 && rest > 1)
+                {
+                    m_factors.push_back(radix);
+                    rest /= radix;
+                }
+            }
+
+            for (unsigned int radix = 7; rest > 1; radix += 2)
+            {
+                while (rest % radix == 0)
+                {
+                    m_factors.push_back(radix);
+                    rest /= radix;
+                }
+            }
+
+            const double pi = std::acos(-1.0);
+            unsigned int length = size;
+
+            for (unsigned int radix : m_factors)
+            {
+                for (unsigned int q = 0; q < length / radix; ++q)
+                {
+                    for (unsigned int u = 0; u < radix; ++u)
+                    {
+                        double angle = -2.0 * pi * q * u / length;
+                        m_twiddleReal.push_back(std::cos(angle));
+                        m_twiddleImaginary.push_back(std::sin(angle));
+                    }
+                }
+
+                for (unsigned int t = 0; t < radix; ++t)
+                {
+                    double angle = -2.0 * pi * t / radix;
+                    m_rootReal.push_back(std::cos(angle));
+                    m_rootImaginary.push_back(std::sin(angle));
+                }
+
+                length /= radix;
+            }
+        }
+
+        unsigned int size() const
+        {
+            return m_size;
+        }
+
+        //in place, the scratch arrays hold as many values as the data; the inverse isn't divided by the size
+        void transform(DataType *real, DataType *imaginary, DataType *scratchReal, DataType *scratchImaginary,
+                       size_t batchSize, bool isInverse) const
+        {
+            if (isInverse)
+            {
+                stages<true>(real, imaginary, scratchReal, scratchImaginary, batchSize);
+            }
+            else
+            {
+                stages<false>(real, imaginary, scratchReal, scratchImaginary, batchSize);
+            }
+        }
+    };
+
+    // DFT of real sequences of an even size N through a complex one of N / 2:
+    // the even samples go in the real and the odd ones in the imaginary parts,
+    // z[n] = x[2n] + i x[2n + 1], and the two spectra are pulled apart again.
+    // Only X[0] to X[N / 2] are kept, the rest is their conjugate. Data is
+    // interleaved like Fft's and holds N / 2 + 1 values per sequence.
+    template<typename DataType>
+    class RealFft
+    {
+    private:
+        unsigned int m_size;
+        Fft<DataType> m_halfFft;
+        //e^(-2 pi i k / N) for k up to N / 4
+        std::vector<DataType> m_twiddleReal;
+        std::vector<DataType> m_twiddleImaginary;
+
+    public:
+        RealFft(unsigned int size = 2)
+            :m_size(0),
+            m_halfFft(),
+            m_twiddleReal(),
+            m_twiddleImaginary()
+        {
+            init(size);
+        }
+
+        void init(unsigned int size)
+        {
+            m_size = size;
+            m_halfFft.init(size / 2);
+            m_twiddleReal.clear();
+            m_twiddleImaginary.clear();
+
+            const double pi = std::acos(-1.0);
+
+            for (unsigned int k = 0; k <= size / 4; ++k)
+            {
+                double angle = -2.0 * pi * k / size;
+                m_twiddleReal.push_back(std::cos(angle));
+                m_twiddleImaginary.push_back(std::sin(angle));
+            }
+        }
+
+        unsigned int size() const
+        {
+            return m_size;
+        }
+
+        //the data holds z[0] to z[N / 2 - 1] and gets X[0] to X[N / 2]
+        void forward(DataType *real, DataType *imaginary, DataType *scratchReal, DataType *scratchImaginary, size_t batchSize) const
+        {
+            unsigned int half = m_size / 2;
+
+            m_halfFft.transform(real, imaginary, scratchReal, scratchImaginary, batchSize, false);
+
+            #pragma GCC ivdep
+            for (size_t r = 0; r < batchSize; ++r)
+            {
+                DataType z0Real = real[r];
+                DataType z0Imaginary = imaginary[r];
+
+                real[r] = z0Real + z0Imaginary;
+                imaginary[r] = 0;
+                real[r + batchSize * half] = z0Real - z0Imaginary;
+                imaginary[r + batchSize * half] = 0;
+            }
+
+            //X[k] = E + w^k O and X[N/2 - k] = conj(E - w^k O), with E and O the
+            //spectra of the even and odd samples
+            for (unsigned int k = 1; k <= half / 2; ++k)
+            {
+                DataType wReal = m_twiddleReal[k];
+                DataType wImaginary = m_twiddleImaginary[k];
+                DataType *lowReal = real + batchSize * k;
+                DataType *lowImaginary = imaginary + batchSize * k;
+                DataType *highReal = real + batchSize * (half - k);
+                DataType *highImaginary = imaginary + batchSize * (half - k);
+
+                #pragma GCC ivdep
+                for (size_t r = 0; r < batchSize; ++r)
+                {
+                    DataType evenReal = DataType(0.5) * (lowReal[r] + highReal[r]);
+                    DataType evenImaginary = DataType(0.5) * (lowImaginary[r] - highImaginary[r]);
+                    //O = -i (z[k] - conj(z[N/2 - k])) / 2
+                    DataType oddReal = DataType(0.5) * (lowImaginary[r] + highImaginary[r]);
+                    DataType oddImaginary = DataType(-0.5) * (lowReal[r] - highReal[r]);
+                    DataType twiddledReal = wReal * oddReal - wImaginary * oddImaginary;
+                    DataType twiddledImaginary = wReal * oddImaginary + wImaginary * oddReal;
+
+                    highReal[r] = evenReal - twiddledReal;
+                    highImaginary[r] = twiddledImaginary - evenImaginary;
+                    lowReal[r] = evenReal + twiddledReal;
+                    lowImaginary[r] = evenImaginary + twiddledImaginary;
+                }
+            }
+        }
+
+        //the reverse of forward, leaves N / 2 times z in the form forward takes
+        void inverse(DataType *real, DataType *imaginary, DataType *scratchReal, DataType *scratchImaginary, size_t batchSize) const
+        {
+            unsigned int half = m_size / 2;
+
+            for (unsigned int k = 0; k <= half / 2; ++k)
+            {
+                DataType wReal = m_twiddleReal[k];
+                DataType wImaginary = m_twiddleImaginary[k];
+                DataType *lowReal = real + batchSize * k;
+                DataType *lowImaginary = imaginary + batchSize * k;
+                DataType *highReal = real + batchSize * (half - k);
+                DataType *highImaginary = imaginary + batchSize * (half - k);
+                bool isPair = k != 0 && k != half - k;
+
+                #pragma GCC ivdep
+                for (size_t r = 0; r < batchSize; ++r)
+                {
+                    DataType evenReal = DataType(0.5) * (lowReal[r] + highReal[r]);
+                    DataType evenImaginary = DataType(0.5) * (lowImaginary[r] - highImaginary[r]);
+                    DataType differenceReal = DataType(0.5) * (lowReal[r] - highReal[r]);
+                    DataType differenceImaginary = DataType(0.5) * (lowImaginary[r] + highImaginary[r]);
+                    //z[k] = E + i conj(w^k) D and z[N/2 - k] = conj(E) + i w^k conj(D)
+                    DataType a = wReal * differenceReal + wImaginary * differenceImaginary;
+                    DataType b = wReal * differenceImaginary - wImaginary * differenceReal;
+
+                    if (isPair)
+                    {
+                        highReal[r] = evenReal + b;
+                        highImaginary[r] = a - evenImaginary;
+                    }
+
+                    lowReal[r] = evenReal - b;
+                    lowImaginary[r] = evenImaginary + a;
+                }
+            }
+
+            m_halfFft.transform(real, imaginary, scratchReal, scratchImaginary, batchSize, true);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,377 @@
+#ifndef FFTCONVOLUTION_H
+#define FFTCONVOLUTION_H
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include "Fft.h"
+#include "Gemm.h"
+#include "../Context/Context.h"
+
+namespace FreeWill
+{
+    // A stride 1 convolution of NHWC tensors in the frequency domain, by
+    // overlap-save over T x T tiles: the circular correlation of a tile with a
+    // filter padded to T x T is right for the first T - L + 1 outputs of each
+    // row and column. Per frequency the channels are summed by gemm,
+    // Y (tiles x filters) = X (tiles x channels) * conj(F) (channels x filters),
+    // as four real products of the real and imaginary parts.
+    //
+    // A block of tiles is transformed as one batch, laid out
+    // [row][column][tile][channel], so the spectrum comes out as one
+    // tiles x channels matrix per frequency, ready for gemm. The filter
+    // transform is kept until the filter or the tile size changes, which is
+    // checked against a copy of the filter it was made from.
+    template<typename DataType>
+    class FftConvolution
+    {
+    private:
+        unsigned int m_tileSize;
+        unsigned int m_filterSize;
+        unsigned int m_inputChannelCount;
+        unsigned int m_outputChannelCount;
+        std::vector<DataType> m_filter;
+        //real, imaginary and negated imaginary parts of F, each [frequency][input channel][output channel]
+        std::vector<DataType> m_transformedFilter;
+        RealFft<DataType> m_rowFft;
+        Fft<DataType> m_columnFft;
+
+        //sizes the real FFT can take cheaply: even, with no prime factor above 5
+        static bool isSmooth(unsigned int size)
+        {
+            if (size % 2)
+            {
+                return false;
+            }
+
+            const unsigned int primes[] = {2, 3, 5};
+
+            for (unsigned int prime : primes)
+            {
+                while (size % prime == 0)
+                {
+                    size /= prime;
+                }
+            }
+
+            return size == 1;
+        }
+
+        //the T x T block of a [y][x][channel] image from (startX, startY), zero outside, as
+        //sequence sequenceIndex of sequenceCount, packed two columns per value as RealFft takes it
+        void loadTile(const DataType *image, unsigned int width, unsigned int height, unsigned int channelCount,
+                      int startX, int startY, unsigned int sequenceIndex, unsigned int sequenceCount,
+                      DataType *real, DataType *imaginary) const
+        {
+            unsigned int half = m_tileSize / 2;
+            size_t columnLength = (size_t) sequenceCount * channelCount;
+            size_t rowLength = (half + 1) * columnLength;
+
+            for (unsigned int y = 0; y < m_tileSize; ++y)
+            {
+                int realY = startY + (int) y;
+
+                for (unsigned int n = 0; n < half; ++n)
+                {
+                    int evenX = startX + (int) (2 * n);
+                    int oddX = evenX + 1;
+                    bool isInside = realY >= 0 && realY < (int) height;
+                    const DataType *even = (isInside && evenX >= 0 && evenX < (int) width) ? image + (realY * width + evenX) * channelCount : nullptr;
+                    const DataType *odd = (isInside && oddX >= 0 && oddX < (int) width) ? image + (realY * width + oddX) * channelCount : nullptr;
+                    size_t destination = y * rowLength + n * columnLength + (size_t) sequenceIndex * channelCount;
+
+                    if (even)
+                    {
+                        std::copy(even, even + channelCount, real + destination);
+                    }
+                    else
+                    {
+                        std::fill(real + destination, real + destination + channelCount, DataType(0));
+                    }
+
+                    if (odd)
+                    {
+                        std::copy(odd, odd + channelCount, imaginary + destination);
+                    }
+                    else
+                    {
+                        std::fill(imaginary + destination, imaginary + destination + channelCount, DataType(0));
+                    }
+                }
+            }
+        }
+
+        //rows by the real FFT, then the columns, batchSize values side by side
+        void forwardTransform(DataType *real, DataType *imaginary, DataType *scratchReal, DataType *scratchImaginary, size_t batchSize) const
+        {
+            size_t rowLength = (m_tileSize / 2 + 1) * batchSize;
+
+            for (unsigned int y = 0; y < m_tileSize; ++y)
+            {
+                m_rowFft.forward(real + y * rowLength, imaginary + y * rowLength, scratchReal, scratchImaginary, batchSize);
+            }
+
+            m_columnFft.transform(real, imaginary, scratchReal, scratchImaginary, rowLength, false);
+        }
+
+        void inverseTransform(DataType *real, DataType *imaginary, DataType *scratchReal, DataType *scratchImaginary, size_t batchSize) const
+        {
+            size_t rowLength = (m_tileSize / 2 + 1) * batchSize;
+
+            m_columnFft.transform(real, imaginary, scratchReal, scratchImaginary, rowLength, true);
+
+            for (unsigned int y = 0; y < m_tileSize; ++y)
+            {
+                m_rowFft.inverse(real + y * rowLength, imaginary + y * rowLength, scratchReal, scratchImaginary, batchSize);
+            }
+        }
+
+        void transformFilter(const DataType *featureMap)
+        {
+            unsigned int channelCount = m_inputChannelCount;
+            unsigned int featureMapCount = m_outputChannelCount;
+            unsigned int frequencyCount = m_tileSize * (m_tileSize / 2 + 1);
+            size_t planeSize = (size_t) frequencyCount * channelCount * featureMapCount;
+            size_t spectrumSize = (size_t) frequencyCount * channelCount;
+
+            m_transformedFilter.resize(3 * planeSize);
+
+            DataType *filterReal = m_transformedFilter.data();
+            DataType *filterImaginary = filterReal + planeSize;
+            DataType *filterNegatedImaginary = filterImaginary + planeSize;
+
+            DataType *real = gemmWorkspace<DataType>(4 * spectrumSize);
+            DataType *imaginary = real + spectrumSize;
+            DataType *scratchReal = imaginary + spectrumSize;
+            DataType *scratchImaginary = scratchReal + spectrumSize;
+
+            //the inverse transforms leave T x T / 2 times the result
+            DataType scale = DataType(1) / (m_tileSize * (m_tileSize / 2));
+
+            for (unsigned int k = 0; k < featureMapCount; ++k)
+            {
+                loadTile(featureMap + (size_t) k * m_filterSize * m_filterSize * channelCount, m_filterSize, m_filterSize, channelCount,
+                         0, 0, 0, 1, real, imaginary);
+                forwardTransform(real, imaginary, scratchReal, scratchImaginary, channelCount);
+
+                for (size_t i = 0; i < spectrumSize; ++i)
+                {
+                    filterReal[i * featureMapCount + k] = scale * real[i];
+                    filterImaginary[i * featureMapCount + k] = scale * imaginary[i];
+                    filterNegatedImaginary[i * featureMapCount + k] = -scale * imaginary[i];
+                }
+            }
+        }
+
+    public:
+        FftConvolution()
+            :m_tileSize(0),
+            m_filterSize(0),
+            m_inputChannelCount(0),
+            m_outputChannelCount(0),
+            m_filter(),
+            m_transformedFilter(),
+            m_rowFft(),
+            m_columnFft()
+        {
+        }
+
+        static bool isSupported(unsigned int filterSize, unsigned int strideX, unsigned int strideY)
+        {
+            return filterSize > 1 && strideX == 1 && strideY == 1;
+        }
+
+        //tiles whose spectra, products and FFT scratch fit 2MB of L2 together
+        static unsigned int tilesPerBlock(unsigned int tileSize, unsigned int channelCount, unsigned int featureMapCount)
+        {
+            size_t frequencyCount = tileSize * (tileSize / 2 + 1);
+            size_t tileBytes = 2 * frequencyCount * (channelCount + featureMapCount + std::max(channelCount, featureMapCount)) * sizeof(DataType);
+
+            return std::max((size_t) 1, (2048 * 1024) / tileBytes);
+        }
+
+        //the tile side with the fewest frequencies per output, among those that leave a block
+        //of 8 tiles for the gemms to share the filter spectrum between
+        static unsigned int tileSize(unsigned int filterSize, unsigned int channelCount, unsigned int featureMapCount,
+                                     unsigned int newWidth, unsigned int newHeight)
+        {
+            unsigned int best = 0;
+            double bestCost = 0;
+
+            for (unsigned int size = filterSize + 1; size <= std::max(64u, 2 * filterSize); ++size)
+            {
+                if (!isSmooth(size))
+                {
+                    continue;
+                }
+
+                if (best != 0 && tilesPerBlock(size, channelCount, featureMapCount) < 8)
+                {
+                    break;
+                }
+
+                unsigned int outputSize = size - filterSize + 1;
+                double tileCount = (double) ((newWidth + outputSize - 1) / outputSize) * ((newHeight + outputSize - 1) / outputSize);
+                double cost = tileCount * size * (size / 2 + 1);
+
+                if (best == 0 || cost < bestCost)
+                {
+                    best = size;
+                    bestCost = cost;
+                }
+            }
+
+            return best;
+        }
+
+        //featureMap is {channelCount, filterSize, filterSize, featureMapCount}, the tiles
+        //are sized for an output of newWidth x newHeight
+        void setFilter(const DataType *featureMap, unsigned int channelCount, unsigned int filterSize, unsigned int featureMapCount,
+                       unsigned int newWidth, unsigned int newHeight)
+        {
+            unsigned int size = tileSize(filterSize, channelCount, featureMapCount, newWidth, newHeight);
+            size_t filterLength = (size_t) channelCount * filterSize * filterSize * featureMapCount;
+
+            if (size == m_tileSize && filterSize == m_filterSize && channelCount == m_inputChannelCount &&
+                    m_filter.size() == filterLength &&
+                    std::memcmp(m_filter.data(), featureMap, filterLength * sizeof(DataType)) == 0)
+            {
+                return;
+            }
+
+            if (size != m_tileSize)
+            {
+                m_rowFft.init(size);
+                m_columnFft.init(size);
+            }
+
+            m_tileSize = size;
+            m_filterSize = filterSize;
+            m_inputChannelCount = channelCount;
+            m_outputChannelCount = featureMapCount;
+            m_filter.assign(featureMap, featureMap + filterLength);
+
+            transformFilter(featureMap);
+        }
+
+        //output += the convolution of input with the filter (+ bias), both NHWC
+        void evaluate(const DataType *input, unsigned int width, unsigned int height, unsigned int batchSize,
+                      unsigned int zeroPaddingX, unsigned int zeroPaddingY,
+                      DataType *output, unsigned int newWidth, unsigned int newHeight, const DataType *bias = nullptr)
+        {
+            unsigned int inputChannelCount = m_inputChannelCount;
+            unsigned int outputChannelCount = m_outputChannelCount;
+            unsigned int half = m_tileSize / 2;
+            unsigned int frequencyCount = m_tileSize * (half + 1);
+            unsigned int outputTileSize = m_tileSize - m_filterSize + 1;
+
+            unsigned int tileCountX = (newWidth + outputTileSize - 1) / outputTileSize;
+            unsigned int tileCountY = (newHeight + outputTileSize - 1) / outputTileSize;
+            unsigned int tileCount = batchSize * tileCountX * tileCountY;
+
+            unsigned int channelCount = std::max(inputChannelCount, outputChannelCount);
+            unsigned int blockTiles = std::min(tilesPerBlock(m_tileSize, inputChannelCount, outputChannelCount), tileCount);
+            unsigned int blockCount = (tileCount + blockTiles - 1) / blockTiles;
+
+            size_t filterPlaneSize = (size_t) frequencyCount * inputChannelCount * outputChannelCount;
+            const DataType *filterReal = m_transformedFilter.data();
+            const DataType *filterImaginary = filterReal + filterPlaneSize;
+            const DataType *filterNegatedImaginary = filterImaginary + filterPlaneSize;
+
+            Context<DeviceType::CPU_NAIVE>::getSingleton().parallelFor(0, blockCount, [&](unsigned int blockBegin, unsigned int blockEnd)
+            {
+                size_t inputPlaneSize = (size_t) frequencyCount * blockTiles * inputChannelCount;
+                size_t outputPlaneSize = (size_t) frequencyCount * blockTiles * outputChannelCount;
+                size_t scratchPlaneSize = (size_t) frequencyCount * blockTiles * channelCount;
+
+                DataType *inputReal = gemmWorkspace<DataType>(2 * inputPlaneSize + 2 * outputPlaneSize + 2 * scratchPlaneSize);
+                DataType *inputImaginary = inputReal + inputPlaneSize;
+                DataType *outputReal = inputImaginary + inputPlaneSize;
+                DataType *outputImaginary = outputReal + outputPlaneSize;
+                DataType *scratchReal = outputImaginary + outputPlaneSize;
+                DataType *scratchImaginary = scratchReal + scratchPlaneSize;
+
+                for (unsigned int block = blockBegin; block < blockEnd; ++block)
+                {
+                    unsigned int tileBegin = block * blockTiles;
+                    unsigned int tileEnd = std::min(tileCount, tileBegin + blockTiles);
+                    unsigned int blockTileCount = tileEnd - tileBegin;
+
+                    for (unsigned int t = tileBegin; t < tileEnd; ++t)
+                    {
+                        unsigned int b = t / (tileCountX * tileCountY);
+                        int startY = (int) (((t / tileCountX) % tileCountY) * outputTileSize) - (int) zeroPaddingY;
+                        int startX = (int) ((t % tileCountX) * outputTileSize) - (int) zeroPaddingX;
+
+                        loadTile(input + (size_t) b * width * height * inputChannelCount, width, height, inputChannelCount,
+                                 startX, startY, t - tileBegin, blockTileCount, inputReal, inputImaginary);
+                    }
+
+                    forwardTransform(inputReal, inputImaginary, scratchReal, scratchImaginary, (size_t) blockTileCount * inputChannelCount);
+
+                    //Re Y = Re X Re F + Im X Im F, Im Y = Im X Re F - Re X Im F
+                    for (unsigned int f = 0; f < frequencyCount; ++f)
+                    {
+                        size_t inputOffset = (size_t) f * blockTileCount * inputChannelCount;
+                        size_t filterOffset = (size_t) f * inputChannelCount * outputChannelCount;
+                        size_t outputOffset = (size_t) f * blockTileCount * outputChannelCount;
+
+                        gemm<DataType>(blockTileCount, outputChannelCount, inputChannelCount,
+                                       inputReal + inputOffset, inputChannelCount, 1,
+                                       filterReal + filterOffset, outputChannelCount, 1,
+                                       outputReal + outputOffset, outputChannelCount);
+                        gemm<DataType>(blockTileCount, outputChannelCount, inputChannelCount,
+                                       inputImaginary + inputOffset, inputChannelCount, 1,
+                                       filterImaginary + filterOffset, outputChannelCount, 1,
+                                       outputReal + outputOffset, outputChannelCount, true);
+                        gemm<DataType>(blockTileCount, outputChannelCount, inputChannelCount,
+                                       inputImaginary + inputOffset, inputChannelCount, 1,
+                                       filterReal + filterOffset, outputChannelCount, 1,
+                                       outputImaginary + outputOffset, outputChannelCount);
+                        gemm<DataType>(blockTileCount, outputChannelCount, inputChannelCount,
+                                       inputReal + inputOffset, inputChannelCount, 1,
+                                       filterNegatedImaginary + filterOffset, outputChannelCount, 1,
+                                       outputImaginary + outputOffset, outputChannelCount, true);
+                    }
+
+                    inverseTransform(outputReal, outputImaginary, scratchReal, scratchImaginary, (size_t) blockTileCount * outputChannelCount);
+
+                    //the first T - L + 1 rows and columns of each tile are added to the output,
+                    //even columns are in the real and odd ones in the imaginary parts
+                    for (unsigned int t = tileBegin; t < tileEnd; ++t)
+                    {
+                        unsigned int b = t / (tileCountX * tileCountY);
+                        unsigned int startY = ((t / tileCountX) % tileCountY) * outputTileSize;
+                        unsigned int startX = (t % tileCountX) * outputTileSize;
+
+                        for (unsigned int i = 0; i < outputTileSize && startY + i < newHeight; ++i)
+                        {
+                            for (unsigned int j = 0; j < outputTileSize && startX + j < newWidth; ++j)
+                            {
+                                DataType *destination = output + ((b * newHeight + startY + i) * newWidth + startX + j) * outputChannelCount;
+                                const DataType *source = ((j % 2) ? outputImaginary : outputReal) +
+                                        (((size_t) i * (half + 1) + j / 2) * blockTileCount + (t - tileBegin)) * outputChannelCount;
+
+                                for (unsigned int k = 0; k < outputChannelCount; ++k)
+                                {
+                                    destination[k] += source[k];
+                                }
+
+                                if (bias)
+                                {
+                                    for (unsigned int k = 0; k < outputChannelCount; ++k)
+                                    {
+                                        destination[k] += bias[k];
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            });
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include "Gemm.h"
+#include "GemmKernel.h"
+#include <atomic>
+
+namespace FreeWill
+{
+    //GemmAVX2.cpp and GemmAVX512.cpp
+    void gemmAVX2(unsigned int m, unsigned int n, unsigned int k,
+                  const float *a, size_t aRowStride, size_t aColumnStride,
+                  const float *b, size_t bRowStride, size_t bColumnStride,
+                  float *c, size_t ldc, bool accumulate, const float *bias);
+    void gemmAVX2(unsigned int m, unsigned int n, unsigned int k,
+                  const double *a, size_t aRowStride, size_t aColumnStride,
+                  const double *b, size_t bRowStride, size_t bColumnStride,
+                  double *c, size_t ldc, bool accumulate, const double *bias);
+    void gemmAVX512(unsigned int m, unsigned int n, unsigned int k,
+                    const float *a, size_t aRowStride, size_t aColumnStride,
+                    const float *b, size_t bRowStride, size_t bColumnStride,
+                    float *c, size_t ldc, bool accumulate, const float *bias);
+    void gemmAVX512(unsigned int m, unsigned int n, unsigned int k,
+                    const double *a, size_t aRowStride, size_t aColumnStride,
+                    const double *b, size_t bRowStride, size_t bColumnStride,
+                    double *c, size_t ldc, bool accumulate, const double *bias);
+
+    namespace
+    {
+        template<typename DataType>
+        struct Portable
+        {
+            typedef DataType Vector;
+            static const unsigned int Width = 1;
+
+            static Vector zero() { return DataType(0); }
+            static Vector load(const DataType *source) { return *source; }
+            static void store(DataType *destination, Vector value) { *destination = value; }
+            static Vector broadcast(DataType value) { return value; }
+            static Vector add(Vector a, Vector b) { return a + b; }
+            static Vector fmadd(Vector a, Vector b, Vector c) { return a * b + c; }
+        };
+
+        bool isSupported(GemmKernel kernel)
+        {
+            switch (kernel)
+            {
+            case GemmKernel::AVX512:
+                return __builtin_cpu_supports("avx512f");
+            case GemmKernel::AVX2:
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            default:
+                return true;
+            }
+        }
+
+        GemmKernel bestKernel()
+        {
+            if (isSupported(GemmKernel::AVX512))
+            {
+                return GemmKernel::AVX512;
+            }
+            else if (isSupported(GemmKernel::AVX2))
+            {
+                return GemmKernel::AVX2;
+            }
+
+            return GemmKernel::PORTABLE;
+        }
+
+        std::atomic<GemmKernel> &currentKernel()
+        {
+            static std::atomic<GemmKernel> kernel(bestKernel());
+            return kernel;
+        }
+    }
+}
+
+FreeWill::GemmKernel FreeWill::gemmKernel()
+{
+    return currentKernel().load(std::memory_order_relaxed);
+}
+
+bool FreeWill::setGemmKernel(FreeWill::GemmKernel kernel)
+{
+    if (!isSupported(kernel))
+    {
+        return false;
+    }
+
+    currentKernel().store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+template<typename DataType>
+void FreeWill::gemm(unsigned int m, unsigned int n, unsigned int k,
+                    const DataType *a, size_t aRowStride, size_t aColumnStride,
+                    const DataType *b, size_t bRowStride, size_t bColumnStride,
+                    DataType *c, size_t ldc, bool accumulate, const DataType *bias)
+{
+    if (m == 0 || n == 0)
+    {
+        return;
+    }
+
+    switch (gemmKernel())
+    {
+    case GemmKernel::AVX512:
+        gemmAVX512(m, n, k, a, aRowStride, aColumnStride, b, bRowStride, bColumnStride, c, ldc, accumulate, bias);
+        break;
+    case GemmKernel::AVX2:
+        gemmAVX2(m, n, k, a, aRowStride, aColumnStride, b, bRowStride, bColumnStride, c, ldc, accumulate, bias);
+        break;
+    case GemmKernel::PORTABLE:
+        blockedGemm<DataType, Portable<DataType>, 4, 4>(m, n, k, a, aRowStride, aColumnStride, b, bRowStride, bColumnStride, c, ldc, accumulate, bias);
+        break;
+    }
+}
+
+template void FreeWill::gemm<float>(unsigned int m, unsigned int n, unsigned int k,
+                                    const float *a, size_t aRowStride, size_t aColumnStride,
+                                    const float *b, size_t bRowStride, size_t bColumnStride,
+                                    float *c, size_t ldc, bool accumulate, const float *bias);
+template void FreeWill::gemm<double>(unsigned int m, unsigned int n, unsigned int k,
+                                     const double *a, size_t aRowStride, size_t aColumnStride,
+                                     const double *b, size_t bRowStride, size_t bColumnStride,
+                                     double *c, size_t ldc, bool accumulate, const double *bias);
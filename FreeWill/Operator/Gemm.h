@@ -0,0 +1,92 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+#include "../Context/Context.h"
+
+namespace FreeWill
+{
+    // C (m x n, rows ldc apart) = A (m x k) * B (k x n) for float and double.
+    // A and B are given by their row and column strides, so a transposed
+    // operand only swaps them. With accumulate the product is added to C,
+    // bias (n values) is added to every row of C.
+    //
+    // Both operands are packed into panels that stay in L1/L2, C is updated
+    // by a register blocked microkernel for the best instruction set of the
+    // CPU (AVX-512, AVX2 with FMA, or portable C++).
+    template<typename DataType>
+    void gemm(unsigned int m, unsigned int n, unsigned int k,
+              const DataType *a, size_t aRowStride, size_t aColumnStride,
+              const DataType *b, size_t bRowStride, size_t bColumnStride,
+              DataType *c, size_t ldc, bool accumulate = false, const DataType *bias = nullptr);
+
+    enum class GemmKernel
+    {
+        PORTABLE,
+        AVX2,
+        AVX512
+    };
+
+    GemmKernel gemmKernel();
+
+    //e.g. to compare the kernels, false if the CPU can't run the one asked for
+    bool setGemmKernel(GemmKernel kernel);
+
+    //scratch for the operands a caller lowers or transforms before gemm, one
+    //per thread and type, grows and is reused by every call
+    template<typename DataType>
+    DataType *gemmWorkspace(size_t size)
+    {
+        static thread_local std::vector<DataType> workspace;
+
+        if (workspace.size() < size)
+        {
+            workspace.resize(size);
+        }
+
+        return workspace.data();
+    }
+
+    //gemm on blocks of C, spread over the CPU context's workers
+    template<typename DataType>
+    void parallelGemm(unsigned int m, unsigned int n, unsigned int k,
+                      const DataType *a, size_t aRowStride, size_t aColumnStride,
+                      const DataType *b, size_t bRowStride, size_t bColumnStride,
+                      DataType *c, size_t ldc, bool accumulate = false, const DataType *bias = nullptr)
+    {
+        //multiples of every kernel's register block
+        const unsigned int rowBlock = 96;
+        const unsigned int columnBlock = 64;
+
+        unsigned int workerCount = std::max(1u, (unsigned int) Context<DeviceType::CPU_NAIVE>::getSingleton().deviceCount());
+        unsigned int rowBlockCount = (m + rowBlock - 1) / rowBlock;
+
+        //wide blocks keep the packing overhead down, but every worker should get one
+        unsigned int columnBlockCount = std::max(1u, std::min((n + columnBlock - 1) / columnBlock,
+                                                              (workerCount + rowBlockCount - 1) / rowBlockCount));
+        unsigned int columnsPerBlock = ((n + columnBlockCount - 1) / columnBlockCount + columnBlock - 1) / columnBlock * columnBlock;
+
+        Context<DeviceType::CPU_NAIVE>::getSingleton().parallelFor(0, rowBlockCount * columnBlockCount, [&](unsigned int blockBegin, unsigned int blockEnd)
+        {
+            for (unsigned int block = blockBegin; block < blockEnd; ++block)
+            {
+                unsigned int row = (block / columnBlockCount) * rowBlock;
+                unsigned int column = (block % columnBlockCount) * columnsPerBlock;
+
+                if (column >= n)
+                {
+                    continue;
+                }
+
+                gemm(std::min(rowBlock, m - row), std::min(columnsPerBlock, n - column), k,
+                     a + row * aRowStride, aRowStride, aColumnStride,
+                     b + column * bColumnStride, bRowStride, bColumnStride,
+                     c + row * ldc + column, ldc, accumulate, bias ? bias + column : nullptr);
+            }
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,52 @@
+//built with -mavx2 -mfma, only called after the CPU was checked
+#include "GemmKernel.h"
+#include <immintrin.h>
+
+namespace FreeWill
+{
+    namespace
+    {
+        struct FloatAVX2
+        {
+            typedef __m256 Vector;
+            static const unsigned int Width = 8;
+
+            static Vector zero() { return _mm256_setzero_ps(); }
+            static Vector load(const float *source) { return _mm256_loadu_ps(source); }
+            static void store(float *destination, Vector value) { _mm256_storeu_ps(destination, value); }
+            static Vector broadcast(float value) { return _mm256_set1_ps(value); }
+            static Vector add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+            static Vector fmadd(Vector a, Vector b, Vector c) { return _mm256_fmadd_ps(a, b, c); }
+        };
+
+        struct DoubleAVX2
+        {
+            typedef __m256d Vector;
+            static const unsigned int Width = 4;
+
+            static Vector zero() { return _mm256_setzero_pd(); }
+            static Vector load(const double *source) { return _mm256_loadu_pd(source); }
+            static void store(double *destination, Vector value) { _mm256_storeu_pd(destination, value); }
+            static Vector broadcast(double value) { return _mm256_set1_pd(value); }
+            static Vector add(Vector a, Vector b) { return _mm256_add_pd(a, b); }
+            static Vector fmadd(Vector a, Vector b, Vector c) { return _mm256_fmadd_pd(a, b, c); }
+        };
+    }
+
+    //6 x 16 floats and 6 x 8 doubles take 12 of the 16 registers
+    void gemmAVX2(unsigned int m, unsigned int n, unsigned int k,
+                  const float *a, size_t aRowStride, size_t aColumnStride,
+                  const float *b, size_t bRowStride, size_t bColumnStride,
+                  float *c, size_t ldc, bool accumulate, const float *bias)
+    {
+        blockedGemm<float, FloatAVX2, 6, 16>(m, n, k, a, aRowStride, aColumnStride, b, bRowStride, bColumnStride, c, ldc, accumulate, bias);
+    }
+
+    void gemmAVX2(unsigned int m, unsigned int n, unsigned int k,
+                  const double *a, size_t aRowStride, size_t aColumnStride,
+                  const double *b, size_t bRowStride, size_t bColumnStride,
+                  double *c, size_t ldc, bool accumulate, const double *bias)
+    {
+        blockedGemm<double, DoubleAVX2, 6, 8>(m, n, k, a, aRowStride, aColumnStride, b, bRowStride, bColumnStride, c, ldc, accumulate, bias);
+    }
+}
@@ -0,0 +1,52 @@
+//built with -mavx512f, only called after the CPU was checked
+#include "GemmKernel.h"
+#include <immintrin.h>
+
+namespace FreeWill
+{
+    namespace
+    {
+        struct FloatAVX512
+        {
+            typedef __m512 Vector;
+            static const unsigned int Width = 16;
+
+            static Vector zero() { return _mm512_setzero_ps(); }
+            static Vector load(const float *source) { return _mm512_loadu_ps(source); }
+            static void store(float *destination, Vector value) { _mm512_storeu_ps(destination, value); }
+            static Vector broadcast(float value) { return _mm512_set1_ps(value); }
+            static Vector add(Vector a, Vector b) { return _mm512_add_ps(a, b); }
+            static Vector fmadd(Vector a, Vector b, Vector c) { return _mm512_fmadd_ps(a, b, c); }
+        };
+
+        struct DoubleAVX512
+        {
+            typedef __m512d Vector;
+            static const unsigned int Width = 8;
+
+            static Vector zero() { return _mm512_setzero_pd(); }
+            static Vector load(const double *source) { return _mm512_loadu_pd(source); }
+            static void store(double *destination, Vector value) { _mm512_storeu_pd(destination, value); }
+            static Vector broadcast(double value) { return _mm512_set1_pd(value); }
+            static Vector add(Vector a, Vector b) { return _mm512_add_pd(a, b); }
+            static Vector fmadd(Vector a, Vector b, Vector c) { return _mm512_fmadd_pd(a, b, c); }
+        };
+    }
+
+    //12 x 32 floats and 12 x 16 doubles take 24 of the 32 registers
+    void gemmAVX512(unsigned int m, unsigned int n, unsigned int k,
+                    const float *a, size_t aRowStride, size_t aColumnStride,
+                    const float *b, size_t bRowStride, size_t bColumnStride,
+                    float *c, size_t ldc, bool accumulate, const float *bias)
+    {
+        blockedGemm<float, FloatAVX512, 12, 32>(m, n, k, a, aRowStride, aColumnStride, b, bRowStride, bColumnStride, c, ldc, accumulate, bias);
+    }
+
+    void gemmAVX512(unsigned int m, unsigned int n, unsigned int k,
+                    const double *a, size_t aRowStride, size_t aColumnStride,
+                    const double *b, size_t bRowStride, size_t bColumnStride,
+                    double *c, size_t ldc, bool accumulate, const double *bias)
+    {
+        blockedGemm<double, DoubleAVX512, 12, 16>(m, n, k, a, aRowStride, aColumnStride, b, bRowStride, bColumnStride, c, ldc, accumulate, bias);
+    }
+}
@@ -0,0 +1,398 @@
+#ifndef GEMMKERNEL_H
+#define GEMMKERNEL_H
+
+#include <cstddef>
+#include <cstdlib>
+
+// The blocked gemm driver, included by Gemm.cpp and by the sources compiled
+// for one instruction set each. Everything here has internal linkage and uses
+// no library templates, so no code built for AVX can leak into a baseline
+// caller through the linker picking one copy of an inline function.
+//
+// A Simd type provides Vector, Width and zero/load/store/broadcast/add/fmadd.
+// The loops follow the usual order: NC columns of B stay in L3, a KC x NC
+// block of B is packed for L2, an MC x KC block of A is packed for L1 and
+// the microkernel keeps an MR x NR block of C in registers.
+
+namespace FreeWill
+{
+    namespace
+    {
+        const unsigned int GemmKC = 256;
+        const unsigned int GemmMC = 96;
+        const unsigned int GemmNC = 2048;
+        //up to this many rows of A take streamingGemm
+        const unsigned int GemmStreamRows = 4;
+
+        inline unsigned int gemmMin(unsigned int a, unsigned int b)
+        {
+            return a < b ? a : b;
+        }
+
+        //one per thread and buffer, grows and is reused by every call
+        class GemmBuffer
+        {
+        private:
+            void *m_data;
+            size_t m_sizeInByte;
+
+        public:
+            GemmBuffer()
+                :m_data(nullptr),
+                  m_sizeInByte(0)
+            {}
+
+            GemmBuffer(const GemmBuffer &) = delete;
+            GemmBuffer &operator=(const GemmBuffer &) = delete;
+
+            ~GemmBuffer()
+            {
+                std::free(m_data);
+            }
+
+            void *reserve(size_t sizeInByte)
+            {
+                if (sizeInByte > m_sizeInByte)
+                {
+                    std::free(m_data);
+                    m_sizeInByte = (sizeInByte + 63) / 64 * 64;
+                    m_data = std::aligned_alloc(64, m_sizeInByte);
+                }
+
+                return m_data;
+            }
+        };
+
+        //MR rows at a time, each panel column after column, missing rows are zero
+        template<typename DataType, unsigned int MR>
+        void packA(unsigned int mc, unsigned int kc, const DataType *a, size_t aRowStride, size_t aColumnStride, DataType *packed)
+        {
+            for (unsigned int ir = 0; ir < mc; ir += MR)
+            {
+                unsigned int mr = gemmMin(MR, mc - ir);
+
+                for (unsigned int p = 0; p < kc; ++p)
+                {
+                    for (unsigned int i = 0; i < MR; ++i)
+                    {
+                        packed[p * MR + i] = i < mr ? a[(ir + i) * aRowStride + p * aColumnStride] : DataType(0);
+                    }
+                }
+
+                packed += kc * MR;
+            }
+        }
+
+        //NR columns at a time, each panel row after row, missing columns are zero
+        template<typename DataType, unsigned int NR>
+        void packB(unsigned int kc, unsigned int nc, const DataType *b, size_t bRowStride, size_t bColumnStride, DataType *packed)
+        {
+            for (unsigned int jr = 0; jr < nc; jr += NR)
+            {
+                unsigned int nr = gemmMin(NR, nc - jr);
+
+                for (unsigned int p = 0; p < kc; ++p)
+                {
+                    for (unsigned int j = 0; j < NR; ++j)
+                    {
+                        packed[p * NR + j] = j < nr ? b[p * bRowStride + (jr + j) * bColumnStride] : DataType(0);
+                    }
+                }
+
+                packed += kc * NR;
+            }
+        }
+
+        //C[Rows x nr] (+)= initial + A panel * B panel, B rows are bRowStride apart.
+        //Rows is the real height of the A panel, padded rows aren't computed
+        template<typename DataType, typename Simd, unsigned int MR, unsigned int NR, unsigned int Rows>
+        void microKernel(unsigned int kc, const DataType *a, const DataType *b, size_t bRowStride,
+                         DataType *c, size_t ldc, unsigned int nr, bool addToC, const DataType *initial)
+        {
+            const unsigned int V = NR / Simd::Width;
+            typename Simd::Vector accumulator[Rows][V];
+
+            DataType paddedInitial[NR];
+            if (initial && nr < NR)
+            {
+                for (unsigned int j = 0; j < NR; ++j)
+                {
+                    paddedInitial[j] = j < nr ? initial[j] : DataType(0);
+                }
+                initial = paddedInitial;
+            }
+
+            #pragma GCC unroll 32
+            for (unsigned int v = 0; v < V; ++v)
+            {
+                typename Simd::Vector start = initial ? Simd::load(initial + v * Simd::Width) : Simd::zero();
+
+                #pragma GCC unroll 32
+                for (unsigned int i = 0; i < Rows; ++i)
+                {
+                    accumulator[i][v] = start;
+                }
+            }
+
+            for (unsigned int p = 0; p < kc; ++p)
+            {
+                typename Simd::Vector row[V];
+
+                #pragma GCC unroll 32
+                for (unsigned int v = 0; v < V; ++v)
+                {
+                    row[v] = Simd::load(b + p * bRowStride + v * Simd::Width);
+                }
+
+                #pragma GCC unroll 32
+                for (unsigned int i = 0; i < Rows; ++i)
+                {
+                    typename Simd::Vector column = Simd::broadcast(a[p * MR + i]);
+
+                    #pragma GCC unroll 32
+                    for (unsigned int v = 0; v < V; ++v)
+                    {
+                        accumulator[i][v] = Simd::fmadd(column, row[v], accumulator[i][v]);
+                    }
+                }
+            }
+
+            if (nr == NR)
+            {
+                #pragma GCC unroll 32
+                for (unsigned int i = 0; i < Rows; ++i)
+                {
+                    #pragma GCC unroll 32
+                    for (unsigned int v = 0; v < V; ++v)
+                    {
+                        DataType *destination = c + i * ldc + v * Simd::Width;
+                        Simd::store(destination, addToC ? Simd::add(Simd::load(destination), accumulator[i][v]) : accumulator[i][v]);
+                    }
+                }
+            }
+            else
+            {
+                DataType result[Rows * NR];
+
+                #pragma GCC unroll 32
+                for (unsigned int i = 0; i < Rows; ++i)
+                {
+                    #pragma GCC unroll 32
+                    for (unsigned int v = 0; v < V; ++v)
+                    {
+                        Simd::store(result + i * NR + v * Simd::Width, accumulator[i][v]);
+                    }
+                }
+
+                for (unsigned int i = 0; i < Rows; ++i)
+                {
+                    for (unsigned int j = 0; j < nr; ++j)
+                    {
+                        c[i * ldc + j] = (addToC ? c[i * ldc + j] : DataType(0)) + result[i * NR + j];
+                    }
+                }
+            }
+        }
+
+        //picks the kernel for the mr rows left, a batch of 2 shouldn't pay for MR
+        template<typename DataType, typename Simd, unsigned int MR, unsigned int NR, unsigned int Rows = MR>
+        void microKernelForRows(unsigned int mr, unsigned int kc, const DataType *a, const DataType *b, size_t bRowStride,
+                                DataType *c, size_t ldc, unsigned int nr, bool addToC, const DataType *initial)
+        {
+            if constexpr (Rows > 1)
+            {
+                if (mr < Rows)
+                {
+                    microKernelForRows<DataType, Simd, MR, NR, Rows - 1>(mr, kc, a, b, bRowStride, c, ldc, nr, addToC, initial);
+                    return;
+                }
+            }
+
+            microKernel<DataType, Simd, MR, NR, Rows>(kc, a, b, bRowStride, c, ldc, nr, addToC, initial);
+        }
+
+        //a few rows of A, e.g. a small batch through a fully connected layer.
+        //every row of B is read once, in order, and updates all m rows of C,
+        //which stay in L1. the blocked path would walk B once per row panel
+        template<typename DataType, typename Simd>
+        void streamingGemm(unsigned int m, unsigned int n, unsigned int k,
+                           const DataType *a, size_t aRowStride, size_t aColumnStride,
+                           const DataType *b, size_t bRowStride,
+                           DataType *c, size_t ldc, bool accumulate, const DataType *bias)
+        {
+            //rows of B per pass over C, cuts the loads and stores of C by as much
+            const unsigned int KR = 4;
+            unsigned int vectorEnd = n - n % Simd::Width;
+
+            for (unsigned int i = 0; i < m; ++i)
+            {
+                for (unsigned int j = 0; j < n; ++j)
+                {
+                    c[i * ldc + j] = (accumulate ? c[i * ldc + j] : DataType(0)) + (bias ? bias[j] : DataType(0));
+                }
+            }
+
+            for (unsigned int p = 0; p < k; p += KR)
+            {
+                unsigned int kr = gemmMin(KR, k - p);
+                DataType factor[GemmStreamRows][KR];
+                typename Simd::Vector factorVector[GemmStreamRows][KR];
+
+                for (unsigned int i = 0; i < m; ++i)
+                {
+                    for (unsigned int q = 0; q < kr; ++q)
+                    {
+                        factor[i][q] = a[i * aRowStride + (p + q) * aColumnStride];
+                        factorVector[i][q] = Simd::broadcast(factor[i][q]);
+                    }
+                }
+
+                const DataType *bRows = b + p * bRowStride;
+
+                if (kr == KR)
+                {
+                    for (unsigned int j = 0; j < vectorEnd; j += Simd::Width)
+                    {
+                        typename Simd::Vector row[KR];
+
+                        #pragma GCC unroll 4
+                        for (unsigned int q = 0; q < KR; ++q)
+                        {
+                            row[q] = Simd::load(bRows + q * bRowStride + j);
+                        }
+
+                        for (unsigned int i = 0; i < m; ++i)
+                        {
+                            typename Simd::Vector sum = Simd::load(c + i * ldc + j);
+
+                            #pragma GCC unroll 4
+                            for (unsigned int q = 0; q < KR; ++q)
+                            {
+                                sum = Simd::fmadd(factorVector[i][q], row[q], sum);
+                            }
+
+                            Simd::store(c + i * ldc + j, sum);
+                        }
+                    }
+                }
+                else
+                {
+                    for (unsigned int j = 0; j < vectorEnd; j += Simd::Width)
+                    {
+                        for (unsigned int i = 0; i < m; ++i)
+                        {
+                            typename Simd::Vector sum = Simd::load(c + i * ldc + j);
+
+                            for (unsigned int q = 0; q < kr; ++q)
+                            {
+                                sum = Simd::fmadd(factorVector[i][q], Simd::load(bRows + q * bRowStride + j), sum);
+                            }
+
+                            Simd::store(c + i * ldc + j, sum);
+                        }
+                    }
+                }
+
+                for (unsigned int j = vectorEnd; j < n; ++j)
+                {
+                    for (unsigned int i = 0; i < m; ++i)
+                    {
+                        for (unsigned int q = 0; q < kr; ++q)
+                        {
+                            c[i * ldc + j] += factor[i][q] * bRows[q * bRowStride + j];
+                        }
+                    }
+                }
+            }
+        }
+
+        template<typename DataType, typename Simd, unsigned int MR, unsigned int NR>
+        void blockedGemm(unsigned int m, unsigned int n, unsigned int k,
+                         const DataType *a, size_t aRowStride, size_t aColumnStride,
+                         const DataType *b, size_t bRowStride, size_t bColumnStride,
+                         DataType *c, size_t ldc, bool accumulate, const DataType *bias)
+        {
+            if (k == 0)
+            {
+                for (unsigned int i = 0; i < m; ++i)
+                {
+                    for (unsigned int j = 0; j < n; ++j)
+                    {
+                        c[i * ldc + j] = (accumulate ? c[i * ldc + j] : DataType(0)) + (bias ? bias[j] : DataType(0));
+                    }
+                }
+                return;
+            }
+
+            //the portable kernel has no vectors to stream with, it stays blocked
+            if (m <= GemmStreamRows && bColumnStride == 1 && Simd::Width > 1)
+            {
+                streamingGemm<DataType, Simd>(m, n, k, a, aRowStride, aColumnStride, b, bRowStride, c, ldc, accumulate, bias);
+                return;
+            }
+
+            static thread_local GemmBuffer packedABuffer;
+            static thread_local GemmBuffer packedBBuffer;
+
+            DataType *packedA = (DataType *) packedABuffer.reserve(sizeof(DataType) * GemmMC * GemmKC);
+            DataType *packedB = (DataType *) packedBBuffer.reserve(sizeof(DataType) * GemmKC * (GemmNC + NR));
+
+            //a few rows of A can't pay for packing B, whole panels of a row
+            //major B are read where they are and only the last one is packed
+            bool isBInPlace = bColumnStride == 1 && m < 4 * MR;
+
+            for (unsigned int jc = 0; jc < n; jc += GemmNC)
+            {
+                unsigned int nc = gemmMin(GemmNC, n - jc);
+
+                for (unsigned int pc = 0; pc < k; pc += GemmKC)
+                {
+                    unsigned int kc = gemmMin(GemmKC, k - pc);
+                    bool isFirst = pc == 0;
+                    const DataType *bBlock = b + pc * bRowStride + jc * bColumnStride;
+
+                    if (!isBInPlace)
+                    {
+                        packB<DataType, NR>(kc, nc, bBlock, bRowStride, bColumnStride, packedB);
+                    }
+                    else if (nc % NR)
+                    {
+                        packB<DataType, NR>(kc, nc % NR, bBlock + (nc - nc % NR), bRowStride, bColumnStride, packedB);
+                    }
+
+                    for (unsigned int ic = 0; ic < m; ic += GemmMC)
+                    {
+                        unsigned int mc = gemmMin(GemmMC, m - ic);
+
+                        packA<DataType, MR>(mc, kc, a + ic * aRowStride + pc * aColumnStride, aRowStride, aColumnStride, packedA);
+
+                        for (unsigned int jr = 0; jr < nc; jr += NR)
+                        {
+                            unsigned int nr = gemmMin(NR, nc - jr);
+
+                            const DataType *bPanel = packedB + (jr / NR) * kc * NR;
+                            size_t bPanelRowStride = NR;
+
+                            if (isBInPlace)
+                            {
+                                bPanel = nr == NR ? bBlock + jr : packedB;
+                                bPanelRowStride = nr == NR ? bRowStride : NR;
+                            }
+
+                            const DataType *initial = (isFirst && bias) ? bias + jc + jr : nullptr;
+
+                            for (unsigned int ir = 0; ir < mc; ir += MR)
+                            {
+                                microKernelForRows<DataType, Simd, MR, NR>(gemmMin(MR, mc - ir), kc, packedA + (ir / MR) * kc * MR,
+                                                                           bPanel, bPanelRowStride, c + (ic + ir) * ldc + jc + jr, ldc,
+                                                                           nr, !isFirst || accumulate, initial);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif
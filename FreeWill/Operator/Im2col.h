@@ -0,0 +1,66 @@
+#ifndef IM2COL_H
+#define IM2COL_H
+
+#include <algorithm>
+#include <cstddef>
+
+namespace FreeWill
+{
+    // Lowers an NHWC convolution to gemm. Every output pixel becomes one row of
+    // filterSize * filterSize * channelCount values, ordered filter y, filter x,
+    // channel like a filter of the FeatureMap, so the rows times the transposed
+    // FeatureMap is the output. Pixels are counted over the whole batch,
+    // pixel = (b * newHeight + y) * newWidth + x, and taps in the padding are 0.
+    template<typename DataType>
+    void im2col(const DataType *input, unsigned int width, unsigned int height, unsigned int channelCount,
+                unsigned int filterSize, unsigned int strideX, unsigned int strideY,
+                unsigned int zeroPaddingX, unsigned int zeroPaddingY,
+                unsigned int newWidth, unsigned int newHeight,
+                unsigned int pixelBegin, unsigned int pixelEnd, DataType *columns)
+    {
+        const unsigned int filterRowLength = filterSize * channelCount;
+
+        for (unsigned int pixel = pixelBegin; pixel < pixelEnd; ++pixel)
+        {
+            unsigned int b = pixel / (newWidth * newHeight);
+            unsigned int newIndexY = (pixel / newWidth) % newHeight;
+            unsigned int newIndexX = pixel % newWidth;
+
+            int startX = -(int)zeroPaddingX + (int)(newIndexX * strideX);
+            int startY = -(int)zeroPaddingY + (int)(newIndexY * strideY);
+
+            //the filter columns inside the image, the rest is padding
+            int beginX = std::min((int) filterSize, std::max(0, -startX));
+            int endX = std::max(beginX, std::min((int) filterSize, (int) width - startX));
+
+            for (unsigned int y = 0; y < filterSize; ++y)
+            {
+                int realY = (int) y + startY;
+                DataType *row = columns + y * filterRowLength;
+
+                if (realY < 0 || realY >= (int) height)
+                {
+                    std::fill(row, row + filterRowLength, DataType(0));
+                    continue;
+                }
+
+                std::fill(row, row + beginX * channelCount, DataType(0));
+
+                //with padding as wide as the filter no column is inside, and the
+                //first one would be before the start of the input
+                if (endX > beginX)
+                {
+                    const DataType *source = input + ((b * height + realY) * width + startX + beginX) * channelCount;
+                    std::copy(source, source + (endX - beginX) * channelCount, row + beginX * channelCount);
+                }
+
+                std::fill(row + endX * channelCount, row + filterRowLength, DataType(0));
+            }
+
+            columns += filterSize * filterRowLength;
+        }
+    }
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define MAXPOOLING_H
 
 #include "Operator.h"
+#include "../Context/Context.h"
 #include <cudnn.h>
 
 namespace FreeWill
@@ -144,10 +145,14 @@ namespace FreeWill
                 Tensor<DeviceUsed, unsigned int> *_switchX = output("SwitchX")->template toType<unsigned int>();
                 Tensor<DeviceUsed, unsigned int> *_switchY = output("SwitchY")->template toType<unsigned int>();
 
-                for (unsigned int b = 0; b < batchSize; ++b)
+                //rows of the output never overlap, so the chunks can run on any worker
+                Context<DeviceUsed>::getSingleton().parallelFor(0, batchSize * newHeight, [&](unsigned int rowBegin, unsigned int rowEnd)
                 {
-                    for(unsigned int y = 0;y< newHeight; ++y)
+                    for (unsigned int row = rowBegin; row < rowEnd; ++row)
                     {
+                        unsigned int b = row / newHeight;
+                        unsigned int y = row % newHeight;
+
                         for(unsigned int x =0;x<newWidth; ++x)
                         {
                             for(unsigned int depth = 0;depth<depthSize;++depth)
@@ -188,7 +193,7 @@ namespace FreeWill
                             }
                         }
                     }
-                }
+                });
             }
             else if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
             {
@@ -0,0 +1,86 @@
+#include "Quantization.h"
+#include <cmath>
+#include <algorithm>
+
+namespace FreeWill
+{
+    //QuantizationAVX2.cpp
+    int32_t dotProductInt8AVX2(const int8_t *a, const int8_t *b, unsigned int count);
+}
+
+static int8_t quantizeValue(float value, float inverseScale)
+{
+    return (int8_t) std::min(127.0f, std::max(-127.0f, std::nearbyint(value * inverseScale)));
+}
+
+float FreeWill::quantizationScale(float maximum)
+{
+    return maximum > 0.0f ? maximum / 127.0f : 1.0f;
+}
+
+void FreeWill::quantize(const float *source, int8_t *destination, unsigned int count, float scale)
+{
+    float inverseScale = 1.0f / scale;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        destination[i] = quantizeValue(source[i], inverseScale);
+    }
+}
+
+void FreeWill::quantizeDotProductWeight(const float *weight, unsigned int inputSize, unsigned int outputSize,
+                                        int8_t *packedWeight, float *scales)
+{
+    for (unsigned int o = 0; o < outputSize; ++o)
+    {
+        float maximum = 0.0f;
+        for (unsigned int i = 0; i < inputSize; ++i)
+        {
+            maximum = std::max(maximum, std::abs(weight[i * outputSize + o]));
+        }
+
+        scales[o] = quantizationScale(maximum);
+        float inverseScale = 1.0f / scales[o];
+
+        for (unsigned int i = 0; i < inputSize; ++i)
+        {
+            packedWeight[o * inputSize + i] = quantizeValue(weight[i * outputSize + o], inverseScale);
+        }
+    }
+}
+
+void FreeWill::quantizePerChannel(const float *data, unsigned int channelSize, unsigned int channelCount,
+                                  int8_t *destination, float *scales)
+{
+    for (unsigned int c = 0; c < channelCount; ++c)
+    {
+        float maximum = 0.0f;
+        for (unsigned int i = 0; i < channelSize; ++i)
+        {
+            maximum = std::max(maximum, std::abs(data[c * channelSize + i]));
+        }
+
+        scales[c] = quantizationScale(maximum);
+
+        quantize(&data[c * channelSize], &destination[c * channelSize], channelSize, scales[c]);
+    }
+}
+
+int32_t FreeWill::dotProductInt8(const int8_t *a, const int8_t *b, unsigned int count)
+{
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+
+    if (hasAVX2)
+    {
+        return dotProductInt8AVX2(a, b, count);
+    }
+
+    int32_t result = 0;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        result += (int32_t) a[i] * (int32_t) b[i];
+    }
+
+    return result;
+}
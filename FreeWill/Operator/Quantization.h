@@ -0,0 +1,32 @@
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+#include <cstdint>
+
+namespace FreeWill
+{
+    // Symmetric int8 quantization: x is stored as round(x / scale), clamped to
+    // [-127, 127], so zero stays exactly zero and no zero point is needed.
+    // Activations get one scale per tensor from calibration, weights one
+    // scale per output channel. Products are summed in int32 and turned back
+    // into float once per output.
+
+    //the scale that maps [-maximum, maximum] onto [-127, 127]
+    float quantizationScale(float maximum);
+
+    void quantize(const float *source, int8_t *destination, unsigned int count, float scale);
+
+    //dot product weights are [input][output], packed to [output][input] so
+    //every output reads one contiguous row
+    void quantizeDotProductWeight(const float *weight, unsigned int inputSize, unsigned int outputSize,
+                                  int8_t *packedWeight, float *scales);
+
+    //channel after channel, e.g. the filters of a convolution feature map
+    void quantizePerChannel(const float *data, unsigned int channelSize, unsigned int channelCount,
+                            int8_t *destination, float *scales);
+
+    //uses AVX2 when the CPU has it, the result is exact either way
+    int32_t dotProductInt8(const int8_t *a, const int8_t *b, unsigned int count);
+}
+
+#endif
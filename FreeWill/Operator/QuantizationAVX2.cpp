@@ -0,0 +1,34 @@
+//built with -mavx2, only called after the CPU was checked
+#include <cstdint>
+#include <immintrin.h>
+
+namespace FreeWill
+{
+    //sign extends to 16 bit and multiplies pairwise into 32 bit. maddubs would
+    //need unsigned activations and saturates its 16 bit pair sums at 127 * 127 * 2
+    int32_t dotProductInt8AVX2(const int8_t *a, const int8_t *b, unsigned int count)
+    {
+        __m256i sum = _mm256_setzero_si256();
+        unsigned int i = 0;
+
+        for (; i + 16 <= count; i += 16)
+        {
+            __m256i a16 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (a + i)));
+            __m256i b16 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (b + i)));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a16, b16));
+        }
+
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+
+        int32_t result = _mm_cvtsi128_si32(half);
+
+        for (; i < count; ++i)
+        {
+            result += (int32_t) a[i] * (int32_t) b[i];
+        }
+
+        return result;
+    }
+}
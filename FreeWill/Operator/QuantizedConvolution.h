@@ -0,0 +1,173 @@
+#ifndef QUANTIZEDCONVOLUTION_H
+#define QUANTIZEDCONVOLUTION_H
+
+#include "Operator.h"
+#include "Quantization.h"
+#include "../Context/Context.h"
+#include <vector>
+#include <algorithm>
+
+namespace FreeWill
+{
+    // Inference only Convolution on an int8 FeatureMap, quantized filter by
+    // filter with quantizePerChannel, so FeatureMapScale has one entry per
+    // filter. Input, Bias and Output stay float like in QuantizedDotProductWithBias.
+    template<DeviceType DeviceUsed = DeviceType::CPU_NAIVE>
+    class QuantizedConvolution : public Operator<DeviceUsed>
+    {
+    protected:
+        using Operator<DeviceUsed>::input;
+        using Operator<DeviceUsed>::output;
+        using Operator<DeviceUsed>::m_deviceId;
+
+        unsigned int m_zeroPaddingX;
+        unsigned int m_strideX;
+        unsigned int m_zeroPaddingY;
+        unsigned int m_strideY;
+        std::vector<int8_t> m_quantizedInput;
+
+    public:
+        QuantizedConvolution(unsigned int strideX = 1, unsigned int strideY = 1,
+                unsigned int zeroPaddingX = 0, unsigned int zeroPaddingY = 0, unsigned int deviceId = 0)
+            :Operator<DeviceUsed>({"Input", "InputScale", "FeatureMap", "FeatureMapScale", "Bias"}, {"Output"}, deviceId),
+            m_zeroPaddingX(zeroPaddingX),
+            m_strideX(strideX),
+            m_zeroPaddingY(zeroPaddingY),
+            m_strideY(strideY),
+            m_quantizedInput()
+        {
+        }
+
+        virtual bool init() override
+        {
+            CHECK_GPU;
+
+            FAIL_IF (DeviceUsed != DeviceType::CPU_NAIVE);
+
+            FAIL_IF (!input("Input") || !input("InputScale") || !input("FeatureMap") || !input("FeatureMapScale")
+                     || !input("Bias") || !output("Output"));
+
+            FAIL_IF (input("Input")->shape().dimension() != 4);
+
+            FAIL_IF (input("FeatureMap")->shape().dimension() != 4);
+
+            FAIL_IF (output("Output")->shape().dimension() != 4);
+
+            FAIL_IF (input("Input")->shape()[0] != input("FeatureMap")->shape()[0]);
+
+            FAIL_IF (input("FeatureMap")->shape()[1] != input("FeatureMap")->shape()[2]);
+
+            unsigned int originalWidth = input("Input")->shape()[1];
+            unsigned int originalHeight = input("Input")->shape()[2];
+            unsigned int filterSize = input("FeatureMap")->shape()[1];
+
+            unsigned int newWidth = (originalWidth - filterSize + 2*m_zeroPaddingX) / m_strideX + 1;
+            unsigned int newHeight = (originalHeight - filterSize + 2*m_zeroPaddingY) / m_strideY + 1;
+
+            FAIL_IF ((originalWidth - filterSize + 2*m_zeroPaddingX) % m_strideX != 0);
+            FAIL_IF ((originalHeight - filterSize + 2*m_zeroPaddingY) % m_strideY !=0);
+
+            FAIL_IF (output("Output")->shape()[1] != newWidth || output("Output")->shape()[2] != newHeight);
+
+            FAIL_IF (input("Bias")->shape().dimension() != 1);
+
+            FAIL_IF (input("Bias")->shape()[0] != input("FeatureMap")->shape()[3]);
+
+            FAIL_IF (input("FeatureMapScale")->shape().size() != input("FeatureMap")->shape()[3]);
+
+            FAIL_IF (input("InputScale")->shape().size() != 1);
+
+            FAIL_IF (input("FeatureMap")->shape()[3] != output("Output")->shape()[0]);
+
+            FAIL_IF (input("Input")->shape()[3] != output("Output")->shape()[3]);
+
+            m_quantizedInput.resize(input("Input")->shape().size());
+
+            return true;
+        }
+
+        virtual void evaluate() override
+        {
+            CHECK_GPU;
+
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                Tensor<DeviceUsed, float> *_input = input("Input")->template toType<float>();
+                Tensor<DeviceUsed, int8_t> *_featureMap = input("FeatureMap")->template toType<int8_t>();
+                Tensor<DeviceUsed, float> *_featureMapScale = input("FeatureMapScale")->template toType<float>();
+                Tensor<DeviceUsed, float> *_bias = input("Bias")->template toType<float>();
+                Tensor<DeviceUsed, float> *_output = output("Output")->template toType<float>();
+
+                unsigned int featureMapCount = _featureMap->shape()[3];
+                unsigned int featureMapLength = _featureMap->shape()[1];
+
+                unsigned int originalWidth = _input->shape()[1];
+                unsigned int originalHeight = _input->shape()[2];
+
+                unsigned int channelCount = _featureMap->shape()[0];
+
+                unsigned int newWidth = (originalWidth - featureMapLength + 2 * m_zeroPaddingX ) / m_strideX + 1;
+                unsigned int newHeight = (originalHeight - featureMapLength + 2 * m_zeroPaddingY) / m_strideY + 1;
+
+                unsigned int batchSize = _input->shape()[3];
+
+                float inputScale = (*input("InputScale")->template toType<float>())[0];
+
+                m_quantizedInput.resize(_input->shape().size());
+                quantize(_input->cpuDataHandle(), m_quantizedInput.data(), _input->shape().size(), inputScale);
+
+                const int8_t *featureMap = _featureMap->cpuDataHandle();
+                const int8_t *quantizedInput = m_quantizedInput.data();
+
+                Context<DeviceUsed>::getSingleton().parallelFor(0, batchSize * newHeight, [&](unsigned int rowBegin, unsigned int rowEnd)
+                {
+                    for (unsigned int row = rowBegin; row < rowEnd; ++row)
+                    {
+                        unsigned int b = row / newHeight;
+                        unsigned int newIndexY = row % newHeight;
+
+                        for (unsigned int newIndexX = 0; newIndexX < newWidth;++newIndexX)
+                        {
+                            int startX = -m_zeroPaddingX + newIndexX * m_strideX;
+                            int startY = -m_zeroPaddingY + newIndexY * m_strideY;
+
+                            //the filter columns inside the image, padding contributes nothing
+                            int beginX = std::max(0, -startX);
+                            int endX = std::min((int) featureMapLength, (int) originalWidth - startX);
+
+                            unsigned int resultBaseIndex = (b * newWidth*newHeight +newIndexY * newWidth + newIndexX) * featureMapCount;
+
+                            for (unsigned int k = 0; k < featureMapCount; ++k)
+                            {
+                                int32_t sum = 0;
+
+                                for(int y = 0; y< (int)featureMapLength && beginX < endX; ++y)
+                                {
+                                    int realY = y + startY;
+
+                                    if (realY < 0 || realY >= (int)originalHeight)
+                                    {
+                                        continue;
+                                    }
+
+                                    //channels of neighbouring pixels are adjacent in both tensors
+                                    unsigned int originalBaseIndex = (b* originalHeight * originalWidth + realY*originalWidth + startX + beginX)
+                                        *channelCount;
+                                    unsigned int featureMapBaseIndex = (k * (featureMapLength * featureMapLength) + y*featureMapLength + beginX)
+                                        *channelCount;
+
+                                    sum += dotProductInt8(&featureMap[featureMapBaseIndex], &quantizedInput[originalBaseIndex],
+                                                          (endX - beginX) * channelCount);
+                                }
+
+                                (*_output)[resultBaseIndex + k] = sum * inputScale * (*_featureMapScale)[k] + (*_bias)[k];
+                            }
+                        }
+                    }
+                });
+            }
+        }
+    };
+}
+
+#endif
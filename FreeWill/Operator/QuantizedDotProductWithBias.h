@@ -0,0 +1,119 @@
+#ifndef QUANTIZEDDOTPRODUCTWITHBIAS_H
+#define QUANTIZEDDOTPRODUCTWITHBIAS_H
+
+#include "Operator.h"
+#include "Quantization.h"
+#include "../Context/Context.h"
+#include <vector>
+
+namespace FreeWill
+{
+    // Inference only DotProductWithBias on int8 weights. Input, Bias and Output
+    // stay float, the input is quantized with the calibrated InputScale ({1})
+    // on the way in. Weight is packed by quantizeDotProductWeight, so its shape
+    // is {inputSize, outputSize}, with WeightScale ({outputSize}) next to it.
+    template<DeviceType DeviceUsed = DeviceType::CPU_NAIVE>
+    class QuantizedDotProductWithBias : public Operator<DeviceUsed>
+    {
+    protected:
+        using Operator<DeviceUsed>::input;
+        using Operator<DeviceUsed>::output;
+        using Operator<DeviceUsed>::m_deviceId;
+        bool m_hasBias;
+        std::vector<int8_t> m_quantizedInput;
+
+    public:
+        QuantizedDotProductWithBias(bool hasBias = true, unsigned int deviceId = 0)
+            :Operator<DeviceUsed>({"Input", "InputScale", "Weight", "WeightScale", "Bias"}, {"Output"}, deviceId),
+            m_hasBias(hasBias),
+            m_quantizedInput()
+        {
+        }
+
+        virtual bool init() override
+        {
+            CHECK_GPU;
+
+            FAIL_IF (DeviceUsed != DeviceType::CPU_NAIVE);
+
+            FAIL_IF (!input("Input") || !input("InputScale") || !input("Weight") || !input("WeightScale") || !output("Output"));
+
+            FAIL_IF (input("Input")->shape().dimension() != 2 ||
+                     input("Weight")->shape().dimension() != 2 ||
+                     output("Output")->shape().dimension() != 2);
+
+            unsigned int batchSize = input("Input")->shape()[1];
+            unsigned int inputSize = input("Input")->shape()[0];
+            unsigned int outputSize = output("Output")->shape()[0];
+
+            FAIL_IF (batchSize != output("Output")->shape()[1] || batchSize == 0);
+
+            FAIL_IF (input("Weight")->shape()[0] != inputSize || input("Weight")->shape()[1] != outputSize);
+
+            FAIL_IF (input("WeightScale")->shape().size() != outputSize);
+
+            FAIL_IF (input("InputScale")->shape().size() != 1);
+
+            FAIL_IF (m_hasBias && input("Bias") == 0);
+
+            if (m_hasBias)
+            {
+                FAIL_IF (input("Bias")->shape().dimension() != 1);
+
+                FAIL_IF (input("Bias")->shape()[0] != outputSize);
+            }
+
+            m_quantizedInput.resize(input("Input")->shape().size());
+
+            return true;
+        }
+
+        virtual void evaluate() override
+        {
+            CHECK_GPU;
+
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                unsigned int batchSize = input("Input")->shape()[1];
+                unsigned int inputSize = input("Input")->shape()[0];
+                unsigned int outputSize = output("Output")->shape()[0];
+
+                Tensor<DeviceUsed, float> *_input = input("Input")->template toType<float>();
+                Tensor<DeviceUsed, int8_t> *_weight = input("Weight")->template toType<int8_t>();
+                Tensor<DeviceUsed, float> *_weightScale = input("WeightScale")->template toType<float>();
+                Tensor<DeviceUsed, float> *_output = output("Output")->template toType<float>();
+                Tensor<DeviceUsed, float> *_bias = m_hasBias ? input("Bias")->template toType<float>() : nullptr;
+
+                float inputScale = (*input("InputScale")->template toType<float>())[0];
+
+                m_quantizedInput.resize(batchSize * inputSize);
+                quantize(_input->cpuDataHandle(), m_quantizedInput.data(), batchSize * inputSize, inputScale);
+
+                const int8_t *weight = _weight->cpuDataHandle();
+                const int8_t *quantizedInput = m_quantizedInput.data();
+
+                Context<DeviceUsed>::getSingleton().parallelFor(0, batchSize * outputSize, [&](unsigned int indexBegin, unsigned int indexEnd)
+                {
+                    for(unsigned int index = indexBegin; index < indexEnd; ++index)
+                    {
+                        unsigned int b = index / outputSize;
+                        unsigned int o = index % outputSize;
+
+                        int32_t sum = dotProductInt8(&weight[o * inputSize], &quantizedInput[b * inputSize], inputSize);
+
+                        float value = sum * inputScale * (*_weightScale)[o];
+
+                        if (m_hasBias)
+                        {
+                            value += (*_bias)[o];
+                        }
+
+                        (*_output)[b * outputSize + o] = value;
+                    }
+                });
+            }
+        }
+    };
+}
+
+#endif
@@ -129,26 +129,29 @@ namespace FreeWill
 
             if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
             {
+                using Accumulator = typename AccumulatorType<DataType>::type;
+
                 for(unsigned int b = 0; b < batchSize; ++b)
                 {
 
 
-                    DataType maximum = (*_input)[b * vectorSize];
+                    Accumulator maximum = (*_input)[b * vectorSize];
 
                     for(unsigned int i = 1;i<vectorSize;++i)
                     {
-                        if ((*_input)[b*vectorSize + i] > maximum)
+                        if ((Accumulator) (*_input)[b*vectorSize + i] > maximum)
                         {
                             maximum = (*_input)[b*vectorSize + i];
                         }
                     }
 
-                    DataType expSum = 0;
+                    Accumulator expSum = 0;
+                    Accumulator labelValue = 0;
                     unsigned int label = (*_label)[b];
 
                     for(unsigned int i=0;i<vectorSize;++i)
                     {
-                        DataType v = (*_input)[b*vectorSize + i] - maximum;
+                        Accumulator v = (Accumulator) (*_input)[b*vectorSize + i] - maximum;
 
                         v = std::exp(v);
 
@@ -156,7 +159,7 @@ namespace FreeWill
 
                         if (i == label)
                         {
-                            (*_cost)[b] = v;
+                            labelValue = v;
                         }
 
                         expSum += v;
@@ -165,12 +168,10 @@ namespace FreeWill
 
                     for(unsigned int i=0;i<vectorSize;++i)
                     {
-                        (*_output)[b*vectorSize+i] = (*_output)[b*vectorSize+i] / expSum;
+                        (*_output)[b*vectorSize+i] = (Accumulator) (*_output)[b*vectorSize+i] / expSum;
                     }
 
-                    (*_cost)[b] /= expSum;
-
-                    (*_cost)[b] = -log((*_cost)[b]);
+                    (*_cost)[b] = -log(labelValue / expSum);
             
                 }
 
@@ -0,0 +1,380 @@
+#ifndef WINOGRAD_H
+#define WINOGRAD_H
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include "Gemm.h"
+#include "../Context/Context.h"
+
+namespace FreeWill
+{
+    // Winograd minimal filtering F(MxM, 3x3) (Lavin and Gray): an M x M output
+    // tile is Aᵀ [(G g Gᵀ) ⊙ (Bᵀ d B)] A for an (M + 2) x (M + 2) input tile d,
+    // which takes (M + 2)² multiplications per channel instead of 9 M².
+    // Summed over the channels, each of the (M + 2)² elements is one gemm.
+    template<unsigned int M>
+    struct WinogradTransform;
+
+    template<>
+    struct WinogradTransform<2>
+    {
+        static constexpr double BT[4][4] = {{1, 0, -1, 0},
+                                            {0, 1, 1, 0},
+                                            {0, -1, 1, 0},
+                                            {0, 1, 0, -1}};
+        static constexpr double G[4][3] = {{1, 0, 0},
+                                           {0.5, 0.5, 0.5},
+                                           {0.5, -0.5, 0.5},
+                                           {0, 0, 1}};
+        static constexpr double AT[2][4] = {{1, 1, 1, 0},
+                                            {0, 1, -1, -1}};
+    };
+
+    template<>
+    struct WinogradTransform<4>
+    {
+        static constexpr double BT[6][6] = {{4, 0, -5, 0, 1, 0},
+                                            {0, -4, -4, 1, 1, 0},
+                                            {0, 4, -4, -1, 1, 0},
+                                            {0, -2, -1, 2, 1, 0},
+                                            {0, 2, -1, -2, 1, 0},
+                                            {0, 4, 0, -5, 0, 1}};
+        static constexpr double G[6][3] = {{1.0 / 4, 0, 0},
+                                           {-1.0 / 6, -1.0 / 6, -1.0 / 6},
+                                           {-1.0 / 6, 1.0 / 6, -1.0 / 6},
+                                           {1.0 / 24, 1.0 / 12, 1.0 / 6},
+                                           {1.0 / 24, -1.0 / 12, 1.0 / 6},
+                                           {0, 0, 1}};
+        static constexpr double AT[4][6] = {{1, 1, 1, 1, 1, 0},
+                                            {0, 1, -1, 2, -2, 0},
+                                            {0, 1, 1, 4, 4, 0},
+                                            {0, 1, -1, 8, -8, 1}};
+    };
+
+    // A stride 1 3x3 convolution of NHWC tensors, used by Convolution and, on
+    // the filter turned by 180 degrees, by the InputGrad of ConvolutionDerivative.
+    // The transformed filter is kept until the filter changes, which is checked
+    // against a copy of the one it was made from.
+    template<typename DataType>
+    class WinogradConvolution
+    {
+    private:
+        unsigned int m_tileSize;
+        unsigned int m_inputChannelCount;
+        unsigned int m_outputChannelCount;
+        bool m_isRotated;
+        std::vector<DataType> m_filter;
+        std::vector<DataType> m_transformedFilter;
+
+        //U[xi][nu][input channel][output channel] = G g Gᵀ
+        template<unsigned int M>
+        void transformFilter(const DataType *featureMap, unsigned int channelCount, unsigned int featureMapCount)
+        {
+            typedef WinogradTransform<M> T;
+            const unsigned int Alpha = M + 2;
+
+            m_transformedFilter.resize(Alpha * Alpha * channelCount * featureMapCount);
+
+            for (unsigned int k = 0; k < featureMapCount; ++k)
+            {
+                for (unsigned int c = 0; c < channelCount; ++c)
+                {
+                    double g[3][3];
+
+                    for (unsigned int y = 0; y < 3; ++y)
+                    {
+                        for (unsigned int x = 0; x < 3; ++x)
+                        {
+                            //InputGrad correlates OutputGrad with the filter turned around
+                            unsigned int filterY = m_isRotated ? 2 - y : y;
+                            unsigned int filterX = m_isRotated ? 2 - x : x;
+                            g[y][x] = featureMap[((k * 3 + filterY) * 3 + filterX) * channelCount + c];
+                        }
+                    }
+
+                    double gGT[3][Alpha];
+
+                    for (unsigned int y = 0; y < 3; ++y)
+                    {
+                        for (unsigned int j = 0; j < Alpha; ++j)
+                        {
+                            gGT[y][j] = g[y][0] * T::G[j][0] + g[y][1] * T::G[j][1] + g[y][2] * T::G[j][2];
+                        }
+                    }
+
+                    unsigned int inputChannel = m_isRotated ? k : c;
+                    unsigned int outputChannel = m_isRotated ? c : k;
+
+                    for (unsigned int i = 0; i < Alpha; ++i)
+                    {
+                        for (unsigned int j = 0; j < Alpha; ++j)
+                        {
+                            double u = T::G[i][0] * gGT[0][j] + T::G[i][1] * gGT[1][j] + T::G[i][2] * gGT[2][j];
+                            m_transformedFilter[((i * Alpha + j) * m_inputChannelCount + inputChannel) * m_outputChannelCount + outputChannel] = u;
+                        }
+                    }
+                }
+            }
+        }
+
+        template<unsigned int M>
+        void evaluateTiles(const DataType *input, unsigned int width, unsigned int height, unsigned int batchSize,
+                           unsigned int zeroPaddingX, unsigned int zeroPaddingY,
+                           DataType *output, unsigned int newWidth, unsigned int newHeight, const DataType *bias)
+        {
+            typedef WinogradTransform<M> T;
+            const unsigned int Alpha = M + 2;
+
+            unsigned int inputChannelCount = m_inputChannelCount;
+            unsigned int outputChannelCount = m_outputChannelCount;
+
+            unsigned int tileCountX = (newWidth + M - 1) / M;
+            unsigned int tileCountY = (newHeight + M - 1) / M;
+            unsigned int tileCount = batchSize * tileCountX * tileCountY;
+
+            //the transformed tiles of a block and their products stay in L2
+            unsigned int tilesPerBlock = std::max(12u, (unsigned int) ((2048 * 1024) /
+                                                  (Alpha * Alpha * (inputChannelCount + outputChannelCount) * sizeof(DataType))));
+            tilesPerBlock = std::min(tilesPerBlock, tileCount);
+            unsigned int blockCount = (tileCount + tilesPerBlock - 1) / tilesPerBlock;
+
+            const DataType *transformedFilter = m_transformedFilter.data();
+
+            Context<DeviceType::CPU_NAIVE>::getSingleton().parallelFor(0, blockCount, [&](unsigned int blockBegin, unsigned int blockEnd)
+            {
+                size_t transformedInputSize = (size_t) Alpha * Alpha * tilesPerBlock * inputChannelCount;
+                size_t productSize = (size_t) Alpha * Alpha * tilesPerBlock * outputChannelCount;
+                size_t tileSize = (size_t) Alpha * Alpha * std::max(inputChannelCount, outputChannelCount);
+
+                DataType *transformedInput = gemmWorkspace<DataType>(transformedInputSize + productSize + 2 * tileSize);
+                DataType *product = transformedInput + transformedInputSize;
+                DataType *tile = product + productSize;
+                DataType *temporary = tile + tileSize;
+
+                for (unsigned int block = blockBegin; block < blockEnd; ++block)
+                {
+                    unsigned int tileBegin = block * tilesPerBlock;
+                    unsigned int tileEnd = std::min(tileCount, tileBegin + tilesPerBlock);
+                    unsigned int blockTileCount = tileEnd - tileBegin;
+
+                    //V = Bᵀ d B, every channel at once
+                    for (unsigned int t = tileBegin; t < tileEnd; ++t)
+                    {
+                        unsigned int b = t / (tileCountX * tileCountY);
+                        int startY = (int) (((t / tileCountX) % tileCountY) * M) - (int) zeroPaddingY;
+                        int startX = (int) ((t % tileCountX) * M) - (int) zeroPaddingX;
+
+                        for (unsigned int i = 0; i < Alpha; ++i)
+                        {
+                            for (unsigned int j = 0; j < Alpha; ++j)
+                            {
+                                int realY = startY + (int) i;
+                                int realX = startX + (int) j;
+                                DataType *destination = tile + (i * Alpha + j) * inputChannelCount;
+
+                                if (realY < 0 || realY >= (int) height || realX < 0 || realX >= (int) width)
+                                {
+                                    std::fill(destination, destination + inputChannelCount, DataType(0));
+                                }
+                                else
+                                {
+                                    const DataType *source = input + ((b * height + realY) * width + realX) * inputChannelCount;
+                                    std::copy(source, source + inputChannelCount, destination);
+                                }
+                            }
+                        }
+
+                        for (unsigned int i = 0; i < Alpha; ++i)
+                        {
+                            for (unsigned int j = 0; j < Alpha; ++j)
+                            {
+                                DataType *destination = temporary + (i * Alpha + j) * inputChannelCount;
+                                std::fill(destination, destination + inputChannelCount, DataType(0));
+
+                                for (unsigned int l = 0; l < Alpha; ++l)
+                                {
+                                    if (T::BT[i][l] == 0)
+                                    {
+                                        continue;
+                                    }
+
+                                    DataType factor = T::BT[i][l];
+                                    const DataType *source = tile + (l * Alpha + j) * inputChannelCount;
+
+                                    for (unsigned int c = 0; c < inputChannelCount; ++c)
+                                    {
+                                        destination[c] += factor * source[c];
+                                    }
+                                }
+                            }
+                        }
+
+                        for (unsigned int i = 0; i < Alpha; ++i)
+                        {
+                            for (unsigned int j = 0; j < Alpha; ++j)
+                            {
+                                DataType *destination = transformedInput + ((i * Alpha + j) * tilesPerBlock + (t - tileBegin)) * inputChannelCount;
+                                std::fill(destination, destination + inputChannelCount, DataType(0));
+
+                                for (unsigned int l = 0; l < Alpha; ++l)
+                                {
+                                    if (T::BT[j][l] == 0)
+                                    {
+                                        continue;
+                                    }
+
+                                    DataType factor = T::BT[j][l];
+                                    const DataType *source = temporary + (i * Alpha + l) * inputChannelCount;
+
+                                    for (unsigned int c = 0; c < inputChannelCount; ++c)
+                                    {
+                                        destination[c] += factor * source[c];
+                                    }
+                                }
+                            }
+                        }
+                    }
+
+                    //M[xi][nu] (tiles x output channels) = V[xi][nu] (tiles x input channels) * U[xi][nu]
+                    for (unsigned int e = 0; e < Alpha * Alpha; ++e)
+                    {
+                        gemm<DataType>(blockTileCount, outputChannelCount, inputChannelCount,
+                                       transformedInput + e * tilesPerBlock * inputChannelCount, inputChannelCount, 1,
+                                       transformedFilter + e * inputChannelCount * outputChannelCount, outputChannelCount, 1,
+                                       product + e * tilesPerBlock * outputChannelCount, outputChannelCount);
+                    }
+
+                    //Y = Aᵀ M A, added to the output inside the image
+                    for (unsigned int t = tileBegin; t < tileEnd; ++t)
+                    {
+                        unsigned int b = t / (tileCountX * tileCountY);
+                        unsigned int startY = ((t / tileCountX) % tileCountY) * M;
+                        unsigned int startX = (t % tileCountX) * M;
+
+                        for (unsigned int i = 0; i < M; ++i)
+                        {
+                            for (unsigned int j = 0; j < Alpha; ++j)
+                            {
+                                DataType *destination = temporary + (i * Alpha + j) * outputChannelCount;
+                                std::fill(destination, destination + outputChannelCount, DataType(0));
+
+                                for (unsigned int l = 0; l < Alpha; ++l)
+                                {
+                                    if (T::AT[i][l] == 0)
+                                    {
+                                        continue;
+                                    }
+
+                                    DataType factor = T::AT[i][l];
+                                    const DataType *source = product + ((l * Alpha + j) * tilesPerBlock + (t - tileBegin)) * outputChannelCount;
+
+                                    for (unsigned int k = 0; k < outputChannelCount; ++k)
+                                    {
+                                        destination[k] += factor * source[k];
+                                    }
+                                }
+                            }
+                        }
+
+                        for (unsigned int i = 0; i < M && startY + i < newHeight; ++i)
+                        {
+                            for (unsigned int j = 0; j < M && startX + j < newWidth; ++j)
+                            {
+                                DataType *destination = output + ((b * newHeight + startY + i) * newWidth + startX + j) * outputChannelCount;
+
+                                for (unsigned int l = 0; l < Alpha; ++l)
+                                {
+                                    if (T::AT[j][l] == 0)
+                                    {
+                                        continue;
+                                    }
+
+                                    DataType factor = T::AT[j][l];
+                                    const DataType *source = temporary + (i * Alpha + l) * outputChannelCount;
+
+                                    for (unsigned int k = 0; k < outputChannelCount; ++k)
+                                    {
+                                        destination[k] += factor * source[k];
+                                    }
+                                }
+
+                                if (bias)
+                                {
+                                    for (unsigned int k = 0; k < outputChannelCount; ++k)
+                                    {
+                                        destination[k] += bias[k];
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+    public:
+        WinogradConvolution()
+            :m_tileSize(0),
+            m_inputChannelCount(0),
+            m_outputChannelCount(0),
+            m_isRotated(false),
+            m_filter(),
+            m_transformedFilter()
+        {
+        }
+
+        static bool isSupported(unsigned int filterSize, unsigned int strideX, unsigned int strideY)
+        {
+            return filterSize == 3 && strideX == 1 && strideY == 1;
+        }
+
+        //featureMap is {channelCount, 3, 3, featureMapCount}, rotated turns the filters by
+        //180 degrees and swaps their channels and filters, as InputGrad needs
+        void setFilter(const DataType *featureMap, unsigned int channelCount, unsigned int featureMapCount,
+                       unsigned int tileSize, bool isRotated)
+        {
+            size_t filterSize = (size_t) channelCount * 9 * featureMapCount;
+
+            if (tileSize == m_tileSize && isRotated == m_isRotated && m_filter.size() == filterSize &&
+                    m_inputChannelCount == (isRotated ? featureMapCount : channelCount) &&
+                    std::memcmp(m_filter.data(), featureMap, filterSize * sizeof(DataType)) == 0)
+            {
+                return;
+            }
+
+            m_tileSize = tileSize;
+            m_isRotated = isRotated;
+            m_inputChannelCount = isRotated ? featureMapCount : channelCount;
+            m_outputChannelCount = isRotated ? channelCount : featureMapCount;
+            m_filter.assign(featureMap, featureMap + filterSize);
+
+            if (tileSize == 4)
+            {
+                transformFilter<4>(featureMap, channelCount, featureMapCount);
+            }
+            else
+            {
+                transformFilter<2>(featureMap, channelCount, featureMapCount);
+            }
+        }
+
+        //output += the convolution of input with the filter (+ bias), both NHWC
+        void evaluate(const DataType *input, unsigned int width, unsigned int height, unsigned int batchSize,
+                      unsigned int zeroPaddingX, unsigned int zeroPaddingY,
+                      DataType *output, unsigned int newWidth, unsigned int newHeight, const DataType *bias = nullptr)
+        {
+            if (m_tileSize == 4)
+            {
+                evaluateTiles<4>(input, width, height, batchSize, zeroPaddingX, zeroPaddingY, output, newWidth, newHeight, bias);
+            }
+            else
+            {
+                evaluateTiles<2>(input, width, height, batchSize, zeroPaddingX, zeroPaddingY, output, newWidth, newHeight, bias);
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,291 @@
+#include "Allocator.h"
+#include <cstdlib>
+#include <cstdint>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+std::atomic<FreeWill::Allocator*> FreeWill::Allocator::m_defaultAllocator(nullptr);
+
+FreeWill::Allocator::~Allocator()
+{}
+
+FreeWill::Allocator *FreeWill::Allocator::defaultAllocator()
+{
+    Allocator *allocator = m_defaultAllocator.load(std::memory_order_acquire);
+
+    return allocator ? allocator : &PoolAllocator::getSingleton();
+}
+
+void FreeWill::Allocator::setDefaultAllocator(Allocator *allocator)
+{
+    m_defaultAllocator.store(allocator, std::memory_order_release);
+}
+
+FreeWill::PoolAllocator::PoolAllocator()
+    :m_mutex(),
+      m_freeBlocks(),
+      m_cachedBytes(0),
+      m_maxCachedBytes(256 * 1024 * 1024)
+{}
+
+FreeWill::PoolAllocator::~PoolAllocator()
+{
+    trim();
+}
+
+FreeWill::PoolAllocator &FreeWill::PoolAllocator::getSingleton()
+{
+    //never destroyed, blobs can still be released during static destruction
+    static PoolAllocator *obj = new PoolAllocator();
+    return *obj;
+}
+
+size_t FreeWill::PoolAllocator::sizeClass(size_t sizeInByte)
+{
+    size_t size = std::max(alignedSize(sizeInByte), ALIGNMENT);
+
+    if (size <= 4 * ALIGNMENT)
+    {
+        return size;
+    }
+
+    size_t powerOfTwo = 1;
+
+    while (powerOfTwo * 2 < size)
+    {
+        powerOfTwo *= 2;
+    }
+
+    size_t step = powerOfTwo / 4;
+
+    return (size + step - 1) & ~(step - 1);
+}
+
+void *FreeWill::PoolAllocator::allocate(size_t sizeInByte)
+{
+    size_t size = sizeClass(sizeInByte);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto iter = m_freeBlocks.find(size);
+
+        if (iter != m_freeBlocks.end() && !iter->second.empty())
+        {
+            void *pointer = iter->second.back();
+            iter->second.pop_back();
+            m_cachedBytes -= size;
+            return pointer;
+        }
+    }
+
+    return std::aligned_alloc(ALIGNMENT, size);
+}
+
+void FreeWill::PoolAllocator::deallocate(void *pointer, size_t sizeInByte)
+{
+    if (!pointer)
+    {
+        return;
+    }
+
+    size_t size = sizeClass(sizeInByte);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_cachedBytes + size <= m_maxCachedBytes)
+        {
+            m_freeBlocks[size].push_back(pointer);
+            m_cachedBytes += size;
+            return;
+        }
+    }
+
+    std::free(pointer);
+}
+
+void FreeWill::PoolAllocator::trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto iter = m_freeBlocks.begin(); iter != m_freeBlocks.end(); ++iter)
+    {
+        for (unsigned int i = 0; i < iter->second.size(); ++i)
+        {
+            std::free(iter->second[i]);
+        }
+    }
+
+    m_freeBlocks.clear();
+    m_cachedBytes = 0;
+}
+
+size_t FreeWill::PoolAllocator::cachedBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_cachedBytes;
+}
+
+void FreeWill::PoolAllocator::setMaxCachedBytes(size_t maxCachedBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_maxCachedBytes = maxCachedBytes;
+
+    //the largest blocks go first, they free the most for the fewest calls
+    for (auto iter = m_freeBlocks.rbegin(); iter != m_freeBlocks.rend() && m_cachedBytes > m_maxCachedBytes; ++iter)
+    {
+        while (!iter->second.empty() && m_cachedBytes > m_maxCachedBytes)
+        {
+            std::free(iter->second.back());
+            iter->second.pop_back();
+            m_cachedBytes -= iter->first;
+        }
+    }
+}
+
+size_t FreeWill::PoolAllocator::maxCachedBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_maxCachedBytes;
+}
+
+FreeWill::ArenaAllocator::ArenaAllocator(size_t capacity)
+    :m_slab(nullptr),
+      m_capacity(alignedSize(capacity)),
+      m_offset(0)
+{
+    if (m_capacity)
+    {
+        m_slab = static_cast<unsigned char*>(std::aligned_alloc(ALIGNMENT, m_capacity));
+    }
+
+    if (!m_slab)
+    {
+        m_capacity = 0;
+    }
+}
+
+FreeWill::ArenaAllocator::~ArenaAllocator()
+{
+    release();
+}
+
+void *FreeWill::ArenaAllocator::allocate(size_t sizeInByte)
+{
+    size_t size = alignedSize(std::max(sizeInByte, (size_t) 1));
+    size_t offset = m_offset.fetch_add(size, std::memory_order_relaxed);
+
+    if (offset + size <= m_capacity)
+    {
+        return m_slab + offset;
+    }
+
+    return PoolAllocator::getSingleton().allocate(sizeInByte);
+}
+
+void FreeWill::ArenaAllocator::deallocate(void *pointer, size_t sizeInByte)
+{
+    if (owns(pointer))
+    {
+        return;
+    }
+
+    PoolAllocator::getSingleton().deallocate(pointer, sizeInByte);
+}
+
+void FreeWill::ArenaAllocator::release()
+{
+    std::free(m_slab);
+    m_slab = nullptr;
+    m_capacity = 0;
+    m_offset.store(0, std::memory_order_relaxed);
+}
+
+FreeWill::MappedFileAllocator::MappedFileAllocator(const std::string &path, size_t offset, Mapping mapping)
+    :m_path(path),
+      m_offset(offset),
+      m_mapping(mapping)
+{}
+
+void *FreeWill::MappedFileAllocator::allocate(size_t sizeInByte)
+{
+    if (m_offset % ALIGNMENT)
+    {
+        std::cerr << "mapping " << m_path << " at an unaligned offset " << m_offset << std::endl;
+        return nullptr;
+    }
+
+    bool isShared = m_mapping == Mapping::SHARED;
+    int file = open(m_path.c_str(), isShared ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+
+    if (file < 0)
+    {
+        std::cerr << "can't open " << m_path << std::endl;
+        return nullptr;
+    }
+
+    struct stat fileStatus;
+    size_t end = m_offset + sizeInByte;
+
+    if (fstat(file, &fileStatus) != 0
+            || ((size_t) fileStatus.st_size < end && (!isShared || ftruncate(file, end) != 0)))
+    {
+        std::cerr << m_path << " is smaller than " << end << " bytes" << std::endl;
+        close(file);
+        return nullptr;
+    }
+
+    //mmap wants a page aligned offset, the block starts somewhere in the first page
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t pageOffset = m_offset % pageSize;
+
+    //a private mapping of a read only file can still be written, the pages are copied
+    void *mapping = mmap(nullptr, pageOffset + std::max(sizeInByte, (size_t) 1), PROT_READ | PROT_WRITE,
+                         isShared ? MAP_SHARED : (MAP_PRIVATE | MAP_NORESERVE), file, m_offset - pageOffset);
+
+    //the mapping holds its own reference to the file
+    close(file);
+
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "can't map " << m_path << std::endl;
+        return nullptr;
+    }
+
+    return static_cast<unsigned char*>(mapping) + pageOffset;
+}
+
+void FreeWill::MappedFileAllocator::deallocate(void *pointer, size_t sizeInByte)
+{
+    if (!pointer)
+    {
+        return;
+    }
+
+    size_t pageOffset = reinterpret_cast<uintptr_t>(pointer) % sysconf(_SC_PAGESIZE);
+
+    munmap(static_cast<unsigned char*>(pointer) - pageOffset, pageOffset + std::max(sizeInByte, (size_t) 1));
+}
+
+FreeWill::SliceAllocator::SliceAllocator(unsigned char *slice, size_t sizeInByte)
+    :m_slice(slice),
+      m_sizeInByte(sizeInByte)
+{}
+
+void *FreeWill::SliceAllocator::allocate(size_t sizeInByte)
+{
+    return sizeInByte <= m_sizeInByte ? m_slice : nullptr;
+}
+
+void FreeWill::SliceAllocator::deallocate(void *pointer, size_t sizeInByte)
+{
+    (void) pointer;
+    (void) sizeInByte;
+}
@@ -0,0 +1,199 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <string>
+
+namespace FreeWill
+{
+    // Where ReferenceCountedBlob gets its host memory from. Every block is
+    // aligned to ALIGNMENT, which covers a cache line and an AVX-512 register.
+    // A blob remembers the allocator it came from and gives the block back to
+    // it, so the default can be swapped while older blobs are still alive.
+    class Allocator
+    {
+    private:
+        static std::atomic<Allocator*> m_defaultAllocator;
+
+    public:
+        static const size_t ALIGNMENT = 64;
+
+        virtual ~Allocator();
+
+        virtual void *allocate(size_t sizeInByte) = 0;
+
+        //sizeInByte is the size the block was allocated with
+        virtual void deallocate(void *pointer, size_t sizeInByte) = 0;
+
+        //blocks come with meaningful contents, a blob must not zero them
+        virtual bool preservesContents() const
+        {
+            return false;
+        }
+
+        static size_t alignedSize(size_t sizeInByte)
+        {
+            return (sizeInByte + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        }
+
+        static Allocator *defaultAllocator();
+
+        //nullptr goes back to the pool
+        static void setDefaultAllocator(Allocator *allocator);
+    };
+
+    // The default allocator. Sizes are rounded up to a size class, four classes
+    // per power of two, and freed blocks wait on a per class free list for the
+    // next request of that class, e.g. the tensors of the next Model. At most
+    // maxCachedBytes() wait there, blocks freed beyond that go straight back
+    // to the system, and trim() empties the cache.
+    class PoolAllocator : public Allocator
+    {
+    private:
+        std::mutex m_mutex;
+        std::map<size_t, std::vector<void*>> m_freeBlocks;
+        size_t m_cachedBytes;
+        size_t m_maxCachedBytes;
+
+        PoolAllocator();
+
+    public:
+        PoolAllocator(const PoolAllocator &) = delete;
+        PoolAllocator &operator=(const PoolAllocator &) = delete;
+
+        ~PoolAllocator();
+
+        static PoolAllocator &getSingleton();
+
+        static size_t sizeClass(size_t sizeInByte);
+
+        void *allocate(size_t sizeInByte) override;
+
+        void deallocate(void *pointer, size_t sizeInByte) override;
+
+        //hands every cached block back to the system
+        void trim();
+
+        size_t cachedBytes();
+
+        //a lower limit trims the cache down to it, 256 MB by default
+        void setMaxCachedBytes(size_t maxCachedBytes);
+
+        size_t maxCachedBytes();
+    };
+
+    // Carves blocks out of one slab reserved up front. Freeing a single block
+    // does nothing, the whole slab goes in one release(). Requests that don't
+    // fit anymore are served by the pool.
+    class ArenaAllocator : public Allocator
+    {
+    private:
+        unsigned char *m_slab;
+        size_t m_capacity;
+        std::atomic<size_t> m_offset;
+
+    public:
+        explicit ArenaAllocator(size_t capacity);
+
+        ArenaAllocator(const ArenaAllocator &) = delete;
+        ArenaAllocator &operator=(const ArenaAllocator &) = delete;
+
+        ~ArenaAllocator();
+
+        void *allocate(size_t sizeInByte) override;
+
+        void deallocate(void *pointer, size_t sizeInByte) override;
+
+        //every block carved from the slab is invalid afterwards
+        void release();
+
+        bool owns(const void *pointer) const
+        {
+            return m_slab && pointer >= m_slab && pointer < m_slab + m_capacity;
+        }
+
+        size_t capacity() const
+        {
+            return m_capacity;
+        }
+
+        size_t used() const
+        {
+            return std::min(m_offset.load(std::memory_order_relaxed), m_capacity);
+        }
+    };
+
+    // Maps tensors straight from a file instead of allocating them. Pages are
+    // faulted in on first access, so loading is immediate, read-only pages are
+    // shared with every other process mapping the file through the page cache,
+    // and a tensor may be larger than RAM.
+    //
+    // PRIVATE mappings are copy on write, the file is never modified and every
+    // block gets its own changes. SHARED mappings write through to the file,
+    // which grows to fit, and every block of the same range sees the same data.
+    // The offset has to be a multiple of ALIGNMENT.
+    class MappedFileAllocator : public Allocator
+    {
+    public:
+        enum class Mapping
+        {
+            PRIVATE,
+            SHARED
+        };
+
+    private:
+        std::string m_path;
+        size_t m_offset;
+        Mapping m_mapping;
+
+    public:
+        MappedFileAllocator(const std::string &path, size_t offset = 0, Mapping mapping = Mapping::PRIVATE);
+
+        void *allocate(size_t sizeInByte) override;
+
+        void deallocate(void *pointer, size_t sizeInByte) override;
+
+        bool preservesContents() const override
+        {
+            return true;
+        }
+
+        const std::string &path() const
+        {
+            return m_path;
+        }
+
+        size_t offset() const
+        {
+            return m_offset;
+        }
+
+        Mapping mapping() const
+        {
+            return m_mapping;
+        }
+    };
+
+    // Hands out one fixed slice of a buffer it doesn't own, e.g. a tensor's
+    // place in a memory plan. Slices of different tensors may overlap.
+    class SliceAllocator : public Allocator
+    {
+    private:
+        unsigned char *m_slice;
+        size_t m_sizeInByte;
+
+    public:
+        SliceAllocator(unsigned char *slice, size_t sizeInByte);
+
+        void *allocate(size_t sizeInByte) override;
+
+        void deallocate(void *pointer, size_t sizeInByte) override;
+    };
+}
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef HALFPRECISION_H
+#define HALFPRECISION_H
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace FreeWill
+{
+    // 16 bit storage formats. They only hold data, everything else goes
+    // through float, so a kernel loads them, computes in its AccumulatorType
+    // and rounds once when it stores a result. Half the bytes of float means
+    // half the memory traffic, which is what bounds the fully connected layers.
+
+    // The upper half of a float: float's range with an 8 bit mantissa.
+    class BFloat16
+    {
+    private:
+        uint16_t m_bits;
+
+    public:
+        BFloat16() = default;
+
+        BFloat16(float value)
+            :m_bits(fromFloat(value))
+        {}
+
+        operator float() const
+        {
+            return toFloat(m_bits);
+        }
+
+        BFloat16 &operator+=(float value)
+        {
+            return *this = (float) *this + value;
+        }
+
+        BFloat16 &operator-=(float value)
+        {
+            return *this = (float) *this - value;
+        }
+
+        BFloat16 &operator*=(float value)
+        {
+            return *this = (float) *this * value;
+        }
+
+        BFloat16 &operator/=(float value)
+        {
+            return *this = (float) *this / value;
+        }
+
+        uint16_t bits() const
+        {
+            return m_bits;
+        }
+
+        //rounds to nearest even, a NaN stays a NaN
+        static uint16_t fromFloat(float value)
+        {
+            uint32_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            if ((bits & 0x7fffffff) > 0x7f800000)
+            {
+                return (uint16_t) ((bits >> 16) | 0x40);
+            }
+
+            return (uint16_t) ((bits + 0x7fff + ((bits >> 16) & 1)) >> 16);
+        }
+
+        static float toFloat(uint16_t bits)
+        {
+            uint32_t floatBits = ((uint32_t) bits) << 16;
+            float value = 0.0f;
+            std::memcpy(&value, &floatBits, sizeof(value));
+            return value;
+        }
+    };
+
+    // IEEE 754 binary16: 10 bit mantissa, but nothing above 65504.
+    class Float16
+    {
+    private:
+        uint16_t m_bits;
+
+    public:
+        Float16() = default;
+
+        Float16(float value)
+            :m_bits(fromFloat(value))
+        {}
+
+        operator float() const
+        {
+            return toFloat(m_bits);
+        }
+
+        Float16 &operator+=(float value)
+        {
+            return *this = (float) *this + value;
+        }
+
+        Float16 &operator-=(float value)
+        {
+            return *this = (float) *this - value;
+        }
+
+        Float16 &operator*=(float value)
+        {
+            return *this = (float) *this * value;
+        }
+
+        Float16 &operator/=(float value)
+        {
+            return *this = (float) *this / value;
+        }
+
+        uint16_t bits() const
+        {
+            return m_bits;
+        }
+
+        //rounds to nearest even, too large becomes infinity
+        static uint16_t fromFloat(float value)
+        {
+            uint32_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            uint16_t sign = (uint16_t) ((bits >> 16) & 0x8000);
+            uint32_t magnitude = bits & 0x7fffffff;
+
+            if (magnitude > 0x7f800000)
+            {
+                return sign | 0x7e00;
+            }
+
+            //65520 and up round to infinity
+            if (magnitude >= 0x477ff000)
+            {
+                return sign | 0x7c00;
+            }
+
+            //below 2^-14 the result is subnormal, a multiple of 2^-24
+            if (magnitude < 0x38800000)
+            {
+                float absolute = 0.0f;
+                std::memcpy(&absolute, &magnitude, sizeof(absolute));
+                return sign | (uint16_t) std::nearbyint(absolute * 16777216.0f);
+            }
+
+            //rebias the exponent from 127 to 15 and drop 13 mantissa bits
+            return sign | (uint16_t) ((magnitude + 0xfff + ((magnitude >> 13) & 1) - 0x38000000) >> 13);
+        }
+
+        static float toFloat(uint16_t bits)
+        {
+            uint32_t sign = ((uint32_t) (bits & 0x8000)) << 16;
+            uint32_t exponent = (bits >> 10) & 0x1f;
+            uint32_t mantissa = bits & 0x3ff;
+            uint32_t floatBits = 0;
+
+            if (exponent == 0)
+            {
+                float value = mantissa * (1.0f / 16777216.0f);
+                return sign ? -value : value;
+            }
+            else if (exponent == 0x1f)
+            {
+                floatBits = sign | 0x7f800000 | (mantissa << 13);
+            }
+            else
+            {
+                floatBits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+            }
+
+            float value = 0.0f;
+            std::memcpy(&value, &floatBits, sizeof(value));
+            return value;
+        }
+    };
+
+    // What a kernel computes and sums in for a storage type.
+    template<typename DataType>
+    struct AccumulatorType
+    {
+        using type = DataType;
+    };
+
+    template<>
+    struct AccumulatorType<BFloat16>
+    {
+        using type = float;
+    };
+
+    template<>
+    struct AccumulatorType<Float16>
+    {
+        using type = float;
+    };
+
+    //e.g. float data from a loader into a 16 bit input tensor, or back
+    template<typename SourceType, typename DestinationType>
+    void convertData(const SourceType *source, DestinationType *destination, unsigned int count)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            destination[i] = (DestinationType) (typename AccumulatorType<SourceType>::type) source[i];
+        }
+    }
+}
+
+#endif
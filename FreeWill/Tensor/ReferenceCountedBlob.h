@@ -6,6 +6,8 @@
 #include <algorithm>
 #include <random>
 #include <cstdio>
+#include <atomic>
+#include "Allocator.h"
 
 #include <cuda_runtime.h>
 #include <cstdint>
@@ -23,20 +25,32 @@ namespace FreeWill
     template <DeviceType DeviceUsed>
     class TensorBase;
 
+    // Shared by every blob holding the same data, which may live on different
+    // worker threads.
     class ReferenceCounter
     {
     private:
-        unsigned int counter;
+        std::atomic<unsigned int> counter;
 
     public:
+        ReferenceCounter()
+            :counter(0)
+        {}
+
         unsigned int increase()
         {
-            return ++ counter;
+            return counter.fetch_add(1, std::memory_order_relaxed) + 1;
         }
 
+        //acq_rel, so whoever drops the last reference sees every write to the data
         int decrease()
         {
-            return -- counter;
+            return counter.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        }
+
+        unsigned int count() const
+        {
+            return counter.load(std::memory_order_relaxed);
         }
     };
 
@@ -48,19 +62,28 @@ namespace FreeWill
         unsigned int m_sizeInByte;
         ReferenceCounter *m_referenceCounter;
         unsigned char *m_dataHandle;
+        Allocator *m_allocator;
 
         void *m_gpuDataHandle;
 
+        //a view starts m_offsetInByte into a block of m_blockSizeInByte
+        unsigned int m_offsetInByte;
+        unsigned int m_blockSizeInByte;
+
+        //a moved from blob has no counter
         void cleanup()
         {
-            if (m_referenceCounter->decrease() == 0)
+            if (m_referenceCounter && m_referenceCounter->decrease() == 0)
             {
-                free(m_dataHandle);
+                if (m_dataHandle)
+                {
+                    m_allocator->deallocate(m_dataHandle - m_offsetInByte, m_blockSizeInByte);
+                }
                 if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
                 {
                     if (m_gpuDataHandle)
                     {
-                        RUN_CUDA(cudaFree(m_gpuDataHandle))
+                        RUN_CUDA(cudaFree((unsigned char *) m_gpuDataHandle - m_offsetInByte))
                     }
                 }
                 delete m_referenceCounter;
@@ -69,6 +92,8 @@ namespace FreeWill
             m_referenceCounter = nullptr;
             m_dataHandle = nullptr;
             m_sizeInByte = 0;
+            m_offsetInByte = 0;
+            m_blockSizeInByte = 0;
         }
 
     public:
@@ -76,7 +101,10 @@ namespace FreeWill
             :m_sizeInByte(0),
             m_referenceCounter(nullptr),
             m_dataHandle(nullptr),
-            m_gpuDataHandle(nullptr)
+            m_allocator(nullptr),
+            m_gpuDataHandle(nullptr),
+            m_offsetInByte(0),
+            m_blockSizeInByte(0)
         {
             m_referenceCounter = new ReferenceCounter();
             m_referenceCounter->increase();
@@ -86,14 +114,20 @@ namespace FreeWill
             :m_sizeInByte(0),
             m_referenceCounter(nullptr),
             m_dataHandle(nullptr),
-            m_gpuDataHandle(nullptr)
+            m_allocator(nullptr),
+            m_gpuDataHandle(nullptr),
+            m_offsetInByte(0),
+            m_blockSizeInByte(0)
         {
             if (blob.m_dataHandle) 
             {
                 m_referenceCounter = blob.m_referenceCounter;
                 m_sizeInByte = blob.m_sizeInByte;
                 m_dataHandle = blob.m_dataHandle;
+                m_allocator = blob.m_allocator;
                 m_gpuDataHandle = blob.m_gpuDataHandle;
+                m_offsetInByte = blob.m_offsetInByte;
+                m_blockSizeInByte = blob.m_blockSizeInByte;
                 m_referenceCounter->increase();
             }
             else
@@ -103,6 +137,24 @@ namespace FreeWill
             }
         }
 
+        //takes over the data and the reference, the source is left empty
+        ReferenceCountedBlob(ReferenceCountedBlob<DeviceUsed> &&blob)
+            :m_sizeInByte(blob.m_sizeInByte),
+            m_referenceCounter(blob.m_referenceCounter),
+            m_dataHandle(blob.m_dataHandle),
+            m_allocator(blob.m_allocator),
+            m_gpuDataHandle(blob.m_gpuDataHandle),
+            m_offsetInByte(blob.m_offsetInByte),
+            m_blockSizeInByte(blob.m_blockSizeInByte)
+        {
+            blob.m_sizeInByte = 0;
+            blob.m_referenceCounter = nullptr;
+            blob.m_dataHandle = nullptr;
+            blob.m_gpuDataHandle = nullptr;
+            blob.m_offsetInByte = 0;
+            blob.m_blockSizeInByte = 0;
+        }
+
         void clear()
         {
             std::memset(m_dataHandle, 0, m_sizeInByte);
@@ -123,17 +175,31 @@ namespace FreeWill
             return m_gpuDataHandle;
         }
 
-        bool alloc(unsigned int sizeInByte)
+        //nullptr takes the default allocator
+        bool alloc(unsigned int sizeInByte, Allocator *allocator = nullptr)
         {
+            m_allocator = allocator ? allocator : Allocator::defaultAllocator();
+
+            if (!m_referenceCounter)
+            {
+                m_referenceCounter = new ReferenceCounter();
+                m_referenceCounter->increase();
+            }
+
             if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
             {
-                m_dataHandle = (unsigned char *) malloc(sizeInByte);
+                m_dataHandle = (unsigned char *) m_allocator->allocate(sizeInByte);
                 if (m_dataHandle) 
                 {
                     m_sizeInByte = sizeInByte;
+                    m_offsetInByte = 0;
+                    m_blockSizeInByte = sizeInByte;
 
                     //printf("memset: %d\n", sizeInByte);
-                    std::memset(m_dataHandle,0,  sizeInByte);
+                    if (!m_allocator->preservesContents())
+                    {
+                        std::memset(m_dataHandle,0,  sizeInByte);
+                    }
 
                     //printf("memset result: %d, %d, %d, %d, %d\n", m_dataHandle[0], m_dataHandle[1], m_dataHandle[2], m_dataHandle[3], m_dataHandle[4]);
                     return true;
@@ -146,13 +212,22 @@ namespace FreeWill
             else if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
             {
                 RUN_CUDA(cudaMalloc(&m_gpuDataHandle, sizeInByte));
-                m_dataHandle = (unsigned char *) malloc(sizeInByte);
+                m_dataHandle = (unsigned char *) m_allocator->allocate(sizeInByte);
                 if (m_gpuDataHandle && m_dataHandle)
                 {
                     m_sizeInByte = sizeInByte;
+                    m_offsetInByte = 0;
+                    m_blockSizeInByte = sizeInByte;
                     
-                    RUN_CUDA(cudaMemset(m_gpuDataHandle, 0, sizeInByte));
-                    std::memset(m_dataHandle, 0, sizeInByte);
+                    if (m_allocator->preservesContents())
+                    {
+                        RUN_CUDA(cudaMemcpy(m_gpuDataHandle, m_dataHandle, sizeInByte, cudaMemcpyHostToDevice));
+                    }
+                    else
+                    {
+                        RUN_CUDA(cudaMemset(m_gpuDataHandle, 0, sizeInByte));
+                        std::memset(m_dataHandle, 0, sizeInByte);
+                    }
                     return true;
                 }
                 else
@@ -164,7 +239,7 @@ namespace FreeWill
                     }
                     if (m_dataHandle)
                     {
-                        std::free(m_dataHandle);
+                        m_allocator->deallocate(m_dataHandle, sizeInByte);
                         m_dataHandle = nullptr;
                     }
                     return false;
@@ -206,6 +281,11 @@ namespace FreeWill
 
         void operator=(const ReferenceCountedBlob<DeviceUsed> &blob)
         {
+            if (m_referenceCounter && m_referenceCounter == blob.m_referenceCounter)
+            {
+                return;
+            }
+
             if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
             {
                 if (blob.m_dataHandle)
@@ -215,6 +295,9 @@ namespace FreeWill
                     m_referenceCounter->increase();
                     m_sizeInByte = blob.m_sizeInByte;
                     m_dataHandle = blob.m_dataHandle;
+                    m_allocator = blob.m_allocator;
+                    m_offsetInByte = blob.m_offsetInByte;
+                    m_blockSizeInByte = blob.m_blockSizeInByte;
                 }
             }
             else if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
@@ -226,11 +309,87 @@ namespace FreeWill
                     m_referenceCounter->increase();
                     m_sizeInByte = blob.m_sizeInByte;
                     m_dataHandle = blob.m_dataHandle;
+                    m_allocator = blob.m_allocator;
                     m_gpuDataHandle = blob.m_gpuDataHandle;
+                    m_offsetInByte = blob.m_offsetInByte;
+                    m_blockSizeInByte = blob.m_blockSizeInByte;
                 }
             }
         }
 
+        //an empty source releases this blob's data, so a tensor moved from an
+        //uninitialized one never keeps data sized for its old shape
+        void operator=(ReferenceCountedBlob<DeviceUsed> &&blob)
+        {
+            bool hasData = false;
+
+            if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
+            {
+                hasData = blob.m_dataHandle != nullptr;
+            }
+            else if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
+            {
+                hasData = blob.m_gpuDataHandle != nullptr;
+            }
+
+            if (this == &blob)
+            {
+                return;
+            }
+
+            cleanup();
+            m_gpuDataHandle = nullptr;
+
+            if (!hasData)
+            {
+                return;
+            }
+
+            m_referenceCounter = blob.m_referenceCounter;
+            m_sizeInByte = blob.m_sizeInByte;
+            m_dataHandle = blob.m_dataHandle;
+            m_allocator = blob.m_allocator;
+            m_gpuDataHandle = blob.m_gpuDataHandle;
+            m_offsetInByte = blob.m_offsetInByte;
+            m_blockSizeInByte = blob.m_blockSizeInByte;
+
+            blob.m_sizeInByte = 0;
+            blob.m_referenceCounter = nullptr;
+            blob.m_dataHandle = nullptr;
+            blob.m_gpuDataHandle = nullptr;
+            blob.m_offsetInByte = 0;
+            blob.m_blockSizeInByte = 0;
+        }
+
+        //shares the data and the reference of this blob, sizeInByte bytes from
+        //offsetInByte on. the block lives as long as any blob or view holds it.
+        //a range outside this blob gives an empty blob
+        ReferenceCountedBlob<DeviceUsed> view(unsigned int offsetInByte, unsigned int sizeInByte) const
+        {
+            if (!m_dataHandle || offsetInByte > m_sizeInByte || sizeInByte > m_sizeInByte - offsetInByte)
+            {
+                return ReferenceCountedBlob<DeviceUsed>();
+            }
+
+            ReferenceCountedBlob<DeviceUsed> view(*this);
+            view.m_dataHandle += offsetInByte;
+
+            if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
+            {
+                view.m_gpuDataHandle = (unsigned char *) m_gpuDataHandle + offsetInByte;
+            }
+
+            view.m_offsetInByte += offsetInByte;
+            view.m_sizeInByte = sizeInByte;
+
+            return view;
+        }
+
+        bool isView() const
+        {
+            return m_dataHandle && (m_offsetInByte || m_sizeInByte != m_blockSizeInByte);
+        }
+
         bool operator==(const ReferenceCountedBlob<DeviceUsed> &blob) const 
         {
             if constexpr (DeviceUsed == DeviceType::CPU_NAIVE)
@@ -272,6 +431,11 @@ namespace FreeWill
         {
             return m_sizeInByte;
         }
+
+        unsigned int referenceCount() const
+        {
+            return m_referenceCounter ? m_referenceCounter->count() : 0;
+        }
         
         ~ReferenceCountedBlob()
         {
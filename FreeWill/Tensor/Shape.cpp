@@ -5,14 +5,21 @@ namespace FreeWill
 {
 	Shape operator+(const Shape &in, unsigned int batchSize)
     {
-        if (batchSize > 0)
+        if (batchSize > 0 && in.dimension() == Shape::MAX_DIMENSION)
         {
-            Shape shape;
+            //no room for the batch, an invalid shape makes init() fail instead
+            //of silently dropping it
+            return Shape(Shape::MAX_DIMENSION + 1);
+        }
+
+        if (batchSize > 0 && in.isValid())
+        {
+            Shape shape = in;
 
-            shape.m_dim = new unsigned int[in.dimension() + 1];
-            std::copy(in.m_dim, in.m_dim + in.dimension(), shape.m_dim);
-            shape.m_dim[in.dimension()] = batchSize;
-            shape.m_count = in.dimension() + 1;
+            shape.m_dim[shape.m_count] = batchSize;
+            shape.m_count++;
+            shape.m_size = in.size() * batchSize;
+            shape.m_isSizeValid = true;
 
             return shape;
         }
@@ -8,90 +8,111 @@
 
 namespace FreeWill
 {
+    // Up to MAX_DIMENSION dimensions stored inline, so shapes are copied without
+    // touching the heap. The element count is computed when the shape changes
+    // instead of on every size() call. Writing through the non-const
+    // operator[] marks it stale. A shape asked to hold more dimensions is
+    // invalid, it has no dimensions and size 0, so tensor init() rejects it.
     class Shape
     {
+    public:
+        static constexpr unsigned int MAX_DIMENSION = 8;
+
     private:
-        unsigned int *m_dim;
+        unsigned int m_dim[MAX_DIMENSION];
         unsigned int m_count;
+        mutable unsigned int m_size;
+        mutable bool m_isSizeValid;
+        bool m_isValid;
 
-    public:
-        Shape(unsigned int dimension = 0)
-            :m_dim(nullptr),
-            m_count(dimension)
+        constexpr void assign(const unsigned int *in, unsigned int count)
         {
-            if (m_count)
+            m_isValid = count <= MAX_DIMENSION;
+            m_count = m_isValid ? count : 0;
+
+            //mutable members can be written but not read in a constant expression
+            unsigned int size = m_isValid ? 1 : 0;
+
+            for(unsigned int i = 0; i < m_count; ++i)
             {
-                m_dim = new unsigned int[m_count];
+                m_dim[i] = in[i];
+                size *= in[i];
             }
+
+            for(unsigned int i = m_count; i < MAX_DIMENSION; ++i)
+            {
+                m_dim[i] = 0;
+            }
+
+            m_size = size;
+            m_isSizeValid = true;
         }
 
-        Shape(const Shape &shape)
-            :m_dim(nullptr),
-            m_count(0)
+    public:
+        constexpr Shape(unsigned int dimension = 0)
+            :m_dim{},
+            m_count(dimension <= MAX_DIMENSION ? dimension : 0),
+            m_size((m_count || dimension > MAX_DIMENSION) ? 0 : 1),
+            m_isSizeValid(true),
+            m_isValid(dimension <= MAX_DIMENSION)
         {
-            *this = shape;
         }
 
-        Shape(const unsigned int *in, unsigned int count)
-            :m_dim(nullptr),
-            m_count(0)
+        constexpr Shape(const unsigned int *in, unsigned int count)
+            :m_dim{},
+            m_count(0),
+            m_size(1),
+            m_isSizeValid(true),
+            m_isValid(true)
         {
-            delete [] m_dim;
-            m_dim = new unsigned int [count];
-            m_count = count;
-
-            for(unsigned int i = 0; i < count; ++i)
-            {
-                m_dim[i] = in[i];
-            }
+            assign(in, count);
         }
 
-        Shape(const std::initializer_list<unsigned int> &li)
-            :m_dim(nullptr),
-             m_count(0)
+        constexpr Shape(const std::initializer_list<unsigned int> &li)
+            :m_dim{},
+            m_count(0),
+            m_size(1),
+            m_isSizeValid(true),
+            m_isValid(true)
         {
-            *this = li;
+            assign(li.begin(), li.size());
         }
 
         unsigned int size() const 
         {
-            unsigned int size = 1;
-
-            for(unsigned int i = 0; i < m_count; ++i)
+            if (!m_isSizeValid)
             {
-                size *= m_dim[i];
+                m_size = m_isValid ? 1 : 0;
+
+                for(unsigned int i = 0; i < m_count; ++i)
+                {
+                    m_size *= m_dim[i];
+                }
+
+                m_isSizeValid = true;
             }
-            return size;
+
+            return m_size;
         }
 
-        unsigned int dimension() const
+        constexpr unsigned int dimension() const
         {
             return m_count;
         }
 
-        void operator=(const Shape &shape)
+        constexpr bool isValid() const
         {
-            delete [] m_dim;
-            m_dim = new unsigned int[shape.m_count];
-            m_count = shape.m_count;
-
-            for(unsigned int i = 0; i < m_count; ++i)
-            {
-                m_dim[i] = shape.m_dim[i];
-            }
+            return m_isValid;
         }
 
         void operator=(const std::initializer_list<unsigned int> &li)
         {
-            delete [] m_dim;
-            m_dim = new unsigned int[li.size()];
-            m_count = li.size();
-            std::copy(li.begin(), li.begin() + m_count, m_dim);
+            assign(li.begin(), li.size());
         }
 
         bool operator==(const Shape &shape) const 
         {
-            if (m_count != shape.m_count)
+            if (m_count != shape.m_count || m_isValid != shape.m_isValid)
             {
                 return false;
             }
@@ -112,20 +133,15 @@ namespace FreeWill
 
         unsigned int &operator[](unsigned int i)
         {
+            m_isSizeValid = false;
             return m_dim[i];
         }
 
-        unsigned int operator[](unsigned int i) const
+        constexpr unsigned int operator[](unsigned int i) const
         {
             return m_dim[i];
         }
 
-        ~Shape()
-        {
-            delete [] m_dim;
-            m_count = 0;
-        }
-
         friend
         Shape operator+(const Shape &in, unsigned int batchSize);
 
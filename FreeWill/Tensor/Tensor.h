@@ -7,6 +7,7 @@
 #include "DeviceSelection.h"
 #include "Shape.h"
 #include "ReferenceCountedBlob.h"
+#include "HalfPrecision.h"
 #include <ctime>
 #include <cuda.h>
 #include <cudnn.h>
@@ -44,6 +45,15 @@ namespace FreeWill
            RUN_CUDNN(cudnnCreateTensorDescriptor(&m_gpuTensorDescriptor));
        }
 
+       //the gpu descriptor is not moved, every tensor keeps its own
+       TensorBase(ReferenceCountedBlob<DeviceUsed> &&data, const Shape &shape = Shape())
+           :m_shape(shape),
+               m_gpuTensorDescriptor(0),
+               m_data(std::move(data))
+       {
+           RUN_CUDNN(cudnnCreateTensorDescriptor(&m_gpuTensorDescriptor));
+       }
+
     public:
        void *gpuDataHandle()
        {
@@ -132,13 +142,66 @@ namespace FreeWill
         {
         }
 
-        bool init()
+        Tensor(Tensor &&in)
+            :TensorBase<DeviceUsed>(std::move(in.m_data), in.shape()),
+            m_name(std::move(in.m_name))
+        {
+            updateGPUTensorDescriptor();
+        }
+
+    private:
+        Tensor(ReferenceCountedBlob<DeviceUsed> &&data, const Shape &shape, const std::string &name)
+            :TensorBase<DeviceUsed>(std::move(data), shape),
+            m_name(name)
+        {
+            updateGPUTensorDescriptor();
+        }
+
+    public:
+        //a tensor of the given shape over this one's data, starting offset
+        //elements in. nothing is copied, writes through the view show up here
+        //and either tensor keeps the data alive. the view is empty if it
+        //doesn't fit
+        Tensor<DeviceUsed, DataType> view(unsigned int offset, const Shape &shape, const std::string &name = "no_name") const
+        {
+            if (!m_data.sizeInByte() || offset > m_shape.size() || shape.size() > m_shape.size() - offset)
+            {
+                return Tensor<DeviceUsed, DataType>(shape, name);
+            }
+
+            return Tensor<DeviceUsed, DataType>(m_data.view(offset * sizeof(DataType), shape.size() * sizeof(DataType)), shape, name);
+        }
+
+        //the samples [begin, end) of the last dimension. the batch is the slowest
+        //varying dimension, so a sub batch is always one contiguous view
+        Tensor<DeviceUsed, DataType> sliceBatch(unsigned int begin, unsigned int end) const
+        {
+            Shape shape = m_shape;
+            unsigned int dimension = shape.dimension();
+
+            if (!dimension || begin > end || end > shape[dimension - 1])
+            {
+                return Tensor<DeviceUsed, DataType>(Shape(), m_name);
+            }
+
+            unsigned int sampleSize = m_shape.size() / shape[dimension - 1];
+            shape[dimension - 1] = end - begin;
+
+            return view(begin * sampleSize, shape, m_name);
+        }
+
+        bool isView() const
+        {
+            return m_data.isView();
+        }
+
+        bool init(Allocator *allocator = nullptr)
 	    {
             unsigned int size = m_shape.size();
             bool result = false;
             if (size) 
             {
-                result = m_data.alloc(size * sizeof(DataType));
+                result = m_data.alloc(size * sizeof(DataType), allocator);
             }
 
             if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
@@ -176,7 +239,7 @@ namespace FreeWill
                  
            for (unsigned int n = 0; n < size; ++n) 
            {
-                bits[n] = RandomNumberGenerator::getSingleton().getRandom<DataType>();
+                bits[n] = RandomNumberGenerator::getSingleton().getRandom<typename AccumulatorType<DataType>::type>();
            }
  
             if constexpr (DeviceUsed == DeviceType::GPU_CUDA)
@@ -193,6 +256,14 @@ namespace FreeWill
             updateGPUTensorDescriptor();
         }
 
+        void operator=(Tensor<DeviceUsed, DataType> &&in)
+        {
+            m_shape = in.m_shape;
+            m_name = std::move(in.m_name);
+            m_data = std::move(in.m_data);
+            updateGPUTensorDescriptor();
+        }
+
         DataType &operator[](unsigned int i)
         {
             DataType *bits = (DataType *) m_data.dataHandle();
@@ -242,6 +313,14 @@ namespace FreeWill
                 {
                     dataType = CUDNN_DATA_DOUBLE;
                 }
+                else if constexpr (std::is_same<DataType,Float16>::value)
+                {
+                    dataType = CUDNN_DATA_HALF;
+                }
+                else if constexpr (std::is_same<DataType,int8_t>::value)
+                {
+                    dataType = CUDNN_DATA_INT8;
+                }
 
                 int nbDims = m_shape.dimension();
                 int atLeastDims = nbDims < 4 ? 4 : nbDims;